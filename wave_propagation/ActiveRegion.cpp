@@ -0,0 +1,115 @@
+#include "ActiveRegion.h"
+
+ActiveRegion::ActiveRegion(const RunParams& params, int W, int H, bool is2D, bool periodic, int source_idx)
+    : W_(W), H_(H), is2D_(is2D), periodic_(periodic),
+      chunk_(params.chunk > 0 ? params.chunk : 1), tol_(params.active_tol),
+      act_(H), dirty_(H), grow_(H), new_(H)
+{
+    if (source_idx >= 0 && source_idx < W*H){
+        src_x_ = source_idx % W;
+        src_y_ = source_idx / W;
+    }
+}
+
+ActiveRegion::Span ActiveRegion::dilate(int y) const{
+    Span s = act_[y];
+    if (!s.empty()){ s.lo -= 1; s.hi += 1; }
+    if (H_ > 1){
+        // vecinos de arriba y abajo (con bordes periodicos, la fila del otro extremo)
+        const int up = y-1 >= 0 ? y-1 : (periodic_ ? H_-1 : -1);
+        const int dn = y+1 < H_ ? y+1 : (periodic_ ? 0 : -1);
+        if (up >= 0) s = hull(s, act_[up]);
+        if (dn >= 0) s = hull(s, act_[dn]);
+    }
+    if (!s.empty() && (s.lo < 0 || s.hi > W_)){
+        // con bordes periodicos el frente da la vuelta: la fila entera
+        if (periodic_) s = Span{0, W_};
+        else s = Span{std::max(s.lo, 0), std::min(s.hi, W_)};
+    }
+    return s;
+}
+
+void ActiveRegion::plan(const SourceTerm& src, int nth){
+    // fuente extendida (global o por nodo con amplitud != 0): toda la grilla
+    const bool full = src.values || src.uniform != 0.0;
+    units_.clear();
+    for (int y=0; y<H_; ++y){
+        Span g = full ? Span{0, W_} : dilate(y);
+        if (y == src_y_) g = hull(g, Span{src_x_, src_x_ + 1});
+        grow_[y] = g;
+        // lo que quedo de pasos anteriores en next tambien se reescribe (con ceros)
+        const Span h = hull(g, dirty_[y]);
+        if (h.empty()) continue;
+        if (is2D_){
+            const bool edge_row = y == 0 || y == H_-1 || W_ < 3;
+            const int lo = (edge_row || h.lo == 0) ? h.lo : 1 + kAlign*((h.lo - 1)/kAlign);
+            units_.push_back(Unit{y, lo, h.hi, Row});
+            continue;
+        }
+        // 1D: extremos y bloques de chunk nodos del interior, como stencil_sweep
+        const int N = W_;
+        if (h.lo == 0) units_.push_back(Unit{0, 0, 1, Edge0});
+        const int ilo = std::max(h.lo, 1), ihi = std::min(h.hi, N-1);
+        if (ilo < ihi){
+            for (int b=(ilo-1)/chunk_; b<=(ihi-2)/chunk_; ++b){
+                const int bs = 1 + b*chunk_, be = std::min(bs + chunk_, N-1);
+                const int lo = bs + kAlign*((std::max(ilo, bs) - bs)/kAlign);
+                units_.push_back(Unit{b, lo, std::min(ihi, be), Block});
+            }
+        }
+        if (N > 1 && h.hi == N) units_.push_back(Unit{N-1, N-1, N, EdgeN});
+    }
+
+    // reparto por peso: cada unidad va al hilo donde cae su punto medio
+    const int n = (int)units_.size();
+    long long total = 0;
+    for (const Unit& u : units_) total += (u.hi - u.lo) + kAlign;
+    begin_.assign(nth + 1, n);
+    long long cum = 0;
+    int k = 0;
+    for (int t=0; t<nth; ++t){
+        begin_[t] = k;
+        const long long target = total*(t + 1)/nth;
+        while (k < n && 2*cum + (units_[k].hi - units_[k].lo) + kAlign < 2*target){
+            cum += (units_[k].hi - units_[k].lo) + kAlign;
+            ++k;
+        }
+    }
+    unit_e_.assign(n, 0.0);
+    tight_.assign(n, Span{});
+    for (const Unit& u : units_) work_ += u.hi - u.lo;
+    ++steps_;
+}
+
+double ActiveRegion::energy(int nth){
+    // dueno de cada fila/bloque con schedule static (chunk filas en 2D, bloques
+    // de a uno en 1D); los extremos 1D los suma primero el hilo de la single
+    part_.assign(nth, 0.0);
+    for (size_t k=0; k<units_.size(); ++k){
+        if (units_[k].kind == Edge0 || units_[k].kind == EdgeN) part_[0] += unit_e_[k];
+    }
+    for (size_t k=0; k<units_.size(); ++k){
+        const Unit& u = units_[k];
+        if (u.kind == Row) part_[(u.idx / chunk_) % nth] += unit_e_[k];
+        else if (u.kind == Block) part_[u.idx % nth] += unit_e_[k];
+    }
+    double E = 0.0;
+    for (int t=0; t<nth; ++t) E += part_[t];
+    return E;
+}
+
+void ActiveRegion::advance(bool swapped){
+    if (tol_ > 0){
+        for (Span& s : new_) s = Span{};
+        for (size_t k=0; k<units_.size(); ++k){
+            const int y = is2D_ ? units_[k].idx : 0;
+            new_[y] = hull(new_[y], tight_[k]);
+        }
+    } else {
+        new_ = grow_;
+    }
+    // next guarda ahora lo que era current (swap) o lo mismo que current (commit)
+    if (swapped) dirty_.swap(act_);
+    else dirty_ = new_;
+    act_.swap(new_);
+}
@@ -0,0 +1,200 @@
+#pragma once // para que se compile solo una vez
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Stencil.h"
+#include "Types.h"
+
+// Region activa (--active-region, --active-tol): con un impulso en el centro o
+// una fuente puntual casi toda la grilla es exactamente cero durante cientos de
+// pasos, y el frente avanza a lo sumo un nodo por paso. Por cada fila (2D) o
+// para el vector (1D) se guarda el intervalo [lo,hi) que puede ser distinto de
+// cero, y en cada paso solo se actualizan, suman y confirman los nodos del
+// intervalo dilatado un nodo (mas el nodo de la fuente).
+//
+// Modo exacto (tol = 0): fuera del intervalo las amplitudes son cero en los
+// dos buffers y la actualizacion tambien daria cero, asi que el resultado es
+// identico bit a bit a la corrida completa. Para que la energia tambien lo sea:
+//  - cada tramo empieza en 1 + 16k respecto del inicio del tramo interior de la
+//    fila (o del bloque de chunk nodos en 1D): los carriles de energia de los
+//    kernels SIMD (8 en double, 16 en float) ven los mismos valores en el mismo
+//    orden, solo sin los ceros;
+//  - la energia de cada fila o bloque se guarda y al final del paso se suma
+//    como lo haria la corrida completa con schedule static: por hilo dueno de
+//    la fila (y/chunk % hilos) en orden de fila, y luego en orden de hilo.
+//
+// Con tolerancia (tol > 0) cada hilo recorta su tramo recien escrito a los
+// nodos con |a| > tol y pone el resto en cero: la region tambien se achica y
+// sigue la parte significativa del frente (resultado aproximado).
+//
+// El trabajo se reparte por peso (nodos del tramo) en rangos contiguos de
+// filas/bloques por hilo, sin importar --schedule: solo unas pocas filas estan
+// activas al principio y un reparto fijo dejaria hilos sin trabajo.
+class ActiveRegion {
+public:
+    // W x H nodos (1D: W = N, H = 1); source_idx = nodo de la fuente puntual o -1
+    ActiveRegion(const RunParams& params, int W, int H, bool is2D, bool periodic, int source_idx);
+
+    // intervalos iniciales: nodos distintos de cero en cada buffer
+    template <class Real>
+    void init(const Real* cur, const Real* nxt);
+
+    // tramos del paso a partir de la fuente; lo llama un solo hilo
+    void plan(const SourceTerm& src, int nth);
+
+    // actualiza los tramos del hilo tid; hook(i0, i1) = row_hook de Sweep.h
+    template <class Real, class Acc, bool Energy, class Hook>
+    void sweep(Boundary b, const Real* u, Real* out, const StepCoeffs& c, const SourceTerm& src,
+               int tid, const Hook& hook);
+
+    // energia (paso no fusionado) y commit sobre los tramos del hilo tid
+    template <class Real, class Acc>
+    double sumsq(const Real* v, int tid) const;
+    template <class Real>
+    void copy(Real* dst, const Real* src, int tid) const;
+
+    // energia del paso fusionado en el orden de la corrida completa; un solo hilo
+    double energy(int nth);
+    // cierra el paso (swapped: los buffers se intercambiaron); un solo hilo
+    void advance(bool swapped);
+
+    // nodos actualizados / (N * pasos)
+    double fraction() const { return steps_ > 0 ? (double)work_ / ((double)steps_ * W_ * H_) : 0.0; }
+
+private:
+    static constexpr int kAlign = 16;   // carriles de energia (8 en double, 16 en float)
+
+    struct Span {
+        int lo = 0, hi = 0;
+        bool empty() const { return lo >= hi; }
+    };
+    enum UnitKind { Row, Block, Edge0, EdgeN };
+    struct Unit {
+        int idx;        // fila (2D) o bloque de chunk nodos (1D)
+        int lo, hi;     // tramo [lo,hi) dentro de la fila o del vector
+        UnitKind kind;
+    };
+
+    int W_, H_;
+    bool is2D_, periodic_;
+    int chunk_;
+    double tol_;
+    int src_x_ = -1, src_y_ = -1;
+
+    std::vector<Span> act_;     // puede ser != 0 en current
+    std::vector<Span> dirty_;   // puede ser != 0 en next
+    std::vector<Span> grow_;    // act_ dilatado (+ fuente): != 0 tras el paso (modo exacto)
+    std::vector<Span> new_;
+    std::vector<Unit> units_;
+    std::vector<int> begin_;    // units_[begin_[t], begin_[t+1]) son del hilo t
+    std::vector<double> unit_e_;
+    std::vector<Span> tight_;   // tramo con |a| > tol de cada unidad
+    std::vector<double> part_;
+    long long work_ = 0;
+    long steps_ = 0;
+
+    static Span hull(Span a, Span b){
+        if (a.empty()) return b;
+        if (b.empty()) return a;
+        return Span{std::min(a.lo, b.lo), std::max(a.hi, b.hi)};
+    }
+    Span dilate(int y) const;
+
+    template <class Real>
+    static Span nonzero(const Real* row, int n){
+        int lo = 0, hi = n;
+        while (lo < hi && row[lo] == 0) ++lo;
+        while (hi > lo && row[hi-1] == 0) --hi;
+        return Span{lo, hi};
+    }
+    // recorta [lo,hi) de la fila a |a| > tol (el nodo de la fuente se conserva)
+    template <class Real>
+    Span trim(Real* row, int lo, int hi, int y) const;
+
+    template <int Dim, Boundary B, class Real, class Acc, bool Energy, class Hook>
+    void sweep_impl(const Real* u, Real* out, const StepCoeffs& c, const SourceTerm& src,
+                    int tid, const Hook& hook);
+};
+
+template <class Real>
+void ActiveRegion::init(const Real* cur, const Real* nxt){
+    #pragma omp parallel for schedule(static)
+    for (int y=0; y<H_; ++y){
+        act_[y] = nonzero(cur + (size_t)y*W_, W_);
+        dirty_[y] = nonzero(nxt + (size_t)y*W_, W_);
+    }
+}
+
+template <class Real>
+ActiveRegion::Span ActiveRegion::trim(Real* row, int lo, int hi, int y) const{
+    const int keep = (y == src_y_) ? src_x_ : -1;
+    int a = lo, b = hi;
+    while (a < b && a != keep && !(std::fabs((double)row[a]) > tol_)) ++a;
+    while (b > a && b-1 != keep && !(std::fabs((double)row[b-1]) > tol_)) --b;
+    std::fill(row + lo, row + a, Real(0));
+    std::fill(row + b, row + hi, Real(0));
+    return Span{a, b};
+}
+
+template <class Real, class Acc, bool Energy, class Hook>
+void ActiveRegion::sweep(Boundary b, const Real* u, Real* out, const StepCoeffs& c, const SourceTerm& src,
+                         int tid, const Hook& hook)
+{
+    if (is2D_){
+        if (b == Boundary::Periodic) sweep_impl<2, Boundary::Periodic, Real, Acc, Energy>(u, out, c, src, tid, hook);
+        else sweep_impl<2, Boundary::Open, Real, Acc, Energy>(u, out, c, src, tid, hook);
+    } else {
+        if (b == Boundary::Periodic) sweep_impl<1, Boundary::Periodic, Real, Acc, Energy>(u, out, c, src, tid, hook);
+        else sweep_impl<1, Boundary::Open, Real, Acc, Energy>(u, out, c, src, tid, hook);
+    }
+}
+
+template <int Dim, Boundary B, class Real, class Acc, bool Energy, class Hook>
+void ActiveRegion::sweep_impl(const Real* u, Real* out, const StepCoeffs& c, const SourceTerm& src,
+                              int tid, const Hook& hook)
+{
+    using K = Stencil<Dim, B, Real, Acc>;
+    for (int k=begin_[tid]; k<begin_[tid+1]; ++k){
+        const Unit& un = units_[k];
+        double e = 0.0;
+        int base = 0;
+        if constexpr (Dim == 2){
+            base = un.idx*W_;
+            e = K::template row_span<Energy>(u, out, W_, H_, un.idx, un.lo, un.hi, c, src);
+        } else if (un.kind == Block){
+            e = K::template range<Energy>(u, out, un.lo, un.hi, c, src);
+        } else {
+            const Acc v = K::edge(u, out, W_, un.lo, c, src);
+            if constexpr (Energy) e += v*v;
+        }
+        unit_e_[k] = e;
+        if (tol_ > 0) tight_[k] = trim(out + base, un.lo, un.hi, Dim == 2 ? un.idx : 0);
+        hook(base + un.lo, base + un.hi);
+    }
+}
+
+template <class Real, class Acc>
+double ActiveRegion::sumsq(const Real* v, int tid) const{
+    // nodo a nodo y en orden creciente, como el for de la energia no fusionada
+    double s = 0.0;
+    for (int k=begin_[tid]; k<begin_[tid+1]; ++k){
+        const Unit& un = units_[k];
+        const Real* r = v + (is2D_ ? (size_t)un.idx*W_ : 0);
+        for (int i=un.lo; i<un.hi; ++i){
+            const Acc a = r[i];
+            s += a*a;
+        }
+    }
+    return s;
+}
+
+template <class Real>
+void ActiveRegion::copy(Real* dst, const Real* src, int tid) const{
+    for (int k=begin_[tid]; k<begin_[tid+1]; ++k){
+        const Unit& un = units_[k];
+        const size_t base = is2D_ ? (size_t)un.idx*W_ : 0;
+        std::copy(src + base + un.lo, src + base + un.hi, dst + base + un.lo);
+    }
+}
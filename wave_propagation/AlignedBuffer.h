@@ -0,0 +1,72 @@
+#pragma once // para que se compile solo una vez
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Arreglo contiguo alineado a linea de cache (64 bytes) para datos triviales.
+// Se usa para las amplitudes y el bloque CSR: sin punteros por nodo y con
+// direcciones alineadas para que el kernel pueda vectorizar.
+template <class T, std::size_t Align = 64>
+class AlignedBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "AlignedBuffer solo para tipos triviales");
+
+    T* data_ = nullptr;
+    std::size_t n_ = 0;
+
+    static T* allocate(std::size_t n){
+        if (n == 0) return nullptr;
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+    static void release(T* p){
+        if (p) ::operator delete(p, std::align_val_t(Align));
+    }
+
+public:
+    AlignedBuffer() = default;
+    explicit AlignedBuffer(std::size_t n, T v = T()) : data_(allocate(n)), n_(n) {
+        std::fill(data_, data_ + n_, v);
+    }
+    AlignedBuffer(const AlignedBuffer& o) : data_(allocate(o.n_)), n_(o.n_) {
+        std::copy(o.data_, o.data_ + n_, data_);
+    }
+    AlignedBuffer(AlignedBuffer&& o) noexcept : data_(o.data_), n_(o.n_) {
+        o.data_ = nullptr; o.n_ = 0;
+    }
+    AlignedBuffer& operator=(AlignedBuffer o) noexcept { swap(o); return *this; }
+    ~AlignedBuffer(){ release(data_); }
+
+    // n elementos sin inicializar: las paginas no se tocan, asi la primera
+    // escritura (first touch) decide en que nodo NUMA queda cada una
+    static AlignedBuffer uninitialized(std::size_t n){
+        AlignedBuffer b;
+        b.data_ = allocate(n);
+        b.n_ = n;
+        return b;
+    }
+
+    // Reserva n elementos inicializados a v (descarta el contenido previo)
+    void assign(std::size_t n, T v = T()){
+        AlignedBuffer tmp(n, v);
+        swap(tmp);
+    }
+    void clear(){ release(data_); data_ = nullptr; n_ = 0; }
+
+    void swap(AlignedBuffer& o) noexcept {   // intercambio O(1) de punteros
+        std::swap(data_, o.data_);
+        std::swap(n_, o.n_);
+    }
+
+    std::size_t size() const { return n_; }
+    bool empty() const { return n_ == 0; }
+    T* data(){ return data_; }
+    const T* data() const { return data_; }
+    T& operator[](std::size_t i){ return data_[i]; }
+    const T& operator[](std::size_t i) const { return data_[i]; }
+    T* begin(){ return data_; }
+    T* end(){ return data_ + n_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + n_; }
+};
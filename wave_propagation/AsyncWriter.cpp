@@ -0,0 +1,114 @@
+#include "AsyncWriter.h"
+
+AsyncWriter::AsyncWriter(size_t frame_elems, int pool, bool threaded, EnergySink energy, FrameSink frame,
+                         BufferFactory make_buffer)
+    : energy_sink_(std::move(energy)), frame_sink_(std::move(frame)), threaded_(threaded)
+{
+    if (frame_elems > 0){
+        pool_.resize(pool > 0 ? pool : 1);
+        for (size_t k=0; k<pool_.size(); ++k){
+            if (make_buffer) pool_[k] = make_buffer();
+            else pool_[k].assign(frame_elems, 0.0);
+            free_.push_back((int)k);
+        }
+    }
+    batch_.reserve(kEnergyBatch);
+    if (threaded_) th_ = std::thread(&AsyncWriter::loop, this);
+}
+
+AsyncWriter::~AsyncWriter(){
+    finish();
+}
+
+void AsyncWriter::energy(int step, double E){
+    batch_.emplace_back(step, E);
+    if (batch_.size() >= kEnergyBatch){
+        Job j{-1, 0, 0.0, std::move(batch_), false, {}};
+        batch_.clear();
+        batch_.reserve(kEnergyBatch);
+        push(std::move(j));
+    }
+}
+
+int AsyncWriter::acquireFrame(){
+    std::unique_lock<std::mutex> lk(m_);
+    cv_free_.wait(lk, [&]{ return !free_.empty(); });
+    const int k = free_.back();
+    free_.pop_back();
+    return k;
+}
+
+int AsyncWriter::tryAcquireFrame(){
+    std::lock_guard<std::mutex> lk(m_);
+    if (free_.empty()) return -1;
+    const int k = free_.back();
+    free_.pop_back();
+    return k;
+}
+
+void AsyncWriter::submitFrame(int k, int step, double time, bool frame,
+                              std::function<void(const double*)> extra){
+    // la energia anterior al frame sale antes (mismo orden que la escritura sincrona)
+    if (!batch_.empty()){
+        Job e{-1, 0, 0.0, std::move(batch_), false, {}};
+        batch_.clear();
+        push(std::move(e));
+    }
+    push(Job{k, step, time, {}, frame, std::move(extra)});
+}
+
+void AsyncWriter::push(Job&& j){
+    if (!threaded_){
+        execute(j);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        queue_.push_back(std::move(j));
+    }
+    cv_job_.notify_one();
+}
+
+void AsyncWriter::execute(Job& j){
+    if (j.frame < 0){
+        if (energy_sink_) for (const auto& e : j.energy) energy_sink_(e.first, e.second);
+        return;
+    }
+    if (j.write_frame && frame_sink_) frame_sink_(j.step, j.time, pool_[j.frame].data());
+    if (j.extra) j.extra(pool_[j.frame].data());
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        free_.push_back(j.frame);
+    }
+    cv_free_.notify_one();
+}
+
+void AsyncWriter::loop(){
+    for (;;){
+        Job j;
+        {
+            std::unique_lock<std::mutex> lk(m_);
+            cv_job_.wait(lk, [&]{ return stop_ || !queue_.empty(); });
+            if (queue_.empty()) return;   // stop_ y nada pendiente
+            j = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        execute(j);
+    }
+}
+
+void AsyncWriter::finish(){
+    if (!batch_.empty()){
+        Job e{-1, 0, 0.0, std::move(batch_), false, {}};
+        batch_.clear();
+        push(std::move(e));
+    }
+    if (threaded_ && th_.joinable()){
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            stop_ = true;
+        }
+        cv_job_.notify_one();
+        th_.join();
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once // para que se compile solo una vez
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "AlignedBuffer.h"
+
+// Salida asincrona: un hilo escritor dedicado vuelca energia y frames mientras
+// el bucle de calculo sigue avanzando.
+//
+//  - Energia: los valores se juntan en un bloque en memoria y el bloque se
+//    entrega al escritor cuando se llena (o al terminar).
+//  - Frames: hay un pool acotado de buffers de instantanea reutilizables.
+//    acquireFrame() devuelve uno libre y bloquea si todos estan en cola
+//    (contrapresion: la simulacion nunca acumula mas de `pool` frames).
+//    El llamador llena el buffer (o lo intercambia en O(1) con un buffer de
+//    Network) y lo entrega con submitFrame(). tryAcquireFrame() no espera:
+//    lo usan las instantaneas descartables (transmision en vivo).
+//    make_buffer crea los buffers del pool (si no, ceros desde este hilo): los
+//    que se intercambian con Network deben venir de Network::placedBuffer()
+//    para que las paginas queden en el nodo NUMA de los hilos que las recorren.
+//
+// Con threaded=false los trabajos se ejecutan en el mismo hilo al entregarse
+// (modo sincrono, para comparar).
+class AsyncWriter {
+public:
+    using EnergySink = std::function<void(int step, double E)>;
+    using FrameSink  = std::function<void(int step, double time, const double* amp)>;
+    using BufferFactory = std::function<AlignedBuffer<double>()>;
+
+    AsyncWriter(size_t frame_elems, int pool, bool threaded, EnergySink energy, FrameSink frame,
+                BufferFactory make_buffer = {});
+    ~AsyncWriter();
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    void energy(int step, double E);
+
+    int acquireFrame();                        // indice de un buffer libre del pool
+    int tryAcquireFrame();                     // igual, pero -1 (sin esperar) si no hay
+    AlignedBuffer<double>& frame(int k){ return pool_[k]; }
+    // frame=false entrega el buffer solo para `extra` (p. ej. un checkpoint);
+    // extra(amp) corre en el hilo escritor despues del frame
+    void submitFrame(int k, int step, double time, bool frame = true,
+                     std::function<void(const double*)> extra = {});
+
+    void finish();                             // entrega lo pendiente y espera al escritor
+
+private:
+    struct Job {
+        int frame;                             // -1 => bloque de energia
+        int step;
+        double time;
+        std::vector<std::pair<int, double>> energy;
+        bool write_frame;
+        std::function<void(const double*)> extra;
+    };
+
+    static constexpr size_t kEnergyBatch = 1024;
+
+    EnergySink energy_sink_;
+    FrameSink frame_sink_;
+    std::vector<AlignedBuffer<double>> pool_;
+    std::vector<int> free_;                    // buffers del pool disponibles
+    std::vector<std::pair<int, double>> batch_;
+    std::deque<Job> queue_;
+    std::mutex m_;
+    std::condition_variable cv_job_, cv_free_;
+    bool stop_ = false;
+    bool threaded_;
+    std::thread th_;
+
+    void push(Job&& j);
+    void execute(Job& j);
+    void loop();
+};
@@ -0,0 +1,314 @@
+#include "Autotune.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <vector>
+#include <omp.h>
+
+#include "Stencil.h"
+#include "Sweep.h"
+
+namespace {
+
+constexpr double kSampleSec = 2e-3;   // duracion minima de una muestra
+constexpr int kSamples = 3;           // muestras por candidato (se queda el minimo)
+
+struct Candidate {
+    ScheduleType schedule = ScheduleType::Dynamic;
+    int chunk = 1;
+    bool collapse2 = false;
+    bool taskloop = false;
+    int grain = 1;
+    int threads = 1;
+    double sec = std::numeric_limits<double>::infinity();   // segundos por paso
+};
+
+const char* schedule_label(ScheduleType s){
+    return s == ScheduleType::Static ? "static" : s == ScheduleType::Dynamic ? "dynamic" : "guided";
+}
+
+std::string describe(const Candidate& c){
+    std::ostringstream s;
+    if (c.taskloop) s << "taskloop grain=" << c.grain;
+    else s << schedule_label(c.schedule) << " chunk=" << c.chunk << (c.collapse2 ? " collapse2" : "");
+    s << " hilos=" << c.threads;
+    return s.str();
+}
+
+std::string cpu_model(){
+    std::ifstream f("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(f, line)){
+        if (line.rfind("model name", 0) != 0) continue;
+        std::string m = line.substr(line.find(':') + 1);
+        m.erase(0, m.find_first_not_of(' '));
+        std::replace(m.begin(), m.end(), '\t', ' ');
+        return m;
+    }
+    return "desconocido";
+}
+
+// clave del cache (sin tabuladores: es la primera columna del archivo)
+std::string cache_key(const RunParams& p, int threads){
+    std::ostringstream s;
+    s << cpu_model() << '|' << p.network << ':'
+      << (p.network == "1d" ? std::to_string(p.N) : std::to_string(p.Lx) + "x" + std::to_string(p.Ly))
+      << '|' << (p.periodic ? "periodic" : "open")
+      << '|' << (p.precision == Precision::F64 ? "f64" : p.precision == Precision::F32 ? "f32" : "mixed")
+      << '|' << (p.kernel == KernelType::Stencil ? "stencil" : "csr")
+      << '|' << (p.fused ? "fused" : "nofused")
+      << '|' << (p.noise == NoiseMode::PerNode ? "pernode" : "uniform")
+      << '|' << threads;
+    return s.str();
+}
+
+// linea del cache: clave, schedule, chunk, collapse2, taskloop, grain, hilos, s/paso
+bool cache_lookup(const std::string& path, const std::string& key, Candidate& c){
+    std::ifstream f(path);
+    std::string line;
+    bool found = false;
+    while (std::getline(f, line)){
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream is(line);
+        std::string k, sched;
+        Candidate r;
+        if (!std::getline(is, k, '\t') || k != key) continue;
+        if (!(is >> sched >> r.chunk >> r.collapse2 >> r.taskloop >> r.grain >> r.threads >> r.sec)) continue;
+        if (sched == "static") r.schedule = ScheduleType::Static;
+        else if (sched == "guided") r.schedule = ScheduleType::Guided;
+        else r.schedule = ScheduleType::Dynamic;
+        c = r;
+        found = true;   // la ultima linea con la clave manda
+    }
+    return found;
+}
+
+// reescribe el cache sin las lineas viejas de la clave (archivo temporal + rename)
+void cache_store(const std::string& path, const std::string& key, const Candidate& c){
+    std::vector<std::string> keep;
+    {
+        std::ifstream f(path);
+        std::string line;
+        while (std::getline(f, line)){
+            if (line.empty() || line[0] == '#') continue;
+            if (line.compare(0, key.size() + 1, key + '\t') == 0) continue;
+            keep.push_back(line);
+        }
+    }
+    std::error_code ec;
+    std::filesystem::path cp(path);
+    if (cp.has_parent_path()) std::filesystem::create_directories(cp.parent_path(), ec);
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream f(tmp);
+        if (!f) return;
+        f << "# clave\tschedule\tchunk\tcollapse2\ttaskloop\tgrain\thilos\ts_por_paso\n";
+        for (const std::string& l : keep) f << l << '\n';
+        f << key << '\t' << schedule_label(c.schedule) << '\t' << c.chunk << '\t' << c.collapse2 << '\t'
+          << c.taskloop << '\t' << c.grain << '\t' << c.threads << '\t' << std::setprecision(6) << c.sec << '\n';
+    }
+    std::filesystem::rename(tmp, path, ec);
+}
+
+template <class Real, class Acc>
+class Tuner {
+public:
+    Tuner(Network& net, const RunParams& p) : net_(net), p_(p) {
+        is2D_ = net.is2D();
+        N_ = net.size();
+        Lx_ = is2D_ ? net.Lx() : N_;
+        Ly_ = net.Ly();
+        use_stencil_ = net.isRegular() && p.kernel == KernelType::Stencil;
+        if (!use_stencil_ && !net.hasAdjacency()) net.buildAdjacency();
+        // fuente por nodo: mismo trafico que en la corrida (valores en cero)
+        if (p.noise == NoiseMode::PerNode){
+            zeros_.assign(N_, 0.0);
+            src_.values = zeros_.data();
+            src_.scale = p.S0;
+        }
+    }
+
+    // segundos por paso del candidato: minimo de kSamples muestras de inner barridos
+    double measure(const Candidate& c){
+        RunParams q = p_;
+        q.schedule = c.schedule;
+        q.chunk = c.chunk;
+        q.collapse2 = c.collapse2;
+        q.taskloop = c.taskloop;
+        q.grain = c.grain;
+        if (inner_ == 0){
+            // calibracion: barridos por muestra para que cada una dure al menos kSampleSec
+            const double t = sample(q, c.threads, 1);
+            inner_ = (int)std::clamp(kSampleSec / std::max(t, 1e-9), 1.0, 10000.0);
+        }
+        double best = std::numeric_limits<double>::infinity();
+        for (int s=0; s<kSamples; ++s) best = std::min(best, sample(q, c.threads, inner_) / inner_);
+        return best;
+    }
+
+private:
+    Network& net_;
+    const RunParams& p_;
+    bool is2D_, use_stencil_;
+    int N_, Lx_, Ly_;
+    int inner_ = 0;
+    std::vector<double> zeros_;
+    SourceTerm src_;
+
+    double sample(const RunParams& q, int threads, int inner){
+        const Real* cur = net_.currentAs<Real>();
+        Real* nxt = net_.nextAs<Real>();
+        const int* off = net_.rowOffsets();
+        const int* nbr = net_.colIndices();
+        const StepCoeffs coeffs{q.dt, net_.diffusion(), net_.damping()};
+        const SourceTerm src = src_;
+        auto update_index = [&](int idx) -> Acc {
+            const Acc ai = cur[idx];
+            Acc acc = 0;
+            for (int k=off[idx], kend=off[idx+1]; k<kend; ++k){
+                acc += ((Acc)cur[nbr[k]] - ai);
+            }
+            return nxt[idx] = (Real)stencil_update<Acc>(ai, acc, (Acc)src.at(idx), coeffs);
+        };
+        const int chunk = std::max(1, q.chunk), grain = std::max(1, q.grain);
+        double t0 = 0.0, t1 = 0.0;
+        const int extra_barriers = q.fused ? 2 : 4;
+        double sink = 0.0;
+        #pragma omp parallel num_threads(threads) reduction(+:sink)
+        {
+            #pragma omp barrier
+            #pragma omp master
+            t0 = omp_get_wtime();
+            for (int k=0; k<inner; ++k){
+                if (use_stencil_){
+                    sink += q.fused
+                        ? stencil_dispatch<Real, Acc, true>(is2D_, net_.boundary(), cur, nxt, Lx_, Ly_, coeffs, q, chunk, grain, src)
+                        : stencil_dispatch<Real, Acc, false>(is2D_, net_.boundary(), cur, nxt, Lx_, Ly_, coeffs, q, chunk, grain, src);
+                } else {
+                    sink += q.fused ? csr_sweep<true>(N_, Lx_, Ly_, is2D_, q, chunk, grain, update_index)
+                                    : csr_sweep<false>(N_, Lx_, Ly_, is2D_, q, chunk, grain, update_index);
+                }
+                // barreras del paso real: la del barrido, las de las dos secciones
+                // single y, sin paso fusionado, las de energia y commit
+                #pragma omp barrier
+                for (int b=0; b<extra_barriers; ++b){
+                    #pragma omp barrier
+                }
+            }
+            #pragma omp master
+            t1 = omp_get_wtime();
+        }
+        (void)sink;
+        return t1 - t0;
+    }
+};
+
+// potencias de 2 (o de 4) entre lo y hi, con hi incluido si no es potencia
+std::vector<int> geometric(int lo, int hi, int factor){
+    std::vector<int> v;
+    hi = std::max(hi, lo);
+    for (long c=lo; c<=hi; c*=factor) v.push_back((int)c);
+    if (v.back() != hi && v.size() < 12) v.push_back(hi);
+    return v;
+}
+
+template <class Real, class Acc>
+Candidate search(Network& net, const RunParams& p, int pmax, std::ostream& os){
+    Tuner<Real, Acc> tuner(net, p);
+    const bool is2D = net.is2D();
+    const int rows = is2D ? net.Ly() : net.size();
+    const int Lx = is2D ? net.Lx() : 1;
+    int tested = 0;
+    Candidate best;
+    auto consider = [&](Candidate c){
+        c.sec = tuner.measure(c);
+        ++tested;
+        if (c.sec < best.sec) best = c;
+    };
+
+    // 1) planificacion x chunk (filas en 2D, nodos en 1D) con todos los hilos:
+    //    hasta que cada hilo reciba al menos un bloque
+    const int per_thread = std::max(1, rows / pmax);
+    const std::vector<int> chunks = is2D ? geometric(1, std::min(per_thread, 256), 2)
+                                         : geometric(std::min(256, per_thread), std::min(per_thread, 1 << 18), 4);
+    for (ScheduleType st : {ScheduleType::Static, ScheduleType::Dynamic, ScheduleType::Guided}){
+        for (int c : chunks){
+            Candidate k;
+            k.schedule = st; k.chunk = c; k.threads = pmax;
+            consider(k);
+        }
+    }
+
+    // 2) variantes: collapse2 (chunk en nodos, alrededor de las filas del ganador) y taskloop
+    const Candidate rows_best = best;
+    if (is2D && net.Lx() >= 3 && net.Ly() >= 3){
+        for (int f : {1, 4}){
+            Candidate k = rows_best;
+            k.collapse2 = true;
+            k.chunk = std::max(64, rows_best.chunk * Lx / f);
+            consider(k);
+        }
+    }
+    const std::vector<int> grains = is2D ? geometric(1, std::min(per_thread, 16), 4)
+                                         : geometric(std::min(4096, per_thread), std::min(per_thread, 1 << 16), 4);
+    for (int g : grains){
+        Candidate k;
+        k.taskloop = true; k.grain = g; k.threads = pmax;
+        consider(k);
+    }
+
+    // 3) menos hilos con el ganador (mitades hasta 1)
+    const Candidate all_threads = best;
+    for (int t = pmax / 2; t >= 1; t /= 2){
+        Candidate k = all_threads;
+        k.threads = t;
+        consider(k);
+    }
+
+    os << "[autotune] " << tested << " candidatos medidos\n";
+    return best;
+}
+
+} // namespace
+
+void autotune(Network& net, RunParams& params, std::ostream& os){
+    const int pmax = params.threads > 0 ? params.threads : omp_get_max_threads();
+    if (params.tb_steps > 1 && net.is2D() && net.isRegular() && params.kernel == KernelType::Stencil){
+        // el bloqueo temporal reparte tiles con dynamic,1: no hay chunk que ajustar
+        os << "[autotune] con --temporal-block el reparto es por tiles; chunk " << params.chunk << "\n";
+        return;
+    }
+    net.setSinglePrecision(params.precision != Precision::F64);
+
+    const std::string key = cache_key(params, pmax);
+    Candidate best;
+    bool cached = !params.retune && cache_lookup(params.tune_cache, key, best);
+    if (cached){
+        os << "[autotune] desde " << params.tune_cache << ": " << describe(best) << "\n";
+    } else {
+        const double t0 = omp_get_wtime();
+        switch (params.precision){
+            case Precision::F64:   best = search<double, double>(net, params, pmax, os); break;
+            case Precision::F32:   best = search<float, float>(net, params, pmax, os);   break;
+            case Precision::Mixed: best = search<float, double>(net, params, pmax, os);  break;
+        }
+        os << "[autotune] " << describe(best) << ": " << std::fixed << std::setprecision(3)
+           << best.sec * 1e3 << " ms/paso (busqueda " << omp_get_wtime() - t0 << " s)\n" << std::defaultfloat;
+        cache_store(params.tune_cache, key, best);
+    }
+
+    params.schedule = best.schedule;
+    params.chunk = best.chunk;
+    params.collapse2 = best.collapse2;
+    params.taskloop = best.taskloop;
+    params.grain = best.grain;
+    params.threads = best.threads;
+    omp_set_num_threads(best.threads);
+    // first touch con el reparto elegido (schedule static sobre filas/nodos; si no, un bloque por hilo)
+    net.setTouchChunk(best.schedule == ScheduleType::Static && !best.collapse2 && !best.taskloop ? best.chunk : 0);
+}
@@ -0,0 +1,24 @@
+#pragma once // para que se compile solo una vez
+
+#include <ostream>
+#include <string>
+
+#include "Network.h"
+#include "Types.h"
+
+// Autotuner de --chunk auto: elige planificacion (static/dynamic/guided),
+// chunk, variante (filas, collapse2 o taskloop con su grain) y numero de
+// hilos midiendo en el mismo proceso, sobre la red ya construida.
+//
+// Cada candidato se mide con barridos del paso (los mismos de Sweep.h, en la
+// precision y el kernel de la corrida, con las barreras de un paso real) que
+// leen current y escriben next sin confirmar: el estado de la simulacion no
+// cambia y el costo equivale a unos pocos pasos. La busqueda va por etapas: planificacion x chunk con todos los
+// hilos, despues collapse2/taskloop y por ultimo menos hilos con el ganador.
+//
+// El ganador se guarda en un cache de texto (params.tune_cache) con clave
+// CPU + forma de la red + bordes + precision + kernel + paso fusionado + hilos
+// pedidos; si la clave ya esta, se usa sin medir (--retune fuerza la busqueda).
+// Al terminar deja la eleccion en params, fija los hilos con
+// omp_set_num_threads y vuelve a repartir el first touch de la red.
+void autotune(Network& net, RunParams& params, std::ostream& os);
@@ -5,6 +5,11 @@
 #include <numeric>
 #include <cmath>
 #include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <cstdio>
+#include "AlignedBuffer.h"
+#include "Sweep.h"
 
 static double mean(const std::vector<double>& v){
     if (v.empty()) return 0.0;
@@ -168,3 +173,443 @@ void Benchmark::run_time_vs_chunk_dynamic(Network& net, int steps, int threads,
         out << c << " " << mean(times) << " " << stdev(times) << "\n";
     }
 }
+
+void Benchmark::accuracy_report(const std::vector<double>& trace, const std::vector<double>& ref, long first_step,
+                                Precision p, double t_run, double t_ref, const std::string& out_path)
+{
+    const size_t n = std::min(trace.size(), ref.size());
+    double max_rel = 0.0, sum_sq = 0.0;
+    long max_step = 0;
+    for (size_t k=0; k<n; ++k){
+        const double rel = std::fabs(trace[k] - ref[k]) / std::max(std::fabs(ref[k]), 1e-300);
+        sum_sq += rel*rel;
+        if (rel > max_rel){ max_rel = rel; max_step = first_step + (long)k + 1; }
+    }
+    const double rms = n ? std::sqrt(sum_sq / n) : 0.0;
+    const double final_rel = n ? std::fabs(trace[n-1] - ref[n-1]) / std::max(std::fabs(ref[n-1]), 1e-300) : 0.0;
+    const char* name = p == Precision::F32 ? "f32" : (p == Precision::Mixed ? "mixed" : "f64");
+    const double speedup = t_run > 0.0 ? t_ref / t_run : 0.0;
+
+    std::cout << "[accuracy] " << name << " vs f64 (" << n << " pasos): error relativo de E max "
+              << max_rel << " (paso " << max_step << "), rms " << rms << ", final " << final_rel << "\n"
+              << "[accuracy] tiempo " << t_run << " s vs " << t_ref << " s (x" << speedup << ")\n";
+
+    std::filesystem::path path(out_path);
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path());
+    std::ofstream out(out_path);
+    if (!out) return;
+    out << "# precision\tsteps\tmax_rel\tmax_rel_step\trms_rel\tfinal_rel\tt_run\tt_ref\tspeedup\n";
+    out << name << "\t" << n << "\t" << max_rel << "\t" << max_step << "\t" << rms << "\t"
+        << final_rel << "\t" << t_run << "\t" << t_ref << "\t" << speedup << "\n";
+}
+
+// ============================ Microbenchmark de kernels ============================
+
+namespace {
+
+struct KernelStats {
+    double median = 0.0, min = 0.0, mean = 0.0;
+    double ci_lo = 0.0, ci_hi = 0.0;   // IC 95% de la mediana (estadisticos de orden)
+    int samples = 0;
+    int inner = 1;                     // barridos por muestra
+};
+
+struct KernelResult {
+    std::string phase, variant;
+    double bytes = 0.0, flops = 0.0;   // por barrido (trafico minimo, sin write-allocate)
+    KernelStats st;
+};
+
+// Cada muestra es una region paralela con `inner` barridos; inner se calibra
+// en el calentamiento para que la muestra dure al menos ~2 ms (la creacion de
+// la region y la resolucion del reloj quedan amortizadas). Los tiempos son por barrido.
+template <class F>
+KernelStats time_kernel(F&& sweeps, int warmup, int reps){
+    KernelStats st;
+    constexpr double kMinSample = 2e-3;
+    double t1 = 0.0;
+    for (int w=0; w<std::max(1, warmup); ++w){
+        const double t0 = omp_get_wtime();
+        sweeps(1);
+        t1 = omp_get_wtime() - t0;
+    }
+    st.inner = t1 > 0.0 ? std::max(1, (int)std::ceil(kMinSample / t1)) : 1000;
+    std::vector<double> t(std::max(1, reps));
+    for (double& x : t){
+        const double t0 = omp_get_wtime();
+        sweeps(st.inner);
+        x = (omp_get_wtime() - t0) / st.inner;
+    }
+    std::sort(t.begin(), t.end());
+    const int n = (int)t.size();
+    st.samples = n;
+    st.min = t.front();
+    st.median = n % 2 ? t[n/2] : 0.5*(t[n/2-1] + t[n/2]);
+    st.mean = mean(t);
+    // rangos n/2 -+ 1.96*sqrt(n)/2 (aproximacion binomial, sin suponer normalidad)
+    const double h = 0.98 * std::sqrt((double)n);
+    st.ci_lo = t[std::max(0, (int)std::floor(n/2.0 - h))];
+    st.ci_hi = t[std::min(n-1, (int)std::ceil(n/2.0 + h) - 1)];
+    return st;
+}
+
+// Sonda tipo STREAM (copy, scale, add, triad) con arreglos mas grandes que la
+// cache: el mejor GB/s de las cuatro es el techo de ancho de banda del reporte
+std::vector<KernelResult> stream_probe(size_t n, int warmup, int reps){
+    AlignedBuffer<double> a = AlignedBuffer<double>::uninitialized(n);
+    AlignedBuffer<double> b = AlignedBuffer<double>::uninitialized(n);
+    AlignedBuffer<double> c = AlignedBuffer<double>::uninitialized(n);
+    const long nl = (long)n;
+    #pragma omp parallel for schedule(static)
+    for (long i=0; i<nl; ++i){ a[i] = 1.0; b[i] = 2.0; c[i] = 0.0; }
+    const double q = 3.0;
+    double* A = a.data();
+    double* Bv = b.data();
+    double* C = c.data();
+    std::vector<KernelResult> r;
+    auto add = [&](const char* name, double words, double flops, auto&& body){
+        KernelResult k;
+        k.phase = "stream";
+        k.variant = name;
+        k.bytes = words * sizeof(double) * n;
+        k.flops = flops * n;
+        k.st = time_kernel([&](int inner){
+            #pragma omp parallel
+            for (int it=0; it<inner; ++it) body();
+        }, warmup, reps);
+        r.push_back(k);
+    };
+    add("copy",  2, 0, [&]{
+        #pragma omp for schedule(static)
+        for (long i=0; i<nl; ++i) C[i] = A[i];
+    });
+    add("scale", 2, 1, [&]{
+        #pragma omp for schedule(static)
+        for (long i=0; i<nl; ++i) Bv[i] = q*C[i];
+    });
+    add("add",   3, 1, [&]{
+        #pragma omp for schedule(static)
+        for (long i=0; i<nl; ++i) C[i] = A[i] + Bv[i];
+    });
+    add("triad", 3, 2, [&]{
+        #pragma omp for schedule(static)
+        for (long i=0; i<nl; ++i) A[i] = Bv[i] + q*C[i];
+    });
+    return r;
+}
+
+const char* schedule_name(ScheduleType s){
+    return s == ScheduleType::Static ? "static" : (s == ScheduleType::Dynamic ? "dynamic" : "guided");
+}
+
+// Fases del paso con almacenamiento Real y aritmetica Acc. Todas leen cur y
+// escriben nxt sin intercambiar buffers (mismo trafico en cada barrido).
+template <class Real, class Acc>
+std::vector<KernelResult> bench_phases(Network& net, const RunParams& params, int warmup, int reps){
+    const bool is2D = net.is2D();
+    const int N = net.size(), Lx = net.Lx(), Ly = net.Ly();
+    const Boundary boundary = net.boundary();
+    const int chunk = params.chunk > 0 ? params.chunk : 1;
+    const int grain = params.grain > 0 ? params.grain : 1;
+    const StepCoeffs coeffs{params.dt, net.diffusion(), net.damping()};
+    const Real* cur = net.currentAs<Real>();
+    Real* nxt = net.nextAs<Real>();
+
+    // fuente del modo pedido con valores fijos (la rotacion de fases no se mide aca)
+    std::vector<double> src_vals;
+    SourceTerm src;
+    if (params.noise == NoiseMode::PerNode){
+        src_vals.resize(N);
+        for (int i=0; i<N; ++i) src_vals[i] = std::sin(0.001 * i);
+        src.values = src_vals.data();
+        src.scale = params.S0;
+    } else if (params.noise == NoiseMode::Global){
+        src.uniform = 0.5 * params.S0;
+    } else if (params.noise == NoiseMode::Single){
+        src.single_idx = N / 2;
+        src.single_val = params.S0;
+    }
+
+    // modelo de trafico y operaciones por nodo
+    const double R = sizeof(Real);
+    const double deg = is2D ? 4.0 : 2.0;
+    const double src_bytes = src.values ? 8.0 : 0.0;
+    const double upd_flops = 2*deg + 6 + (src.values ? 1 : 0);   // laplaciano + integrador
+    const double upd_bytes = 2*R + src_bytes;                     // leer u, escribir out
+
+    std::vector<KernelResult> r;
+    auto add = [&](const std::string& phase, const std::string& variant, double bpn, double fpn, auto&& sweep){
+        KernelResult k;
+        k.phase = phase;
+        k.variant = variant;
+        k.bytes = bpn * N;
+        k.flops = fpn * N;
+        k.st = time_kernel([&](int inner){
+            #pragma omp parallel
+            for (int it=0; it<inner; ++it) sweep();
+        }, warmup, reps);
+        r.push_back(k);
+    };
+
+    // variantes de planificacion del stencil (las mismas que acepta --schedule/--collapse2/--taskloop)
+    struct Variant { std::string name; RunParams p; };
+    std::vector<Variant> variants;
+    for (ScheduleType st : {ScheduleType::Static, ScheduleType::Dynamic, ScheduleType::Guided}){
+        RunParams p = params;
+        p.schedule = st; p.collapse2 = false; p.taskloop = false;
+        variants.push_back({std::string(schedule_name(st)) + "," + std::to_string(chunk), p});
+    }
+    if (is2D){
+        RunParams p = params;
+        p.collapse2 = true; p.taskloop = false;
+        variants.push_back({std::string("collapse2,") + schedule_name(p.schedule) + "," + std::to_string(chunk), p});
+    }
+    {
+        RunParams p = params;
+        p.taskloop = true; p.collapse2 = false;
+        variants.push_back({"taskloop," + std::to_string(grain), p});
+    }
+
+    if (net.isRegular()){
+        for (const Variant& v : variants){
+            add("update", v.name, upd_bytes, upd_flops, [&]{
+                stencil_dispatch<Real, Acc, false>(is2D, boundary, cur, nxt, is2D ? Lx : N, Ly, coeffs, v.p, chunk, grain, src);
+                #pragma omp barrier
+            });
+        }
+        for (const Variant& v : variants){
+            add("update+energy", v.name, upd_bytes, upd_flops + 2, [&]{
+                stencil_dispatch<Real, Acc, true>(is2D, boundary, cur, nxt, is2D ? Lx : N, Ly, coeffs, v.p, chunk, grain, src);
+                #pragma omp barrier
+            });
+        }
+    }
+
+    // camino CSR (lista de vecinos): mismo calculo con indices explicitos
+    if (!net.hasAdjacency()) net.buildAdjacency();
+    const int* off = net.rowOffsets();
+    const int* nbr = net.colIndices();
+    auto update_index = [&](int idx) -> Acc {
+        const Acc ai = cur[idx];
+        Acc acc = 0;
+        for (int k=off[idx], kend=off[idx+1]; k<kend; ++k){
+            acc += ((Acc)cur[nbr[k]] - ai);
+        }
+        return nxt[idx] = (Real)stencil_update<Acc>(ai, acc, (Acc)src.at(idx), coeffs);
+    };
+    const double csr_bytes = upd_bytes + 4.0 + 4.0*deg;   // + offsets e indices de vecinos
+    const std::string csr_name = std::string("csr,") + schedule_name(params.schedule) + "," + std::to_string(chunk);
+    add("update", csr_name, csr_bytes, upd_flops, [&]{
+        RunParams p = params; p.collapse2 = false; p.taskloop = false;
+        csr_sweep<false>(N, Lx, Ly, is2D, p, chunk, grain, update_index);
+        #pragma omp barrier
+    });
+    add("update+energy", csr_name, csr_bytes, upd_flops + 2, [&]{
+        RunParams p = params; p.collapse2 = false; p.taskloop = false;
+        csr_sweep<true>(N, Lx, Ly, is2D, p, chunk, grain, update_index);
+        #pragma omp barrier
+    });
+
+    // fases del paso no fusionado: energia (reduccion sobre next) y commit (copia next -> current)
+    double E = 0.0;
+    add("energy", "reduction", R, 2, [&]{
+        #pragma omp for reduction(+:E)
+        for (int i=0; i<N; ++i){
+            const Acc a = nxt[i];
+            E += a*a;
+        }
+    });
+    Real* cw = net.currentAs<Real>();
+    add("commit", "copy", 2*R, 0, [&]{
+        #pragma omp for
+        for (int i=0; i<N; ++i) cw[i] = nxt[i];
+    });
+    return r;
+}
+
+std::string json_escape(const std::string& s){
+    std::string o;
+    for (char c : s){ if (c == '"' || c == '\\') o += '\\'; o += c; }
+    return o;
+}
+
+} // namespace
+
+void Benchmark::run_kernels(Network& net, const RunParams& params, const std::string& out_prefix)
+{
+    const int warmup = std::max(0, params.bench_warmup);
+    const int reps = std::max(1, params.bench_reps);
+    const int threads = omp_get_max_threads();
+    const char* prec = params.precision == Precision::F32 ? "f32" : (params.precision == Precision::Mixed ? "mixed" : "f64");
+
+    // sonda de ancho de banda: 3 arreglos de al menos 64 MiB (o del tamano de la red)
+    const size_t n_stream = std::max<size_t>((size_t)net.size(), (size_t)1 << 23);
+    std::vector<KernelResult> res = stream_probe(n_stream, warmup, reps);
+    double bw_peak = 0.0;   // mejor GB/s (mediana) de la sonda
+    std::string bw_kernel;
+    for (const auto& k : res){
+        const double gbs = k.st.median > 0.0 ? k.bytes / k.st.median * 1e-9 : 0.0;
+        if (gbs > bw_peak){ bw_peak = gbs; bw_kernel = k.variant; }
+    }
+
+    net.setSinglePrecision(params.precision != Precision::F64);
+    std::vector<KernelResult> phases;
+    switch (params.precision){
+        case Precision::F64:   phases = bench_phases<double, double>(net, params, warmup, reps); break;
+        case Precision::F32:   phases = bench_phases<float, float>(net, params, warmup, reps);   break;
+        case Precision::Mixed: phases = bench_phases<float, double>(net, params, warmup, reps);  break;
+    }
+    res.insert(res.end(), phases.begin(), phases.end());
+
+    std::cout << "[microbench] red " << (net.is2D() ? "2d " : "1d ") << net.Lx() << "x" << net.Ly()
+              << ", " << threads << " hilos, precision " << prec << ", simd " << simd_kernels().name
+              << ", " << reps << " muestras (+" << warmup << " de calentamiento)\n";
+    std::cout << "[microbench] techo de ancho de banda (STREAM " << bw_kernel << "): " << std::fixed
+              << std::setprecision(2) << bw_peak << " GB/s\n";
+    std::cout << std::left << std::setw(15) << "fase" << std::setw(26) << "variante"
+              << std::right << std::setw(12) << "mediana us" << std::setw(11) << "min us"
+              << std::setw(22) << "IC95 us" << std::setw(9) << "GB/s" << std::setw(9) << "GFLOP/s"
+              << std::setw(9) << "% techo" << "\n";
+
+    std::filesystem::path base(out_prefix);
+    if (base.has_parent_path()) std::filesystem::create_directories(base.parent_path());
+    std::ofstream csv(out_prefix + ".csv");
+    std::ofstream js(out_prefix + ".json");
+    if (csv)
+        csv << "phase,variant,samples,inner,median_s,min_s,mean_s,ci95_lo_s,ci95_hi_s,"
+               "bytes,flops,gbs,gflops,intensity,roofline_pct\n";
+    if (js){
+        js << std::setprecision(9) << "{\n"
+           << "  \"network\": {\"type\": \"" << (net.is2D() ? "2d" : "1d") << "\", \"Lx\": " << net.Lx()
+           << ", \"Ly\": " << net.Ly() << ", \"nodes\": " << net.size()
+           << ", \"periodic\": " << (net.boundary() == Boundary::Periodic ? "true" : "false") << "},\n"
+           << "  \"threads\": " << threads << ",\n"
+           << "  \"precision\": \"" << prec << "\",\n"
+           << "  \"simd\": \"" << simd_kernels().name << "\",\n"
+           << "  \"warmup\": " << warmup << ",\n"
+           << "  \"reps\": " << reps << ",\n"
+           << "  \"stream_peak_gbs\": " << bw_peak << ",\n"
+           << "  \"stream_peak_kernel\": \"" << bw_kernel << "\",\n"
+           << "  \"kernels\": [\n";
+    }
+    bool over_roof = false;
+    for (size_t i=0; i<res.size(); ++i){
+        const KernelResult& k = res[i];
+        const double t = k.st.median;
+        const double gbs = t > 0.0 ? k.bytes / t * 1e-9 : 0.0;
+        const double gflops = t > 0.0 ? k.flops / t * 1e-9 : 0.0;
+        const double ai = k.bytes > 0.0 ? k.flops / k.bytes : 0.0;
+        // kernels limitados por memoria: techo = intensidad * ancho de banda, % = GB/s / techo de BW
+        const double pct = bw_peak > 0.0 ? 100.0 * gbs / bw_peak : 0.0;
+        if (k.phase != "stream" && pct > 100.0) over_roof = true;
+        std::cout << std::left << std::setw(15) << k.phase << std::setw(26) << k.variant << std::right
+                  << std::setprecision(2) << std::setw(12) << t*1e6 << std::setw(11) << k.st.min*1e6
+                  << std::setw(10) << k.st.ci_lo*1e6 << " - " << std::setw(9) << k.st.ci_hi*1e6
+                  << std::setw(9) << gbs << std::setw(9) << gflops << std::setw(8) << pct << "%\n";
+        if (csv)
+            csv << std::setprecision(9) << std::defaultfloat << k.phase << ",\"" << k.variant << "\"," << k.st.samples << ","
+                << k.st.inner << "," << t << "," << k.st.min << "," << k.st.mean << "," << k.st.ci_lo << ","
+                << k.st.ci_hi << "," << k.bytes << "," << k.flops << "," << gbs << "," << gflops << ","
+                << ai << "," << pct << "\n";
+        if (js)
+            js << std::setprecision(9) << std::defaultfloat
+               << "    {\"phase\": \"" << json_escape(k.phase) << "\", \"variant\": \"" << json_escape(k.variant)
+               << "\", \"samples\": " << k.st.samples << ", \"inner\": " << k.st.inner
+               << ", \"median_s\": " << t << ", \"min_s\": " << k.st.min << ", \"mean_s\": " << k.st.mean
+               << ", \"ci95_s\": [" << k.st.ci_lo << ", " << k.st.ci_hi << "], \"bytes\": " << k.bytes
+               << ", \"flops\": " << k.flops << ", \"gbs\": " << gbs << ", \"gflops\": " << gflops
+               << ", \"intensity\": " << ai << ", \"roofline_pct\": " << pct << "}"
+               << (i+1 < res.size() ? "," : "") << "\n";
+    }
+    if (js) js << "  ]\n}\n";
+    std::cout << std::defaultfloat;
+    if (over_roof)
+        std::cout << "[microbench] % techo > 100: el conjunto de trabajo cabe en cache; "
+                     "para medir memoria usar una red mas grande que la cache L3\n";
+    std::cout << "[microbench] resultados en " << out_prefix << ".json y " << out_prefix << ".csv\n";
+}
+
+// ============================ Backends de ejecucion ============================
+
+void Benchmark::run_backends(Network& net, const RunParams& params, const std::string& out_path)
+{
+    const int warmup = std::max(0, params.bench_warmup);
+    const int reps = std::max(1, params.bench_reps);
+    const int threads = omp_get_max_threads();
+    const int steps = std::max(1, params.steps);
+    const int chunk = params.chunk > 0 ? params.chunk : 1;
+
+    struct Variant {
+        const char* name;
+        Backend backend;
+        ScheduleType schedule;
+        bool taskloop;
+    };
+    const Variant variants[] = {
+        {"omp-static",   Backend::OpenMP, ScheduleType::Static,  false},
+        {"omp-dynamic",  Backend::OpenMP, ScheduleType::Dynamic, false},
+        {"omp-taskloop", Backend::OpenMP, ScheduleType::Static,  true},
+        {"pool",         Backend::Pool,   ScheduleType::Static,  false},
+    };
+
+    struct Row {
+        const char* name;
+        KernelStats st;   // por paso
+        double steals = 0.0;
+    };
+    std::vector<Row> rows;
+    for (const Variant& v : variants){
+        RunParams p = params;
+        p.backend = v.backend;
+        p.schedule = v.schedule;
+        p.taskloop = v.taskloop;
+        p.chunk = chunk;
+        p.grain = chunk;
+        p.fused = true;
+        p.collapse2 = false;
+        p.tb_steps = 1;
+        p.active = false;
+        p.steps = steps;
+        p.dump_frames = false;
+        p.checkpoint_every = 0;
+        p.perf_counters = false;
+        p.profile = false;
+        p.observe.clear();
+        p.probes.clear();
+        p.energy_out.clear();
+        p.stream.clear();
+        double steals = 0.0;
+        // cada muestra son `inner` corridas completas de `steps` pasos
+        KernelStats st = time_kernel([&](int inner){
+            for (int r=0; r<inner; ++r){
+                reset_initial(net);
+                WavePropagator wp(net, p);
+                wp.run(p.energy_out);
+                steals = wp.poolStealsPerStep();
+            }
+        }, warmup, reps);
+        st.median /= steps; st.min /= steps; st.mean /= steps;
+        st.ci_lo /= steps; st.ci_hi /= steps;
+        rows.push_back(Row{v.name, st, steals});
+    }
+
+    const double base = rows.front().st.median;
+    std::cout << "[backends] red " << (net.is2D() ? "2d " : "1d ") << net.Lx() << "x" << net.Ly()
+              << ", " << threads << " hilos, chunk " << chunk << ", " << steps << " pasos por corrida, "
+              << reps << " muestras\n";
+    std::filesystem::path path(out_path);
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path());
+    std::ofstream out(out_path);
+    if (out) out << "# backend threads chunk median_us_per_step min_us_per_step mnodes_per_s speedup_vs_static steals_per_step\n";
+    for (const Row& r : rows){
+        const double us = r.st.median * 1e6;
+        const double mn = r.st.median > 0.0 ? net.size() / r.st.median * 1e-6 : 0.0;
+        const double sp = r.st.median > 0.0 ? base / r.st.median : 0.0;
+        char line[200];
+        std::snprintf(line, sizeof(line), "[backends] %-13s %10.2f us/paso (min %.2f)  %9.1f Mnodos/s  x%.2f  robos/paso %.1f\n",
+                      r.name, us, r.st.min * 1e6, mn, sp, r.steals);
+        std::cout << line;
+        if (out) out << r.name << ' ' << threads << ' ' << chunk << ' ' << us << ' ' << r.st.min * 1e6
+                     << ' ' << mn << ' ' << sp << ' ' << r.steals << '\n';
+    }
+}
@@ -16,4 +16,26 @@ void run_scaling(Network& net, int steps, ScheduleType st, int chunk,
 void run_time_vs_chunk_dynamic(Network& net, int steps, int threads, int reps,
                                const std::vector<int>& chunks,
                                const std::string& out_path);
+
+// Compara la traza de energia de una corrida en precision reducida con la de
+// una referencia double (misma configuracion) y escribe el resumen: error
+// relativo maximo, RMS y final, y tiempos de ambas corridas.
+// trace[k] y ref[k] son la energia del paso first_step+k+1.
+void accuracy_report(const std::vector<double>& trace, const std::vector<double>& ref, long first_step,
+                     Precision p, double t_run, double t_ref, const std::string& out_path);
+
+// Microbenchmark de kernels (--microbench): mide por separado las fases del
+// paso (actualizacion, actualizacion+energia, energia, commit) y cada variante
+// de planificacion sobre la red y la precision de `params`, con calentamiento,
+// mediana/minimo/IC 95% de la mediana, GB/s y GFLOP/s efectivos y el % del
+// techo de ancho de banda medido con una sonda tipo STREAM.
+// Escribe out_prefix.json y out_prefix.csv.
+void run_kernels(Network& net, const RunParams& params, const std::string& out_prefix);
+
+// Backends de ejecucion (--bench-backends): el paso fusionado completo con
+// OpenMP (static, dynamic, taskloop) y con el pool con robo de trabajo
+// (--backend pool) sobre la misma red, --chunk, hilos y precision. Cada
+// muestra son corridas completas de --steps pasos; reporta us por paso
+// (mediana y minimo), Mnodos/s, speedup contra omp-static y robos por paso.
+void run_backends(Network& net, const RunParams& params, const std::string& out_path);
 }
@@ -0,0 +1,139 @@
+#include "Checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <type_traits>
+#if defined(__unix__)
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kMagic[8] = {'W','A','V','E','C','K','P','1'};
+constexpr uint32_t kVersion = 4;
+
+// Escritura/lectura binaria minima sobre FILE*
+struct Out {
+    std::FILE* f;
+    bool ok = true;
+    void raw(const void* p, size_t n){ if (ok && n && std::fwrite(p, 1, n, f) != n) ok = false; }
+    template <class T> void pod(const T& v){ raw(&v, sizeof(T)); }
+    void str(const std::string& s){ pod<uint64_t>(s.size()); raw(s.data(), s.size()); }
+    void vec(const std::vector<double>& v){ pod<uint64_t>(v.size()); raw(v.data(), v.size()*sizeof(double)); }
+};
+
+struct In {
+    std::FILE* f;
+    void raw(void* p, size_t n){
+        if (n && std::fread(p, 1, n, f) != n) throw std::runtime_error("checkpoint truncado");
+    }
+    template <class T> void pod(T& v){ raw(&v, sizeof(T)); }
+    void str(std::string& s){ uint64_t n = 0; pod(n); s.resize(n); raw(&s[0], n); }
+    void vec(std::vector<double>& v){ uint64_t n = 0; pod(n); v.resize(n); raw(v.data(), n*sizeof(double)); }
+};
+
+// Recorre los campos de RunParams en orden fijo (el mismo para guardar y cargar)
+template <class F>
+void visit_params(RunParams& p, F&& f){
+    f(p.network); f(p.N); f(p.Lx); f(p.Ly); f(p.periodic);
+    f(p.graph); f(p.reorder); f(p.partition); f(p.part_kb);
+    f(p.D); f(p.gamma); f(p.dt); f(p.steps);
+    f(p.S0); f(p.omega);
+    f(p.noise); f(p.omega_mu); f(p.omega_sigma); f(p.noise_node);
+    f(p.schedule); f(p.chunk); f(p.chunk_auto); f(p.threads); f(p.fused); f(p.taskloop); f(p.grain);
+    f(p.tb_steps); f(p.tile);
+    f(p.kernel); f(p.src_resync); f(p.simd); f(p.precision);
+    f(p.energyAccum);
+    f(p.collapse2); f(p.dump_frames); f(p.frame_every); f(p.frame_format); f(p.frame_dtype);
+    f(p.frame_tol); f(p.frame_keyframe);
+    f(p.async_io); f(p.io_buffers);
+    f(p.checkpoint_every); f(p.checkpoint_path);
+    f(p.do_bench); f(p.energy_out);
+}
+
+template <class T>
+void put_field(Out& o, const T& v){
+    if constexpr (std::is_same<T, std::string>::value) o.str(v);
+    else if constexpr (std::is_enum<T>::value) o.pod<int32_t>((int32_t)v);
+    else if constexpr (std::is_same<T, bool>::value) o.pod<uint8_t>(v ? 1 : 0);
+    else o.pod(v);
+}
+
+template <class T>
+void get_field(In& in, T& v){
+    if constexpr (std::is_same<T, std::string>::value) in.str(v);
+    else if constexpr (std::is_enum<T>::value){ int32_t x = 0; in.pod(x); v = (T)x; }
+    else if constexpr (std::is_same<T, bool>::value){ uint8_t x = 0; in.pod(x); v = (x != 0); }
+    else in.pod(v);
+}
+
+} // namespace
+
+bool save_checkpoint(const std::string& path, const CheckpointState& s, const double* amp, size_t n){
+    const std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    Out o{f};
+    o.raw(kMagic, sizeof(kMagic));
+    o.pod(kVersion);
+    RunParams p = s.params;
+    visit_params(p, [&](auto& v){ put_field(o, v); });
+    o.pod(s.step);
+    o.pod(s.time);
+    o.pod(s.last_1d_sample);
+    o.pod(s.single_idx);
+    o.str(s.rng);
+    o.str(s.norm);
+    o.vec(s.omega);
+    o.pod(s.src_step);
+    o.vec(s.src_sin);
+    o.vec(s.src_cos);
+    o.pod<uint64_t>(n);
+    o.raw(amp, n*sizeof(double));
+    if (std::fflush(f) != 0) o.ok = false;
+#if defined(__unix__)
+    if (o.ok && fsync(fileno(f)) != 0) o.ok = false;
+#endif
+    if (std::fclose(f) != 0) o.ok = false;
+    if (!o.ok){
+        std::remove(tmp.c_str());
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+CheckpointState load_checkpoint(const std::string& path){
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) throw std::runtime_error("no se pudo abrir el checkpoint " + path);
+    CheckpointState s;
+    try {
+        In in{f};
+        char magic[8];
+        uint32_t version = 0;
+        in.raw(magic, sizeof(magic));
+        in.pod(version);
+        if (std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 || version != kVersion)
+            throw std::runtime_error(path + " no es un checkpoint valido");
+        visit_params(s.params, [&](auto& v){ get_field(in, v); });
+        in.pod(s.step);
+        in.pod(s.time);
+        in.pod(s.last_1d_sample);
+        in.pod(s.single_idx);
+        in.str(s.rng);
+        in.str(s.norm);
+        in.vec(s.omega);
+        in.pod(s.src_step);
+        in.vec(s.src_sin);
+        in.vec(s.src_cos);
+        in.vec(s.amp);
+    } catch (...){
+        std::fclose(f);
+        throw;
+    }
+    std::fclose(f);
+    return s;
+}
@@ -0,0 +1,33 @@
+#pragma once // para que se compile solo una vez
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+// Estado completo del simulador para continuar una corrida (--resume).
+//
+// Archivo binario (orden de bytes del host): "WAVECKP1", version, RunParams
+// campo por campo y luego el estado dinamico. Las amplitudes van al final
+// para poder escribirlas directamente desde el buffer de la instantanea.
+struct CheckpointState {
+    RunParams params;
+    int64_t step = 0;                  // pasos completados
+    double time = 0.0;                 // tiempo del estado guardado
+    double last_1d_sample = 0.0;
+    int single_idx = -1;
+    std::string rng;                   // estado de mt19937_64 (formato estandar de operator<<)
+    std::string norm;                  // estado de normal_distribution
+    std::vector<double> omega;         // frecuencias por nodo
+    int64_t src_step = 0;              // osciladores de la fuente (SourceEngine)
+    std::vector<double> src_sin, src_cos;
+    std::vector<double> amp;           // amplitudes confirmadas (solo al cargar)
+};
+
+// Escribe en path + ".tmp", sincroniza y renombra: un corte a mitad de la
+// escritura deja intacto el checkpoint anterior. amp tiene n amplitudes.
+bool save_checkpoint(const std::string& path, const CheckpointState& s, const double* amp, size_t n);
+
+// Lanza std::runtime_error si el archivo no existe o no es un checkpoint valido.
+CheckpointState load_checkpoint(const std::string& path);
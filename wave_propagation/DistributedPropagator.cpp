@@ -0,0 +1,365 @@
+#include "DistributedPropagator.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <omp.h>
+
+#include "AlignedBuffer.h"
+#include "FrameFile.h"
+
+namespace {
+
+template <class Real>
+MPI_Datatype mpi_type(){
+    return std::is_same<Real, double>::value ? MPI_DOUBLE : MPI_FLOAT;
+}
+
+// Nodo de una fila extrema de la grilla global (y = 0 o y = Ly-1). Mismo orden
+// de vecinos que Stencil<2,B>::edge; arriba/abajo se leen de la fila local
+// vecina (con borde periodico el halo trae la fila del otro extremo).
+template <class Real, class Acc>
+inline Acc edge_cell_2d(const Real* u, Real* out, int Lx, int yl, int x, bool has_up, bool has_dn,
+                        bool periodic, const StepCoeffs& c, const SourceTerm& src)
+{
+    const int i = yl*Lx + x;
+    const Acc ai = u[i];
+    Acc acc = 0;
+    if (x>0) acc += ((Acc)u[i-1] - ai);
+    else if (periodic) acc += ((Acc)u[yl*Lx + (Lx-1)] - ai);
+    if (x+1<Lx) acc += ((Acc)u[i+1] - ai);
+    else if (periodic) acc += ((Acc)u[yl*Lx] - ai);
+    if (has_up) acc += ((Acc)u[i-Lx] - ai);
+    if (has_dn) acc += ((Acc)u[i+Lx] - ai);
+    return out[i] = (Real)stencil_update<Acc>(ai, acc, (Acc)src.at(i), c);
+}
+
+// Nodo extremo de la linea global (i = 0 o i = N-1), como Stencil<1,B>::edge
+template <class Real, class Acc>
+inline Acc edge_cell_1d(const Real* u, Real* out, int j, bool has_l, bool has_r,
+                        const StepCoeffs& c, const SourceTerm& src)
+{
+    const Acc ai = u[j];
+    Acc acc = 0;
+    if (has_l) acc += ((Acc)u[j-1] - ai);
+    if (has_r) acc += ((Acc)u[j+1] - ai);
+    return out[j] = (Real)stencil_update<Acc>(ai, acc, (Acc)src.at(j), c);
+}
+
+} // namespace
+
+DistributedPropagator::DistributedPropagator(const RunParams& params, MPI_Comm comm)
+    : params_(params), comm_(comm)
+{
+    MPI_Comm_rank(comm_, &rank_);
+    MPI_Comm_size(comm_, &size_);
+    is2D_ = params_.network != "1d";
+    W_ = is2D_ ? params_.Lx : 1;
+    rows_ = is2D_ ? params_.Ly : params_.N;
+    if (rows_ < size_)
+        throw std::runtime_error("hay mas ranks MPI que filas (o nodos en 1D) para repartir");
+
+    // franjas contiguas; las primeras rows % size reciben una fila mas
+    counts_.resize(size_);
+    displs_.resize(size_);
+    for (int r=0; r<size_; ++r){
+        const int a = r*(rows_/size_) + std::min(r, rows_ % size_);
+        const int b = (r+1)*(rows_/size_) + std::min(r+1, rows_ % size_);
+        counts_[r] = (b - a) * W_;
+        displs_[r] = a * W_;
+        if (r == rank_){ r0_ = a; r1_ = b; }
+    }
+    if (params_.periodic){
+        up_ = (rank_ + size_ - 1) % size_;
+        dn_ = (rank_ + 1) % size_;
+    } else {
+        up_ = rank_ > 0 ? rank_ - 1 : MPI_PROC_NULL;
+        dn_ = rank_ + 1 < size_ ? rank_ + 1 : MPI_PROC_NULL;
+    }
+
+    // Frecuencias del ruido: las sortea el rank 0 con la misma distribucion
+    // que WavePropagator y las reparte (cada rank guarda solo sus filas)
+    const int n = rows_ * W_;
+    const int nl = (r1_ - r0_) * W_;
+    if (params_.noise == NoiseMode::PerNode){
+        std::vector<double> all;
+        if (rank_ == 0){
+            std::mt19937_64 rng(std::random_device{}());
+            std::normal_distribution<double> norm(params_.omega_mu, params_.omega_sigma);
+            all.resize(n);
+            for (double& w : all) w = norm(rng);
+        }
+        omega_local_.assign((size_t)nl + 2*W_, 0.0);
+        MPI_Scatterv(all.data(), counts_.data(), displs_.data(), MPI_DOUBLE,
+                     omega_local_.data() + W_, nl, MPI_DOUBLE, 0, comm_);
+    } else if (params_.noise == NoiseMode::Single){
+        single_idx_ = params_.noise_node;
+        if (single_idx_ < 0 || single_idx_ >= n){
+            single_idx_ = is2D_ ? ((params_.Ly/2) * params_.Lx + (params_.Lx/2)) : (params_.N/2);
+        }
+        if (rank_ == 0){
+            std::mt19937_64 rng(std::random_device{}());
+            std::normal_distribution<double> norm(params_.omega_mu, params_.omega_sigma);
+            omega_single_ = norm(rng);
+        }
+        MPI_Bcast(&omega_single_, 1, MPI_DOUBLE, 0, comm_);
+    }
+}
+
+void DistributedPropagator::init_source(){
+    const double dt = params_.dt;
+    const int resync = params_.src_resync;
+    switch (params_.noise){
+        case NoiseMode::Off:
+            source_.init(nullptr, 0, tcur_, dt, resync);
+            break;
+        case NoiseMode::Global:
+            source_.init(&params_.omega, 1, tcur_, dt, resync);
+            break;
+        case NoiseMode::PerNode:
+            // un oscilador por nodo local, incluidos los halos (omega = 0): el
+            // indice local de la fuente es el mismo que el de las amplitudes
+            source_.init(omega_local_.data(), (int)omega_local_.size(), tcur_, dt, resync);
+            break;
+        case NoiseMode::Single:
+            source_.init(&omega_single_, 1, tcur_, dt, resync);
+            break;
+    }
+}
+
+SourceTerm DistributedPropagator::source_term() const{
+    SourceTerm s;
+    if (source_.size() == 0) return s;
+    switch (params_.noise){
+        case NoiseMode::Off:
+            break;
+        case NoiseMode::Global:
+            s.uniform = params_.S0 * source_.values()[0];
+            break;
+        case NoiseMode::PerNode:
+            s.values = source_.values();
+            s.scale = params_.S0;
+            break;
+        case NoiseMode::Single: {
+            const int row = single_idx_ / W_;
+            if (row >= r0_ && row < r1_){
+                s.single_idx = (row - r0_ + 1)*W_ + single_idx_ % W_;
+                s.single_val = params_.S0 * source_.values()[0];
+            }
+            break;
+        }
+    }
+    return s;
+}
+
+void DistributedPropagator::run(const std::string& energy_out){
+    switch (params_.precision){
+        case Precision::F64:   run_impl<double, double>(energy_out); break;
+        case Precision::F32:   run_impl<float, float>(energy_out);   break;
+        case Precision::Mixed: run_impl<float, double>(energy_out);  break;
+    }
+}
+
+template <class Real, class Acc>
+void DistributedPropagator::run_impl(const std::string& energy_out){
+    const bool root = rank_ == 0;
+    const size_t nloc = (size_t)(r1_ - r0_ + 2) * W_;   // filas propias y dos halos
+    AlignedBuffer<Real> a = AlignedBuffer<Real>::uninitialized(nloc);
+    AlignedBuffer<Real> b = AlignedBuffer<Real>::uninitialized(nloc);
+    // primera escritura en paralelo (first touch de los hilos del rank)
+    #pragma omp parallel for schedule(static)
+    for (long i=0; i<(long)nloc; ++i){ a[i] = 0; b[i] = 0; }
+
+    // impulso inicial en el centro de la red global (como setInitialImpulseCenter)
+    const int center = is2D_ ? ((params_.Ly/2)*params_.Lx + (params_.Lx/2)) : (params_.N/2);
+    if (center / W_ >= r0_ && center / W_ < r1_){
+        const size_t k = (size_t)(center / W_ - r0_ + 1)*W_ + center % W_;
+        a[k] = (Real)1.0;
+        b[k] = (Real)1.0;
+    }
+    init_source();
+
+    // salida en el rank 0: energia y frames (misma forma que WavePropagator)
+    std::ofstream energy_file;
+    FrameWriter frames;
+    const bool want_frames = params_.dump_frames && params_.frame_every > 0;
+    if (root){
+        if (!energy_out.empty()){
+            std::filesystem::path p(energy_out);
+            if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+            energy_file.open(energy_out);
+        }
+        if (want_frames){
+            std::filesystem::create_directories("results/frames");
+            frames.open("results/frames/frames.bin", is2D_ ? params_.Lx : params_.N,
+                        is2D_ ? params_.Ly : 1, params_.frame_dtype);
+        }
+    }
+    AsyncWriter out(root && want_frames ? (size_t)rows_ * W_ : 0, params_.io_buffers,
+                    root && params_.async_io && (energy_file.is_open() || want_frames),
+                    [&](int step, double E){
+                        if (!energy_file) return;
+                        if (step == 1) energy_file << "# step\tE\n";
+                        energy_file << step << "\t" << std::setprecision(12) << E << "\n";
+                    },
+                    [&](int step, double time, const double* amp){ frames.write(step, time, amp); });
+
+    const Boundary B = params_.periodic ? Boundary::Periodic : Boundary::Open;
+    if (is2D_){
+        if (B == Boundary::Periodic) run_loop<2, Boundary::Periodic, Real, Acc>(a.data(), b.data(), out);
+        else                         run_loop<2, Boundary::Open, Real, Acc>(a.data(), b.data(), out);
+    } else {
+        if (B == Boundary::Periodic) run_loop<1, Boundary::Periodic, Real, Acc>(a.data(), b.data(), out);
+        else                         run_loop<1, Boundary::Open, Real, Acc>(a.data(), b.data(), out);
+    }
+
+    out.finish();
+    if (energy_file) energy_file.flush();
+    frames.flush();
+}
+
+template <int Dim, Boundary B, class Real, class Acc>
+void DistributedPropagator::run_loop(Real* cur, Real* nxt, AsyncWriter& out){
+    using K = Stencil<Dim, B, Real, Acc>;
+    constexpr bool periodic = (B == Boundary::Periodic);
+    const int W = W_;
+    const int nl = r1_ - r0_;                 // filas propias: locales 1..nl, halos 0 y nl+1
+    const StepCoeffs coeffs{params_.dt, params_.D, params_.gamma};
+    const MPI_Datatype type = mpi_type<Real>();
+    const int chunk = params_.chunk > 0 ? params_.chunk : 1;
+    const bool root = rank_ == 0;
+    const int fe = params_.frame_every;
+    const bool frames = params_.dump_frames && fe > 0;
+
+    // Unidades de energia (cada una se suma en orden, sin depender de los hilos):
+    // filas 1 y nl leen halos; las del medio (2..nl-1, en 1D en bloques de
+    // `chunk` nodos) se calculan mientras viajan los halos
+    const int n_mid = std::max(0, nl - 2);
+    const int nmid = Dim == 2 ? n_mid : (n_mid + chunk - 1) / chunk;
+    const int nedge = nl >= 2 ? 2 : 1;
+    std::vector<double> e_mid(nmid, 0.0), e_edge(2, 0.0);
+    std::vector<double> part(size_, 0.0);
+    std::vector<double> send;                 // frames con almacenamiento float
+    MPI_Request req[4];
+
+    // energia de la fila local yl (en 1D: un nodo de borde del rank)
+    auto edge_unit = [&](const Real* u, Real* o, int yl, const SourceTerm& src) -> double {
+        const int g = r0_ + yl - 1;           // fila (nodo) global
+        const bool first = g == 0, last = g == rows_ - 1;
+        if constexpr (Dim == 2){
+            if (!first && !last) return K::template row<true>(u, o, W, nl + 2, yl, coeffs, src);
+            // fila extrema global: todos los nodos por la ruta con ramas, como Stencil::row
+            double e = 0.0;
+            for (int x=0; x<W; ++x){
+                const Acc v = edge_cell_2d<Real, Acc>(u, o, W, yl, x, !first || periodic,
+                                                      !last || periodic, periodic, coeffs, src);
+                e += v*v;
+            }
+            return e;
+        } else {
+            const Acc v = (first || last)
+                ? edge_cell_1d<Real, Acc>(u, o, yl, !first || periodic, !last || periodic, coeffs, src)
+                : K::interior(u, o, yl, coeffs, src);
+            return (double)(v*v);
+        }
+    };
+    auto mid_unit = [&](const Real* u, Real* o, int k, const SourceTerm& src) -> double {
+        if constexpr (Dim == 2){
+            return K::template row<true>(u, o, W, nl + 2, k + 2, coeffs, src);
+        } else {
+            const int j0 = 2 + k*chunk;
+            return K::template range<true>(u, o, j0, std::min(j0 + chunk, nl), coeffs, src);
+        }
+    };
+
+    double local_t = tcur_;
+
+    // sin default(none): las constantes de MPI (MPI_DOUBLE, MPI_SUM...) son globales de la biblioteca
+    #pragma omp parallel
+    {
+        const bool master = omp_get_thread_num() == 0;
+        for (int it=0; it<params_.steps; ++it){
+            const SourceTerm src = source_term();
+            const Real* u = cur;
+            Real* o = nxt;
+
+            // halos del estado confirmado: la fila 1 sube y la fila nl baja
+            #pragma omp master
+            {
+                MPI_Irecv(cur,                 W, type, up_, 1, comm_, &req[0]);
+                MPI_Irecv(cur + (size_t)(nl+1)*W, W, type, dn_, 0, comm_, &req[1]);
+                MPI_Isend(cur + W,             W, type, up_, 0, comm_, &req[2]);
+                MPI_Isend(cur + (size_t)nl*W,  W, type, dn_, 1, comm_, &req[3]);
+            }
+
+            // filas que no leen halos, solapadas con la comunicacion; el hilo
+            // maestro consulta las peticiones entre unidades para que MPI avance
+            auto mid = [&](int k){
+                e_mid[k] = mid_unit(u, o, k, src);
+                if (master){
+                    int done;
+                    MPI_Testall(4, req, &done, MPI_STATUSES_IGNORE);
+                }
+            };
+            if (Dim == 1 || params_.schedule == ScheduleType::Static){
+                #pragma omp for schedule(static, Dim == 2 ? chunk : 1) nowait
+                for (int k=0; k<nmid; ++k) mid(k);
+            } else if (params_.schedule == ScheduleType::Dynamic){
+                #pragma omp for schedule(dynamic, chunk) nowait
+                for (int k=0; k<nmid; ++k) mid(k);
+            } else {
+                #pragma omp for schedule(guided, chunk) nowait
+                for (int k=0; k<nmid; ++k) mid(k);
+            }
+
+            #pragma omp master
+            MPI_Waitall(4, req, MPI_STATUSES_IGNORE);
+            #pragma omp barrier
+
+            #pragma omp for schedule(static, 1)
+            for (int k=0; k<nedge; ++k){
+                e_edge[k] = edge_unit(u, o, k == 0 ? 1 : nl, src);
+            }
+
+            // la fuente avanza al paso siguiente (barrera implicita incluida)
+            if (source_.size() > 0) source_.advanceParallel(1, local_t + params_.dt);
+
+            #pragma omp master
+            {
+                // suma del rank en orden de filas y de los ranks en orden de rank:
+                // cada rank aporta solo su casilla, el resto suma ceros (exacto)
+                double e = e_edge[0];
+                for (int k=0; k<nmid; ++k) e += e_mid[k];
+                if (nedge > 1) e += e_edge[1];
+                std::fill(part.begin(), part.end(), 0.0);
+                part[rank_] = e;
+                MPI_Allreduce(MPI_IN_PLACE, part.data(), size_, MPI_DOUBLE, MPI_SUM, comm_);
+                double E = 0.0;
+                for (int r=0; r<size_; ++r) E += part[r];
+
+                std::swap(cur, nxt);
+                if (root) out.energy(it+1, E);
+                if (frames && it % fe == 0){
+                    // frame del estado recien confirmado, reunido en el rank 0
+                    const size_t n = (size_t)nl * W;
+                    const void* sbuf = cur + W;
+                    if constexpr (!std::is_same<Real, double>::value){
+                        send.assign(cur + W, cur + W + n);
+                        sbuf = send.data();
+                    }
+                    const int k = root ? out.acquireFrame() : -1;
+                    MPI_Gatherv(sbuf, (int)n, MPI_DOUBLE, root ? out.frame(k).data() : nullptr,
+                                counts_.data(), displs_.data(), MPI_DOUBLE, 0, comm_);
+                    if (root) out.submitFrame(k, it, local_t + params_.dt);
+                }
+                local_t += params_.dt;
+            }
+            #pragma omp barrier
+        }
+    }
+    tcur_ = local_t;
+}
@@ -0,0 +1,69 @@
+#pragma once // para que se compile solo una vez
+
+#include <string>
+#include <vector>
+#include <mpi.h>
+
+#include "Types.h"
+#include "AsyncWriter.h"
+#include "SourceEngine.h"
+#include "Stencil.h"
+
+// Descomposicion de dominio con MPI (binario wave_propagation_mpi, `make mpi`).
+//
+// La linea 1D se parte en tramos contiguos de nodos y la grilla 2D en franjas
+// de filas completas (slabs), una por rank. Cada rank guarda sus filas mas una
+// fila de halo arriba y otra abajo (en 1D, un nodo a cada lado). En cada paso
+// los halos se intercambian con MPI_Isend/MPI_Irecv mientras los hilos OpenMP
+// del rank calculan las filas que no los leen; despues se esperan y se
+// calculan las dos filas de borde. Con bordes periodicos el primer y el ultimo
+// rank son vecinos (con un solo rank se intercambia consigo mismo).
+//
+// Cada nodo hace exactamente las mismas operaciones que en WavePropagator::run
+// (mismos kernels Stencil/SIMD, misma fuente), asi las amplitudes y los frames
+// son identicos bit a bit para cualquier numero de ranks. La energia de cada
+// fila (o bloque de `chunk` nodos en 1D) se suma en orden dentro del rank y las
+// sumas de los ranks se combinan con un MPI_Allreduce en orden de rank: el
+// resultado no depende de los hilos por rank y en 2D coincide con el de una
+// corrida de un proceso con P hilos, --schedule static y --chunk Ly/P.
+//
+// Los frames (solo formato binario) se juntan en el rank 0 con MPI_Gatherv y
+// los escribe su hilo de salida; la energia tambien la escribe el rank 0.
+class DistributedPropagator {
+public:
+    DistributedPropagator(const RunParams& params, MPI_Comm comm);
+
+    // inicializa el estado (impulso central) y avanza params.steps pasos
+    void run(const std::string& energy_out);
+
+    int rank() const { return rank_; }
+    int ranks() const { return size_; }
+    int rowBegin() const { return r0_; }     // primera fila (nodo en 1D) propia
+    int rowEnd() const { return r1_; }
+    double time() const { return tcur_; }
+
+private:
+    RunParams params_;
+    MPI_Comm comm_;
+    int rank_ = 0, size_ = 1;
+    bool is2D_;
+    int W_;                // nodos por fila (1 en 1D)
+    int rows_;             // filas globales (N en 1D)
+    int r0_ = 0, r1_ = 0;  // filas propias [r0, r1)
+    std::vector<int> counts_, displs_;   // nodos propios de cada rank (MPI_Gatherv)
+    int up_ = MPI_PROC_NULL, dn_ = MPI_PROC_NULL;
+    double tcur_ = 0.0;
+
+    std::vector<double> omega_local_;    // frecuencias por nodo (con halos en 0)
+    double omega_single_ = 0.0;
+    int single_idx_ = -1;                // indice global del nodo con fuente (modo single)
+    SourceEngine source_;
+
+    void init_source();
+    SourceTerm source_term() const;      // fuente del paso actual en indices locales
+
+    template <class Real, class Acc>
+    void run_impl(const std::string& energy_out);
+    template <int Dim, Boundary B, class Real, class Acc>
+    void run_loop(Real* cur, Real* nxt, AsyncWriter& out);
+};
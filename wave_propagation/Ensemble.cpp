@@ -0,0 +1,310 @@
+#include "Ensemble.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <omp.h>
+
+#include "AlignedBuffer.h"
+#include "SimdKernels.h"
+#include "SourceEngine.h"
+
+namespace {
+
+constexpr int L = kEnsLanes;
+
+// Geometria y fuente de un paso, comunes a todos los carriles del lote
+struct EnsGrid {
+    int Lx, Ly, N;
+    bool is2D, periodic;
+    int single_idx;                 // nodo con fuente puntual (-1 = ninguno)
+    const double* single_val;       // su fuente por carril
+};
+
+// fuente del nodo i en cada carril (incluye el nodo de la fuente puntual)
+inline void node_source(const EnsSource& s, const EnsGrid& g, int i, double* out){
+    for (int m=0; m<L; ++m){
+        if (s.values) out[m] = s.scale[m]*s.values[i*L + m];
+        else out[m] = (i == g.single_idx) ? g.single_val[m] : s.uniform[m];
+    }
+}
+
+// nodo i de todos los carriles con vecinos nb[0..nn) en el orden del stencil
+// (izq, der, arriba, abajo); suma out^2 en e
+inline void lane_point(const double* u, double* out, int i, const int* nb, int nn,
+                       const EnsCoeffs& c, const double* src, double* e){
+    for (int m=0; m<L; ++m){
+        const double ai = u[i*L + m];
+        double acc = 0;
+        for (int k=0; k<nn; ++k) acc += (u[nb[k]*L + m] - ai);
+        const double v = out[i*L + m] = ai + c.dt*(c.D[m]*acc - c.g[m]*ai + src[m]);
+        e[m] += v*v;
+    }
+}
+
+// nodo del borde (1D: extremos; 2D: perimetro), vecinos como Stencil::edge
+void edge(const double* u, double* out, const EnsGrid& g, int x, int y,
+          const EnsCoeffs& c, const EnsSource& s, double* e){
+    int nb[4], nn = 0;
+    if (!g.is2D){
+        const int N = g.N;
+        if (x-1>=0) nb[nn++] = x-1;
+        else if (g.periodic) nb[nn++] = N-1;
+        if (x+1<N) nb[nn++] = x+1;
+        else if (g.periodic) nb[nn++] = 0;
+    } else {
+        const int Lx = g.Lx, Ly = g.Ly, i = y*Lx + x;
+        if (x>0) nb[nn++] = i-1;
+        else if (g.periodic) nb[nn++] = y*Lx + (Lx-1);
+        if (x+1<Lx) nb[nn++] = i+1;
+        else if (g.periodic) nb[nn++] = y*Lx;
+        if (y>0) nb[nn++] = i-Lx;
+        else if (g.periodic) nb[nn++] = (Ly-1)*Lx + x;
+        if (y+1<Ly) nb[nn++] = i+Lx;
+        else if (g.periodic) nb[nn++] = x;
+    }
+    const int i = g.is2D ? y*g.Lx + x : x;
+    double src[L];
+    node_source(s, g, i, src);
+    lane_point(u, out, i, nb, nn, c, src, e);
+}
+
+// tramo interior [i0,i1) (indices de nodo): kernel despachado con el nodo de
+// la fuente puntual pelado (ver stencil_span)
+template <class Kern>
+void interior(const double* u, double* out, const EnsGrid& g, int i0, int i1,
+              const EnsCoeffs& c, const EnsSource& s, double* e, Kern&& kern){
+    const int k = g.single_idx;
+    if (s.values || k < i0 || k >= i1){
+        kern(i0, i1);
+        return;
+    }
+    kern(i0, k);
+    int nb[4] = {k-1, k+1, k-g.Lx, k+g.Lx};
+    double src[L];
+    node_source(s, g, k, src);
+    lane_point(u, out, k, nb, g.is2D ? 4 : 2, c, src, e);
+    kern(k+1, i1);
+}
+
+// un paso de todo el lote; e[m] = energia del miembro m
+void sweep(const double* u, double* out, const EnsGrid& g, const EnsCoeffs& c,
+           const EnsSource& s, double* e){
+    const SimdKernels& K = simd_kernels();
+    if (!g.is2D){
+        const int N = g.N;
+        edge(u, out, g, 0, 0, c, s, e);
+        interior(u, out, g, 1, std::max(1, N-1), c, s, e,
+                 [&](int a, int b){ K.ens_update3(u, out, a, b, c, s, e); });
+        if (N > 1) edge(u, out, g, N-1, 0, c, s, e);
+        return;
+    }
+    const int Lx = g.Lx, Ly = g.Ly;
+    for (int y=0; y<Ly; ++y){
+        if (y==0 || y==Ly-1 || Lx<3){
+            for (int x=0; x<Lx; ++x) edge(u, out, g, x, y, c, s, e);
+            continue;
+        }
+        const int base = y*Lx;
+        edge(u, out, g, 0, y, c, s, e);
+        const double* mid = u + (size_t)base*L;
+        double* orow = out + (size_t)base*L;
+        // el kernel recibe la fila con indices locales (y la fuente desplazada)
+        EnsSource rs = s;
+        if (s.values) rs.values = s.values + (size_t)base*L;
+        interior(u, out, g, base+1, base+Lx-1, c, s, e,
+                 [&](int a, int b){ K.ens_update5(mid - (size_t)Lx*L, mid, mid + (size_t)Lx*L, orow, a - base, b - base, c, rs, e); });
+        edge(u, out, g, Lx-1, y, c, s, e);
+    }
+}
+
+} // namespace
+
+std::vector<EnsembleMember> load_sweep(const std::string& path, const RunParams& base){
+    std::ifstream f(path);
+    if (!f) throw std::runtime_error("no se pudo abrir el barrido " + path);
+    EnsembleMember def;
+    def.D = base.D;
+    def.gamma = base.gamma;
+    def.S0 = base.S0;
+    def.omega = base.omega;
+    def.omega_mu = base.omega_mu;
+    def.omega_sigma = base.omega_sigma;
+
+    std::vector<std::string> cols;
+    std::vector<EnsembleMember> out;
+    std::string line;
+    int lineno = 0;
+    while (std::getline(f, line)){
+        ++lineno;
+        line = line.substr(0, line.find('#'));
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream is(line);
+        std::string tok;
+        std::vector<std::string> toks;
+        while (is >> tok) toks.push_back(tok);
+        if (toks.empty()) continue;
+        if (cols.empty()){
+            for (const std::string& c : toks){
+                if (c != "D" && c != "gamma" && c != "S0" && c != "omega" && c != "omega_mu" &&
+                    c != "omega_sigma" && c != "seed")
+                    throw std::runtime_error("barrido: columna desconocida '" + c + "'");
+            }
+            cols = toks;
+            continue;
+        }
+        if (toks.size() != cols.size())
+            throw std::runtime_error("barrido: la linea " + std::to_string(lineno) + " no tiene " +
+                                     std::to_string(cols.size()) + " columnas");
+        EnsembleMember m = def;
+        for (size_t k=0; k<cols.size(); ++k){
+            const std::string& c = cols[k];
+            if (c == "seed") { m.seed = std::stoll(toks[k]); continue; }
+            const double v = std::stod(toks[k]);
+            if (c == "D") m.D = v;
+            else if (c == "gamma") m.gamma = v;
+            else if (c == "S0") m.S0 = v;
+            else if (c == "omega") m.omega = v;
+            else if (c == "omega_mu") m.omega_mu = v;
+            else m.omega_sigma = v;
+        }
+        out.push_back(m);
+    }
+    if (out.empty()) throw std::runtime_error("el barrido " + path + " no tiene miembros");
+    return out;
+}
+
+EnsemblePropagator::EnsemblePropagator(const RunParams& params, std::vector<EnsembleMember> members)
+    : params_(params), members_(std::move(members))
+{
+    is2D_ = params_.network != "1d";
+    Lx_ = is2D_ ? params_.Lx : params_.N;
+    Ly_ = is2D_ ? params_.Ly : 1;
+    N_ = Lx_ * Ly_;
+    if (N_ <= 0) throw std::runtime_error("ensamble: red vacia");
+    if (params_.noise == NoiseMode::Single){
+        // mismo nodo que WavePropagator
+        single_idx_ = params_.noise_node;
+        if (single_idx_ < 0 || single_idx_ >= N_)
+            single_idx_ = is2D_ ? (Ly_/2)*Lx_ + Lx_/2 : Lx_/2;
+    }
+}
+
+int EnsemblePropagator::batches() const{
+    return (members() + L - 1) / L;
+}
+
+void EnsemblePropagator::write_members(const std::string& path) const{
+    std::ofstream f(path);
+    if (!f) return;
+    f << "member\tbatch\tlane\tD\tgamma\tS0\tomega\tomega_mu\tomega_sigma\tseed\n" << std::setprecision(12);
+    for (int k=0; k<members(); ++k){
+        const EnsembleMember& m = members_[k];
+        f << k << '\t' << k / L << '\t' << k % L << '\t' << m.D << '\t' << m.gamma << '\t' << m.S0 << '\t'
+          << m.omega << '\t' << m.omega_mu << '\t' << m.omega_sigma << '\t' << m.seed << '\n';
+    }
+}
+
+void EnsemblePropagator::run_batch(int b, const std::string& out_dir) const{
+    const int first = b*L;
+    const int count = std::min(L, members() - first);
+    const double dt = params_.dt;
+
+    // coeficientes por carril (relleno: todo en cero, el carril no cambia)
+    EnsCoeffs coeffs{};
+    coeffs.dt = dt;
+    double S0[L] = {};
+    for (int m=0; m<count; ++m){
+        const EnsembleMember& mb = members_[first + m];
+        coeffs.D[m] = mb.D;
+        coeffs.g[m] = mb.gamma;
+        S0[m] = mb.S0;
+    }
+
+    // estado intercalado; lo reserva y lo escribe primero el hilo que avanza el lote
+    AlignedBuffer<double> cur((size_t)N_ * L, 0.0), nxt((size_t)N_ * L, 0.0);
+    const int center = is2D_ ? (Ly_/2)*Lx_ + (Lx_/2) : (Lx_/2);
+    for (int m=0; m<count; ++m) cur[(size_t)center*L + m] = nxt[(size_t)center*L + m] = 1.0;
+
+    // frecuencias de cada miembro con su propio generador (mismo orden de
+    // sorteo que WavePropagator: nodo por nodo)
+    std::vector<double> omega;
+    if (params_.noise == NoiseMode::PerNode) omega.assign((size_t)N_ * L, 0.0);
+    else if (params_.noise != NoiseMode::Off) omega.assign(L, 0.0);
+    for (int m=0; m<count; ++m){
+        const EnsembleMember& mb = members_[first + m];
+        if (params_.noise == NoiseMode::Global){
+            omega[m] = mb.omega;
+            continue;
+        }
+        if (params_.noise == NoiseMode::Off) continue;
+        std::mt19937_64 rng(mb.seed >= 0 ? (uint64_t)mb.seed : std::random_device{}());
+        std::normal_distribution<double> norm(mb.omega_mu, mb.omega_sigma);
+        if (params_.noise == NoiseMode::PerNode){
+            for (int i=0; i<N_; ++i) omega[(size_t)i*L + m] = norm(rng);
+        } else {
+            omega[m] = norm(rng);
+        }
+    }
+    SourceEngine source;
+    source.init(omega.data(), (int)omega.size(), 0.0, dt, params_.src_resync);
+
+    std::vector<std::ofstream> files(count);
+    for (int m=0; m<count; ++m){
+        char name[64];
+        std::snprintf(name, sizeof(name), "/energy_m%04d.dat", first + m);
+        files[m].open(out_dir + name);
+        if (files[m]) files[m] << "# step\tE\n" << std::setprecision(12);
+    }
+
+    double single_val[L] = {};
+    const EnsGrid grid{Lx_, Ly_, N_, is2D_, params_.periodic,
+                       params_.noise == NoiseMode::Single ? single_idx_ : -1, single_val};
+    double t = 0.0;
+    for (int it=0; it<params_.steps; ++it){
+        // fuente del paso (como WavePropagator::source_term, por carril)
+        EnsSource s{};
+        const double* sv = source.values();
+        if (params_.noise == NoiseMode::PerNode){
+            s.values = sv;
+            for (int m=0; m<L; ++m) s.scale[m] = S0[m];
+        } else if (params_.noise == NoiseMode::Global){
+            for (int m=0; m<L; ++m) s.uniform[m] = S0[m]*sv[m];
+        } else if (params_.noise == NoiseMode::Single){
+            for (int m=0; m<L; ++m) single_val[m] = S0[m]*sv[m];
+        }
+
+        double e[L] = {};
+        sweep(cur.data(), nxt.data(), grid, coeffs, s, e);
+        cur.swap(nxt);
+        if (source.size() > 0) source.advance(1, t + dt);
+        t += dt;
+        for (int m=0; m<count; ++m)
+            if (files[m]) files[m] << it+1 << "\t" << e[m] << "\n";
+    }
+}
+
+void EnsemblePropagator::run(const std::string& out_dir, std::ostream& os){
+    std::error_code ec;
+    std::filesystem::create_directories(out_dir, ec);
+    write_members(out_dir + "/members.tsv");
+
+    const int nb = batches();
+    const double t0 = omp_get_wtime();
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int b=0; b<nb; ++b) run_batch(b, out_dir);
+    const double t = omp_get_wtime() - t0;
+
+    const double member_steps = (double)members() * params_.steps;
+    os << "[ensemble] " << members() << " miembros en " << nb << " lotes de " << L
+       << ", " << std::min(nb, omp_get_max_threads()) << " hilos ocupados: " << t << " s, "
+       << std::setprecision(4) << member_steps / std::max(t, 1e-12) << " pasos-miembro/s, "
+       << member_steps * N_ / std::max(t, 1e-12) / 1e9 << " Gnodos/s (resultados en " << out_dir << ")\n"
+       << std::setprecision(6);
+}
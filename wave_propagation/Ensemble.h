@@ -0,0 +1,65 @@
+#pragma once // para que se compile solo una vez
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+// Parametros propios de un miembro del ensamble; lo demas (red, dt, pasos,
+// modo de ruido, resync de la fuente) es comun y sale de RunParams
+struct EnsembleMember {
+    double D = 0.1;
+    double gamma = 0.01;
+    double S0 = 0.0;
+    double omega = 0.0;
+    double omega_mu = 10.0;
+    double omega_sigma = 1.0;
+    long long seed = -1;   // semilla del ruido (-1 = std::random_device)
+};
+
+// Lee un archivo de barrido: una cabecera con los nombres de columna
+// (D, gamma, S0, omega, omega_mu, omega_sigma, seed, en cualquier orden y
+// separados por espacios, tabuladores o comas) y una fila por miembro. Las
+// columnas ausentes toman el valor de `base`; '#' inicia un comentario.
+std::vector<EnsembleMember> load_sweep(const std::string& path, const RunParams& base);
+
+// Ensamble de simulaciones independientes sobre la misma red (--ensemble).
+//
+// Los miembros se agrupan en lotes de kEnsLanes (SimdKernels.h) y cada lote
+// guarda sus amplitudes intercaladas: u[i*kEnsLanes + m] es el nodo i del
+// miembro m, asi cada carga del stencil alimenta un registro SIMD con el mismo
+// nodo de varios miembros, cada uno con su D, gamma y fuente. El interior lo
+// recorren los kernels despachados (ens_update3/ens_update5) y los bordes y el
+// nodo de la fuente puntual se pelan como en Stencil.h. Las amplitudes de cada
+// miembro son identicas bit a bit a las de una corrida de un proceso con sus
+// parametros (y las mismas frecuencias); la energia solo cambia el orden de
+// la suma.
+//
+// Cada lote lo avanza un solo hilo de principio a fin (omp for dynamic sobre
+// lotes): no hay barreras por paso, asi que en grillas chicas el rendimiento
+// escala con los nucleos mientras haya al menos un lote por hilo. Un lote
+// incompleto se rellena con carriles sin difusion, sin amortiguamiento y sin
+// fuente. Cada miembro escribe su traza de energia en
+// <out_dir>/energy_mNNNN.dat (mismo formato que energy_trace.dat) y sus
+// parametros en <out_dir>/members.tsv.
+class EnsemblePropagator {
+public:
+    EnsemblePropagator(const RunParams& params, std::vector<EnsembleMember> members);
+
+    // avanza params.steps pasos todos los miembros; resumen de rendimiento en os
+    void run(const std::string& out_dir, std::ostream& os);
+
+    int members() const { return (int)members_.size(); }
+    int batches() const;
+
+private:
+    RunParams params_;
+    std::vector<EnsembleMember> members_;
+    bool is2D_;
+    int Lx_, Ly_, N_;
+    int single_idx_ = -1;   // nodo de la fuente en modo single
+
+    void run_batch(int b, const std::string& out_dir) const;
+    void write_members(const std::string& path) const;
+};
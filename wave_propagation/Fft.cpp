@@ -0,0 +1,75 @@
+#include "Fft.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+Fft::Fft(int n) : n_(n) {
+    if (n < 1) throw std::runtime_error("fft: largo invalido");
+    pow2_ = (n & (n - 1)) == 0;
+    m_ = 1;
+    while (m_ < (pow2_ ? n : 2*n - 1)) m_ <<= 1;
+
+    int bits = 0;
+    while ((1 << bits) < m_) ++bits;
+    rev_.assign(m_, 0);
+    for (int i=0; i<m_; ++i){
+        int r = 0;
+        for (int b=0; b<bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+        rev_[i] = r;
+    }
+    tw_.resize(std::max(1, m_/2));
+    for (int j=0; j<m_/2; ++j){
+        const double t = -2.0*M_PI*j / m_;
+        tw_[j] = cd(std::cos(t), std::sin(t));
+    }
+
+    if (!pow2_){
+        // k^2 mod 2n en enteros: el angulo no pierde precision con k grande
+        chirp_.resize(n_);
+        for (int k=0; k<n_; ++k){
+            const long long k2 = (long long)k*k % (2LL*n_);
+            const double t = -M_PI*(double)k2 / n_;
+            chirp_[k] = cd(std::cos(t), std::sin(t));
+        }
+        kernel_.assign(m_, cd(0.0, 0.0));
+        kernel_[0] = std::conj(chirp_[0]);
+        for (int k=1; k<n_; ++k) kernel_[k] = kernel_[m_ - k] = std::conj(chirp_[k]);
+        radix2(kernel_.data(), false);
+    }
+}
+
+void Fft::radix2(cd* a, bool inv) const{
+    for (int i=0; i<m_; ++i) if (i < rev_[i]) std::swap(a[i], a[rev_[i]]);
+    for (int len=2; len<=m_; len <<= 1){
+        const int half = len/2, step = m_/len;
+        for (int b=0; b<m_; b+=len){
+            for (int j=0; j<half; ++j){
+                const cd w = inv ? std::conj(tw_[j*step]) : tw_[j*step];
+                const cd x = a[b+j], y = a[b+j+half]*w;
+                a[b+j] = x + y;
+                a[b+j+half] = x - y;
+            }
+        }
+    }
+}
+
+void Fft::forward(cd* a, cd* work) const{
+    if (pow2_){ radix2(a, false); return; }
+    // Bluestein: X_k = w_k * sum_j (a_j w_j) conj(w_{k-j}), con w_k = e^{-pi i k^2/n}
+    for (int k=0; k<n_; ++k) work[k] = a[k]*chirp_[k];
+    std::fill(work + n_, work + m_, cd(0.0, 0.0));
+    radix2(work, false);
+    for (int k=0; k<m_; ++k) work[k] *= kernel_[k];
+    radix2(work, true);
+    const double s = 1.0 / m_;
+    for (int k=0; k<n_; ++k) a[k] = work[k]*chirp_[k]*s;
+}
+
+void Fft::inverse(cd* a, cd* work) const{
+    // inversa = conj(FFT(conj(a))) / n
+    for (int k=0; k<n_; ++k) a[k] = std::conj(a[k]);
+    forward(a, work);
+    const double s = 1.0 / n_;
+    for (int k=0; k<n_; ++k) a[k] = std::conj(a[k])*s;
+}
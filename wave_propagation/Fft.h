@@ -0,0 +1,35 @@
+#pragma once // para que se compile solo una vez
+
+#include <complex>
+#include <vector>
+
+// FFT compleja de largo n cualquiera, sin dependencias externas: radix-2
+// iterativa si n es potencia de 2 y Bluestein (convolucion con una chirp de
+// largo potencia de 2 >= 2n-1) en otro caso. El plan es de solo lectura y
+// cada llamada recibe su espacio de trabajo (workSize() complejos), asi varios
+// hilos pueden transformar filas distintas con el mismo plan.
+class Fft {
+public:
+    using cd = std::complex<double>;
+
+    explicit Fft(int n);
+
+    int size() const { return n_; }
+    size_t workSize() const { return pow2_ ? 0 : (size_t)m_; }
+
+    // X_k = sum_j a_j e^{-2 pi i jk/n}, en el lugar
+    void forward(cd* a, cd* work) const;
+    // a_j = (1/n) sum_k X_k e^{+2 pi i jk/n}, en el lugar
+    void inverse(cd* a, cd* work) const;
+
+private:
+    int n_;
+    int m_;          // largo de la FFT radix-2 interna (n o la de Bluestein)
+    bool pow2_;
+    std::vector<int> rev_;    // permutacion bit-reversal de largo m_
+    std::vector<cd> tw_;      // e^{-2 pi i j/m}, j < m/2
+    std::vector<cd> chirp_;   // e^{-pi i k^2/n} (Bluestein)
+    std::vector<cd> kernel_;  // FFT de la chirp conjugada extendida (Bluestein)
+
+    void radix2(cd* a, bool inv) const;
+};
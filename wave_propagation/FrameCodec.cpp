@@ -0,0 +1,231 @@
+#include "FrameCodec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <omp.h>
+
+namespace {
+
+constexpr char kMagic[8] = {'W','A','V','E','F','R','Z','1'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kBlockElems = 65536;   // ~512 KiB de residuos por bloque
+constexpr int kHashBits = 16;
+constexpr int kMinMatch = 4;
+constexpr size_t kMaxOffset = 65535;
+
+template <class T>
+inline void store_le(char* dst, T v){
+    std::memcpy(dst, &v, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    std::reverse(dst, dst + sizeof(T));
+#endif
+}
+
+template <class T>
+inline T load_le(const char* src){
+    char b[sizeof(T)];
+    std::memcpy(b, src, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    std::reverse(b, b + sizeof(T));
+#endif
+    T v;
+    std::memcpy(&v, b, sizeof(T));
+    return v;
+}
+
+inline uint32_t read32(const uint8_t* p){
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint32_t hash4(uint32_t v){ return (v * 2654435761u) >> (32 - kHashBits); }
+
+// largo >= 15 en el token: el resto en bytes de 255 y uno final < 255
+inline void put_length(std::vector<uint8_t>& dst, size_t len){
+    while (len >= 255){ dst.push_back(255); len -= 255; }
+    dst.push_back((uint8_t)len);
+}
+
+inline void put_sequence(std::vector<uint8_t>& dst, const uint8_t* lit, size_t nlit, size_t off, size_t mlen){
+    const size_t m = mlen >= kMinMatch ? mlen - kMinMatch : 0;
+    dst.push_back((uint8_t)((std::min<size_t>(nlit, 15) << 4) | std::min<size_t>(m, 15)));
+    if (nlit >= 15) put_length(dst, nlit - 15);
+    dst.insert(dst.end(), lit, lit + nlit);
+    if (mlen == 0) return;   // ultima secuencia
+    dst.push_back((uint8_t)(off & 0xff));
+    dst.push_back((uint8_t)(off >> 8));
+    if (m >= 15) put_length(dst, m - 15);
+}
+
+inline uint64_t zigzag(int64_t v){ return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+
+} // namespace
+
+void lz_compress(const uint8_t* src, size_t n, std::vector<uint8_t>& dst, std::vector<int>& table){
+    table.assign((size_t)1 << kHashBits, -1);
+    size_t anchor = 0, ip = 0;
+    // sin match los saltos crecen (datos que no comprimen se recorren rapido)
+    int misses = 0;
+    while (n >= kMinMatch && ip + kMinMatch <= n){
+        const uint32_t v = read32(src + ip);
+        const uint32_t h = hash4(v);
+        const int cand = table[h];
+        table[h] = (int)ip;
+        if (cand >= 0 && ip - (size_t)cand <= kMaxOffset && read32(src + cand) == v){
+            size_t len = kMinMatch;
+            while (ip + len < n && src[cand + len] == src[ip + len]) ++len;
+            // el match puede empezar antes (literales repetidos)
+            size_t back = 0;
+            while (ip - back > anchor && (size_t)cand > back && src[ip - back - 1] == src[cand - back - 1]) ++back;
+            put_sequence(dst, src + anchor, ip - back - anchor, ip - (size_t)cand, len + back);
+            ip += len;
+            anchor = ip;
+            misses = 0;
+            // posiciones del final del match en la tabla
+            if (ip >= 2 && ip - 2 + kMinMatch <= n) table[hash4(read32(src + ip - 2))] = (int)(ip - 2);
+            continue;
+        }
+        ip += 1 + (misses++ >> 5);
+    }
+    put_sequence(dst, src + anchor, n - anchor, 0, 0);
+}
+
+bool CompressedFrameWriter::open(const std::string& path, int nx, int ny, FrameDtype dtype, double tol,
+                                 int keyframe, int threads, bool append, int64_t keep_before){
+    close();
+    n_ = (size_t)nx * ny;
+    tol_ = tol > 0.0 ? tol : 0.0;
+    keyframe_ = std::max(1, keyframe);
+    threads_ = std::max(1, threads);
+    const uint32_t value_size = dtype == FrameDtype::F32 ? 4u : 8u;
+    word_size_ = tol_ > 0.0 ? 8u : value_size;
+    // bloques de filas enteras en 2D
+    block_ = kBlockElems;
+    if (ny > 1) block_ = std::max<size_t>(1, kBlockElems / (size_t)nx) * (size_t)nx;
+    block_ = std::min(block_, std::max<size_t>(1, n_));
+    const size_t nblocks = (n_ + block_ - 1) / block_;
+    planes_.assign(nblocks, {});
+    out_.assign(nblocks, {});
+    prev_.assign(n_, 0);
+    frames_ = 0;
+    clamped_ = 0;
+    raw_bytes_ = stored_bytes_ = encode_s_ = 0.0;
+
+    char hdr[sizeof(CompressedFileHeader)] = {0};
+    std::memcpy(hdr, kMagic, sizeof(kMagic));
+    store_le<uint32_t>(hdr + 8,  kVersion);
+    store_le<uint32_t>(hdr + 12, word_size_);
+    store_le<uint32_t>(hdr + 16, (uint32_t)nx);
+    store_le<uint32_t>(hdr + 20, (uint32_t)ny);
+    store_le<double>(hdr + 24, tol_);
+    store_le<uint32_t>(hdr + 32, (uint32_t)keyframe_);
+    store_le<uint32_t>(hdr + 36, (uint32_t)block_);
+    store_le<uint32_t>(hdr + 40, value_size);
+
+    std::error_code ec;
+    if (append && std::filesystem::exists(path, ec)){
+        // solo se agrega con la misma configuracion; el primer frame nuevo es clave
+        std::ifstream in(path, std::ios::binary);
+        char old[sizeof(CompressedFileHeader)];
+        if (in.read(old, sizeof(old)) && std::memcmp(old, hdr, sizeof(hdr)) == 0){
+            const uint64_t size = std::filesystem::file_size(path, ec);
+            uint64_t off = sizeof(CompressedFileHeader);
+            // descarta un frame incompleto y los posteriores al punto de continuacion
+            while (off + sizeof(CompressedFrameHeader) <= size){
+                char fh[sizeof(CompressedFrameHeader)];
+                in.seekg((std::streamoff)off);
+                if (!in.read(fh, sizeof(fh))) break;
+                const uint64_t payload = load_le<uint64_t>(fh + 24);
+                if (load_le<int64_t>(fh) >= keep_before || off + sizeof(fh) + payload > size) break;
+                off += sizeof(fh) + payload;
+            }
+            in.close();
+            if (!ec && off != size) std::filesystem::resize_file(path, off, ec);
+            f_.open(path, std::ios::binary | std::ios::app);
+            return f_.is_open();
+        }
+    }
+    f_.open(path, std::ios::binary | std::ios::trunc);
+    if (!f_) return false;
+    f_.write(hdr, sizeof(hdr));
+    return true;
+}
+
+long CompressedFrameWriter::encode_block(int b, const double* amp, bool delta, std::vector<int>& table){
+    const size_t i0 = (size_t)b * block_;
+    const size_t i1 = std::min(n_, i0 + block_);
+    const size_t n = i1 - i0;
+    const size_t W = word_size_;
+    std::vector<uint8_t>& planes = planes_[b];
+    planes.resize(n * W);
+    long clamped = 0;
+    const double inv = tol_ > 0.0 ? 1.0 / (2.0*tol_) : 0.0;
+    const double qmax = 4.0e18;
+    uint64_t last = 0;   // palabra del nodo anterior del bloque (frame clave)
+    for (size_t i=i0; i<i1; ++i){
+        uint64_t w, r;
+        if (tol_ > 0.0){
+            double q = amp[i] * inv;
+            if (!(std::fabs(q) <= qmax)){   // fuera de rango o NaN: se satura
+                q = std::isnan(q) ? 0.0 : std::copysign(qmax, q);
+                ++clamped;
+            }
+            w = (uint64_t)std::llround(q);
+            r = zigzag((int64_t)(w - (delta ? prev_[i] : last)));
+        } else {
+            if (W == 4){
+                const float f = (float)amp[i];
+                uint32_t u;
+                std::memcpy(&u, &f, 4);
+                w = u;
+            } else {
+                std::memcpy(&w, &amp[i], 8);
+            }
+            r = w ^ (delta ? prev_[i] : last);
+        }
+        prev_[i] = w;
+        last = w;
+        const size_t k = i - i0;
+        for (size_t p=0; p<W; ++p) planes[p*n + k] = (uint8_t)(r >> (8*p));
+    }
+    std::vector<uint8_t>& out = out_[b];
+    out.clear();
+    lz_compress(planes.data(), planes.size(), out, table);
+    return clamped;
+}
+
+void CompressedFrameWriter::write(int64_t step, double time, const double* amp){
+    if (!f_.is_open()) return;
+    const double t0 = omp_get_wtime();
+    const bool delta = frames_ % keyframe_ != 0;
+    const int nblocks = (int)out_.size();
+    long clamped = 0;
+    #pragma omp parallel num_threads(threads_) reduction(+:clamped)
+    {
+        std::vector<int> table;   // tabla de hash del LZ, una por hilo
+        #pragma omp for schedule(dynamic, 1)
+        for (int b=0; b<nblocks; ++b) clamped += encode_block(b, amp, delta, table);
+    }
+    encode_s_ += omp_get_wtime() - t0;
+    clamped_ += clamped;
+
+    uint64_t payload = 4ull * nblocks;
+    for (const auto& o : out_) payload += o.size();
+    std::vector<char> head(sizeof(CompressedFrameHeader) + 4ull * nblocks);
+    store_le<int64_t>(head.data(), step);
+    store_le<double>(head.data() + 8, time);
+    store_le<uint32_t>(head.data() + 16, delta ? 1u : 0u);
+    store_le<uint32_t>(head.data() + 20, (uint32_t)nblocks);
+    store_le<uint64_t>(head.data() + 24, payload);
+    for (int b=0; b<nblocks; ++b)
+        store_le<uint32_t>(head.data() + sizeof(CompressedFrameHeader) + 4*b, (uint32_t)out_[b].size());
+    f_.write(head.data(), (std::streamsize)head.size());
+    for (const auto& o : out_) f_.write(reinterpret_cast<const char*>(o.data()), (std::streamsize)o.size());
+
+    ++frames_;
+    raw_bytes_ += 8.0 * n_;
+    stored_bytes_ += sizeof(CompressedFrameHeader) + (double)payload;
+}
@@ -0,0 +1,105 @@
+#pragma once // para que se compile solo una vez
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+// Frames comprimidos (--frame-format compressed, results/frames/frames.wfz).
+//
+//   cabecera de archivo (64 bytes):
+//     char     magic[8]   = "WAVEFRZ1"
+//     uint32   version    = 1
+//     uint32   word_size  bytes por residuo: 8, o 4 sin perdida con --frame-dtype f32
+//     uint32   nx, ny     (1D: nx = N, ny = 1)
+//     float64  tol        cota del error absoluto (0 = sin perdida)
+//     uint32   keyframe   cada cuantos frames uno independiente (1 = todos)
+//     uint32   block_elems nodos por bloque (filas enteras en 2D; el ultimo puede ser menor)
+//     uint32   value_size 8 (float64) o 4 (float32) al decodificar
+//     relleno hasta 64 bytes
+//   por frame:
+//     int64    step
+//     float64  time
+//     uint32   flags      bit 0: delta contra el frame anterior
+//     uint32   nblocks
+//     uint64   payload    bytes que siguen (tabla + bloques)
+//     uint32   size[nblocks]
+//     bloques comprimidos, en orden
+//
+// Cada bloque se codifica por separado (en paralelo):
+//  1. palabra por nodo: con tol > 0, q = round(a / 2tol) (int64, |a - 2tol q| <= tol);
+//     sin perdida, los bits del double (o del float).
+//  2. residuo: en un frame clave contra el nodo anterior del bloque, en un
+//     frame delta contra el mismo nodo del frame anterior. Los enteros se
+//     restan y pasan por zigzag; los bits se combinan con XOR.
+//  3. los residuos se separan en planos de bytes (byte 0 de todos, byte 1 de
+//     todos, ...): los planos altos quedan casi en cero.
+//  4. LZ tipo LZ4 sobre los planos: token (literales << 4 | largo - 4, 15 =
+//     continua en bytes de 255), literales, offset de 16 bits, resto del largo.
+//     La ultima secuencia no tiene match.
+// Todo little-endian. scripts/frame_codec.py decodifica.
+struct CompressedFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t word_size;
+    uint32_t nx, ny;
+    double tol;
+    uint32_t keyframe;
+    uint32_t block_elems;
+    uint32_t value_size;
+    uint8_t pad[20];
+};
+
+struct CompressedFrameHeader {
+    int64_t step;
+    double time;
+    uint32_t flags;
+    uint32_t nblocks;
+    uint64_t payload;
+};
+
+static_assert(sizeof(CompressedFileHeader) == 64, "cabecera de archivo de 64 bytes");
+static_assert(sizeof(CompressedFrameHeader) == 32, "cabecera de frame de 32 bytes");
+
+// LZ de bloques (paso 4): agrega la version comprimida de src al final de dst
+void lz_compress(const uint8_t* src, size_t n, std::vector<uint8_t>& dst, std::vector<int>& table);
+
+class CompressedFrameWriter {
+public:
+    // threads: hilos que comprimen los bloques de cada frame (OpenMP en el hilo
+    // que escribe). append/keep_before como FrameWriter::open.
+    bool open(const std::string& path, int nx, int ny, FrameDtype dtype, double tol, int keyframe,
+              int threads, bool append = false, int64_t keep_before = INT64_MAX);
+    bool isOpen() const { return f_.is_open(); }
+    void write(int64_t step, double time, const double* amp);
+    void flush(){ if (f_.is_open()) f_.flush(); }
+    void close(){ if (f_.is_open()) f_.close(); }
+
+    // totales desde open(): frames, bytes crudos (nx*ny*8 por frame), bytes
+    // escritos, segundos de compresion y nodos fuera del rango de cuantizacion
+    long frames() const { return frames_; }
+    double rawBytes() const { return raw_bytes_; }
+    double storedBytes() const { return stored_bytes_; }
+    double encodeSeconds() const { return encode_s_; }
+    long clamped() const { return clamped_; }
+
+private:
+    std::ofstream f_;
+    size_t n_ = 0;
+    size_t block_ = 1;
+    uint32_t word_size_ = 8;
+    double tol_ = 0.0;
+    int keyframe_ = 1;
+    int threads_ = 1;
+    long frames_ = 0;
+    long clamped_ = 0;
+    double raw_bytes_ = 0.0, stored_bytes_ = 0.0, encode_s_ = 0.0;
+    std::vector<uint64_t> prev_;                 // palabras del frame anterior
+    std::vector<std::vector<uint8_t>> planes_;   // residuos en planos, por bloque
+    std::vector<std::vector<uint8_t>> out_;      // bloque comprimido
+
+    long encode_block(int b, const double* amp, bool delta, std::vector<int>& table);
+};
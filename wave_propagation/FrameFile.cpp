@@ -0,0 +1,108 @@
+#include "FrameFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+constexpr char kMagic[8] = {'W','A','V','E','F','R','M','1'};
+constexpr uint32_t kVersion = 1;
+
+// copia v a dst en little-endian (el formato es LE en cualquier host)
+template <class T>
+inline void store_le(char* dst, T v){
+    std::memcpy(dst, &v, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    std::reverse(dst, dst + sizeof(T));
+#endif
+}
+
+template <class T>
+inline T load_le(const char* src){
+    char b[sizeof(T)];
+    std::memcpy(b, src, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    std::reverse(b, b + sizeof(T));
+#endif
+    T v;
+    std::memcpy(&v, b, sizeof(T));
+    return v;
+}
+
+inline uint32_t elem_size(FrameDtype d){ return d == FrameDtype::F32 ? 4u : 8u; }
+
+} // namespace
+
+size_t FrameWriter::recordBytes() const{
+    return sizeof(FrameRecordHeader) + (size_t)nx_ * ny_ * elem_size(dtype_);
+}
+
+bool FrameWriter::open(const std::string& path, int nx, int ny, FrameDtype dtype, bool append,
+                       int64_t keep_before){
+    close();
+    nx_ = nx; ny_ = ny; dtype_ = dtype;
+    const uint64_t rec = recordBytes();
+
+    char hdr[sizeof(FrameFileHeader)] = {0};
+    std::memcpy(hdr, kMagic, sizeof(kMagic));
+    store_le<uint32_t>(hdr + 8,  kVersion);
+    store_le<uint32_t>(hdr + 12, elem_size(dtype));
+    store_le<uint32_t>(hdr + 16, (uint32_t)nx);
+    store_le<uint32_t>(hdr + 20, (uint32_t)ny);
+    store_le<uint64_t>(hdr + 24, rec);
+
+    std::error_code ec;
+    if (append && std::filesystem::exists(path, ec)){
+        // solo se agrega si el archivo es del mismo formato y tamano de frame
+        std::ifstream in(path, std::ios::binary);
+        char old[sizeof(FrameFileHeader)];
+        if (in.read(old, sizeof(old)) && std::memcmp(old, hdr, 32) == 0){
+            // descarta un frame incompleto al final antes de seguir escribiendo
+            const uint64_t size = std::filesystem::file_size(path, ec);
+            uint64_t whole = sizeof(FrameFileHeader) + (size - sizeof(FrameFileHeader)) / rec * rec;
+            // y los frames posteriores al punto de continuacion
+            for (uint64_t off = sizeof(FrameFileHeader); off < whole; off += rec){
+                char sb[8];
+                in.seekg((std::streamoff)off);
+                if (!in.read(sb, sizeof(sb))) break;
+                if (load_le<int64_t>(sb) >= keep_before){ whole = off; break; }
+            }
+            in.close();
+            if (!ec && whole != size) std::filesystem::resize_file(path, whole, ec);
+            f_.open(path, std::ios::binary | std::ios::app);
+            buf_.resize(rec);
+            return f_.is_open();
+        }
+    }
+    f_.open(path, std::ios::binary | std::ios::trunc);
+    if (!f_) return false;
+    f_.write(hdr, sizeof(hdr));
+    buf_.resize(rec);
+    return (bool)f_;
+}
+
+void FrameWriter::write(int64_t step, double time, const double* amp){
+    if (!f_.is_open()) return;
+    char* p = buf_.data();
+    std::memset(p, 0, sizeof(FrameRecordHeader));
+    store_le<int64_t>(p, step);
+    store_le<double>(p + 8, time);
+    store_le<uint32_t>(p + 16, (uint32_t)nx_);
+    store_le<uint32_t>(p + 20, (uint32_t)ny_);
+    char* d = p + sizeof(FrameRecordHeader);
+    const size_t n = (size_t)nx_ * ny_;
+    if (dtype_ == FrameDtype::F32){
+        for (size_t i=0; i<n; ++i) store_le<float>(d + 4*i, (float)amp[i]);
+    } else {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        for (size_t i=0; i<n; ++i) store_le<double>(d + 8*i, amp[i]);
+#else
+        // host little-endian: las amplitudes se escriben tal cual, sin copia
+        f_.write(p, sizeof(FrameRecordHeader));
+        f_.write(reinterpret_cast<const char*>(amp), (std::streamsize)(n * sizeof(double)));
+        return;
+#endif
+    }
+    f_.write(p, (std::streamsize)buf_.size());
+}
@@ -0,0 +1,66 @@
+#pragma once // para que se compile solo una vez
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+// Formato binario de frames (un solo archivo, se le agregan frames al final).
+//
+//   cabecera de archivo (64 bytes):
+//     char     magic[8]   = "WAVEFRM1"
+//     uint32   version    = 1
+//     uint32   elem_size  = 8 (float64) o 4 (float32)
+//     uint32   nx, ny     (1D: nx = N, ny = 1)
+//     uint64   record_bytes (cabecera de frame + datos)
+//     relleno hasta 64 bytes
+//   por frame (registro de tamano fijo):
+//     int64    step
+//     float64  time
+//     uint32   nx, ny
+//     uint64   reservado
+//     nx*ny amplitudes (fila mayor), little-endian
+//
+// Como todos los registros miden lo mismo, el frame k empieza en
+// 64 + k*record_bytes: los lectores pueden mapear el archivo (numpy.memmap)
+// e indexar por numero de frame sin parsear nada. Un frame incompleto al
+// final (corte del programa) se ignora.
+struct FrameFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t elem_size;
+    uint32_t nx, ny;
+    uint64_t record_bytes;
+    uint8_t pad[32];
+};
+
+struct FrameRecordHeader {
+    int64_t step;
+    double time;
+    uint32_t nx, ny;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(FrameFileHeader) == 64, "cabecera de archivo de 64 bytes");
+static_assert(sizeof(FrameRecordHeader) == 32, "cabecera de frame de 32 bytes");
+
+class FrameWriter {
+    std::ofstream f_;
+    int nx_ = 0, ny_ = 0;
+    FrameDtype dtype_ = FrameDtype::F64;
+    std::vector<char> buf_;    // registro armado (cabecera + datos convertidos)
+public:
+    // Crea el archivo (o agrega al final si append=true y la cabecera coincide).
+    // Al agregar se descartan los frames con step >= keep_before (continuacion
+    // desde un checkpoint). Devuelve false si no se pudo abrir.
+    bool open(const std::string& path, int nx, int ny, FrameDtype dtype, bool append=false,
+              int64_t keep_before=INT64_MAX);
+    bool isOpen() const { return f_.is_open(); }
+    void write(int64_t step, double time, const double* amp);
+    void flush(){ if (f_.is_open()) f_.flush(); }
+    void close(){ if (f_.is_open()) f_.close(); }
+
+    size_t recordBytes() const;
+};
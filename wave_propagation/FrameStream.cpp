@@ -0,0 +1,112 @@
+#include "FrameStream.h"
+
+#include <cstring>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define WAVE_HAVE_SHM 1
+#endif
+
+namespace {
+
+constexpr char kMagic[8] = {'W','A','V','E','S','H','M','1'};
+constexpr uint32_t kVersion = 1;
+
+} // namespace
+
+bool FrameStream::open(const std::string& name, int nx, int ny, int slots, FrameDtype dtype){
+    close();
+#ifdef WAVE_HAVE_SHM
+    // nombre POSIX: una sola barra, al principio
+    std::string n = name;
+    if (n.empty() || n[0] != '/') n = "/" + n;
+    if (n.size() < 2 || n.find('/', 1) != std::string::npos) return false;
+    slots = slots > 0 ? slots : 1;
+    const size_t esz = dtype == FrameDtype::F32 ? 4 : 8;
+    const size_t elems = (size_t)nx * ny;
+    const size_t slot_bytes = (sizeof(StreamSlotHeader) + elems*esz + 63) / 64 * 64;
+    const size_t bytes = sizeof(StreamHeader) + slot_bytes * slots;
+
+    // un segmento viejo con el mismo nombre (corrida cortada) se reemplaza
+    shm_unlink(n.c_str());
+    const int fd = shm_open(n.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) return false;
+    if (ftruncate(fd, (off_t)bytes) != 0){
+        ::close(fd);
+        shm_unlink(n.c_str());
+        return false;
+    }
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED){
+        shm_unlink(n.c_str());
+        return false;
+    }
+
+    // ftruncate deja todo en cero: seq = 0 significa slot todavia sin frame
+    StreamHeader* h = new (p) StreamHeader;
+    h->version = kVersion;
+    h->elem_size = (uint32_t)esz;
+    h->nx = (uint32_t)nx;
+    h->ny = (uint32_t)ny;
+    h->slots = (uint32_t)slots;
+    h->slot_bytes = slot_bytes;
+    h->data_offset = sizeof(StreamHeader);
+    h->pid = (int64_t)getpid();
+    h->published.store(0, std::memory_order_relaxed);
+    char* data = static_cast<char*>(p) + sizeof(StreamHeader);
+    for (int s=0; s<slots; ++s) new (data + (size_t)s*slot_bytes) StreamSlotHeader;
+    // la firma va al final: un lector que la ve ya ve la cabecera completa
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(h->magic, kMagic, sizeof(kMagic));
+
+    name_ = n;
+    base_ = p;
+    bytes_ = bytes;
+    elems_ = elems;
+    frames_ = 0;
+    dtype_ = dtype;
+    return true;
+#else
+    (void)name; (void)nx; (void)ny; (void)slots; (void)dtype;
+    return false;
+#endif
+}
+
+void FrameStream::publish(int64_t step, double time, const double* amp){
+    if (!base_) return;
+    StreamHeader* h = header();
+    const uint64_t f = frames_;
+    char* slot = static_cast<char*>(base_) + h->data_offset + (f % h->slots) * h->slot_bytes;
+    StreamSlotHeader* sh = reinterpret_cast<StreamSlotHeader*>(slot);
+
+    // seq impar: un lector que empiece ahora o que ya este copiando descarta el slot
+    sh->seq.store(2*f + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    sh->step = step;
+    sh->time = time;
+    sh->frame = f;
+    char* dst = slot + sizeof(StreamSlotHeader);
+    if (dtype_ == FrameDtype::F32){
+        float* d = reinterpret_cast<float*>(dst);
+        for (size_t i=0; i<elems_; ++i) d[i] = (float)amp[i];
+    } else {
+        std::memcpy(dst, amp, elems_ * sizeof(double));
+    }
+    sh->seq.store(2*f + 2, std::memory_order_release);
+    h->published.store(f + 1, std::memory_order_release);
+    frames_ = f + 1;
+}
+
+void FrameStream::close(){
+#ifdef WAVE_HAVE_SHM
+    if (!base_) return;
+    header()->state.store(1, std::memory_order_release);
+    munmap(base_, bytes_);
+    shm_unlink(name_.c_str());
+    base_ = nullptr;
+#endif
+}
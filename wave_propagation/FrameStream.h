@@ -0,0 +1,94 @@
+#pragma once // para que se compile solo una vez
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+// Transmision en vivo de frames (--stream <nombre>) por un anillo en memoria
+// compartida POSIX (/dev/shm/<nombre>). El simulador escribe y nunca espera a
+// los lectores: un lector lento pierde frames, no frena la corrida.
+//
+//   cabecera (128 bytes):
+//     char     magic[8]   = "WAVESHM1"
+//     uint32   version    = 1
+//     uint32   elem_size  = 8 (float64) o 4 (float32)
+//     uint32   nx, ny     (1D: nx = N, ny = 1)
+//     uint32   slots
+//     uint32   state      0 = corriendo, 1 = terminada
+//     uint64   slot_bytes (cabecera de slot + datos, multiplo de 64)
+//     uint64   data_offset (= 128)
+//     uint64   published  frames publicados hasta ahora
+//     int64    pid        del simulador
+//     relleno hasta 128 bytes
+//   slot s (en data_offset + s*slot_bytes):
+//     uint64   seq        2f+1 mientras se escribe el frame f, 2f+2 al terminar
+//     int64    step
+//     float64  time
+//     uint64   frame      f
+//     relleno hasta 64 bytes, despues nx*ny amplitudes (fila mayor)
+// Todo en el orden de bytes del host (el segmento no sale de la maquina).
+//
+// El frame f va al slot f % slots. Para leerlo: mirar seq (par e igual a
+// 2f+2), leer los datos y volver a mirar seq; si cambio, el slot se reescribio
+// mientras tanto y la lectura se descarta (seqlock). Los datos se pueden usar
+// sin copiar (numpy sobre el mmap) validando seq despues de usarlos.
+struct StreamHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t elem_size;
+    uint32_t nx, ny;
+    uint32_t slots;
+    std::atomic<uint32_t> state;
+    uint64_t slot_bytes;
+    uint64_t data_offset;
+    std::atomic<uint64_t> published;
+    int64_t pid;
+    uint8_t pad[64];
+};
+
+struct StreamSlotHeader {
+    std::atomic<uint64_t> seq;
+    int64_t step;
+    double time;
+    uint64_t frame;
+    uint8_t pad[32];
+};
+
+static_assert(sizeof(StreamHeader) == 128, "cabecera del anillo de 128 bytes");
+static_assert(sizeof(StreamSlotHeader) == 64, "cabecera de slot de 64 bytes");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "contadores sin bloqueo en memoria compartida");
+
+class FrameStream {
+public:
+    FrameStream() = default;
+    ~FrameStream(){ close(); }
+    FrameStream(const FrameStream&) = delete;
+    FrameStream& operator=(const FrameStream&) = delete;
+
+    // Crea (o reemplaza) el segmento /<nombre>. Devuelve false si no se pudo.
+    bool open(const std::string& name, int nx, int ny, int slots, FrameDtype dtype);
+    bool isOpen() const { return base_ != nullptr; }
+    const std::string& name() const { return name_; }
+
+    // copia el frame al slot siguiente (convierte a float32 si hace falta)
+    void publish(int64_t step, double time, const double* amp);
+    uint64_t published() const { return frames_; }
+
+    // marca la corrida como terminada y borra el nombre (los lectores que ya
+    // mapearon el segmento lo conservan hasta desmapearlo)
+    void close();
+
+private:
+    std::string name_;
+    void* base_ = nullptr;
+    size_t bytes_ = 0;
+    size_t elems_ = 0;
+    uint64_t frames_ = 0;
+    FrameDtype dtype_ = FrameDtype::F32;
+
+    StreamHeader* header() const { return static_cast<StreamHeader*>(base_); }
+};
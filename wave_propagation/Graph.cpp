@@ -0,0 +1,339 @@
+#include "Graph.h"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <omp.h>
+
+namespace {
+
+bool ends_with(const std::string& s, const std::string& suf){
+    if (s.size() < suf.size()) return false;
+    std::string t = s.substr(s.size() - suf.size());
+    std::transform(t.begin(), t.end(), t.begin(), [](unsigned char c){ return (char)std::tolower(c); });
+    return t == suf;
+}
+
+// CSR simetrico a partir de pares (u,v): sin lazos, vecinos ordenados y unicos
+Graph build_csr(long long n, const std::vector<std::pair<int,int>>& edges){
+    if (n > INT_MAX) throw std::runtime_error("grafo demasiado grande");
+    Graph g;
+    g.n = (int)n;
+    std::vector<int> deg(g.n + 1, 0);
+    for (const auto& e : edges){
+        if (e.first == e.second) continue;
+        ++deg[e.first];
+        ++deg[e.second];
+    }
+    g.off.assign(g.n + 1, 0);
+    for (int i=0; i<g.n; ++i) g.off[i+1] = g.off[i] + deg[i];
+    std::vector<int> adj(g.off[g.n]);
+    std::vector<int> pos(g.off.begin(), g.off.end() - 1);
+    for (const auto& e : edges){
+        if (e.first == e.second) continue;
+        adj[pos[e.first]++] = e.second;
+        adj[pos[e.second]++] = e.first;
+    }
+    // orden y duplicados por nodo, compactando en el mismo arreglo
+    int k = 0;
+    for (int i=0; i<g.n; ++i){
+        const int b = g.off[i], e = g.off[i+1];
+        std::sort(adj.begin() + b, adj.begin() + e);
+        const int k0 = k;
+        for (int j=b; j<e; ++j){
+            if (j > b && adj[j] == adj[j-1]) continue;
+            adj[k++] = adj[j];
+        }
+        g.off[i] = k0;
+    }
+    g.off[g.n] = k;
+    adj.resize(k);
+    g.adj = std::move(adj);
+    return g;
+}
+
+// BFS desde s sobre los nodos con stamp[v] != id; deja en `last` el ultimo nivel
+int bfs_levels(const Graph& g, int s, std::vector<int>& stamp, int id, std::vector<int>& queue, std::vector<int>& last){
+    queue.clear();
+    queue.push_back(s);
+    stamp[s] = id;
+    size_t head = 0, level_begin = 0;
+    int ecc = 0;
+    while (true){
+        const size_t level_end = queue.size();
+        for (; head < level_end; ++head){
+            const int v = queue[head];
+            for (int k=g.off[v]; k<g.off[v+1]; ++k){
+                const int w = g.adj[k];
+                if (stamp[w] != id){ stamp[w] = id; queue.push_back(w); }
+            }
+        }
+        if (queue.size() == level_end) break;
+        level_begin = level_end;
+        ++ecc;
+    }
+    last.assign(queue.begin() + level_begin, queue.end());
+    return ecc;
+}
+
+} // namespace
+
+Graph load_graph(const std::string& path){
+    std::ifstream f(path);
+    if (!f) throw std::runtime_error("no se pudo abrir el grafo: " + path);
+    std::vector<std::pair<int,int>> edges;
+    long long n = 0;
+    std::string line;
+    auto bad = [&](const std::string& why){
+        return std::runtime_error(path + ": " + why + " (linea: '" + line + "')");
+    };
+
+    if (ends_with(path, ".mtx")){
+        if (!std::getline(f, line) || line.rfind("%%MatrixMarket", 0) != 0)
+            throw bad("falta la cabecera %%MatrixMarket");
+        std::string lower = line;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c){ return (char)std::tolower(c); });
+        if (lower.find("coordinate") == std::string::npos)
+            throw bad("solo se admite el formato coordinate");
+        long long rows = -1, cols = -1, nnz = -1;
+        while (std::getline(f, line)){
+            if (line.empty() || line[0] == '%') continue;
+            std::istringstream is(line);
+            if (!(is >> rows >> cols >> nnz) || rows < 0 || cols < 0 || nnz < 0) throw bad("linea de tamano invalida");
+            break;
+        }
+        if (rows < 0) throw bad("falta la linea de tamano");
+        n = std::max(rows, cols);
+        edges.reserve((size_t)nnz);
+        while ((long long)edges.size() < nnz && std::getline(f, line)){
+            if (line.empty() || line[0] == '%') continue;
+            std::istringstream is(line);
+            long long i, j;
+            if (!(is >> i >> j)) throw bad("entrada invalida");
+            if (i < 1 || j < 1 || i > n || j > n) throw bad("indice fuera de rango");
+            edges.emplace_back((int)(i - 1), (int)(j - 1));
+        }
+        if ((long long)edges.size() < nnz) throw std::runtime_error(path + ": faltan entradas");
+    } else {
+        while (std::getline(f, line)){
+            const size_t c = line.find_first_of("#%");
+            const std::string body = line.substr(0, c);
+            std::istringstream is(body);
+            long long u, v;
+            if (!(is >> u)) continue;   // linea vacia o comentario
+            if (!(is >> v)) throw bad("se esperaba 'u v'");
+            if (u < 0 || v < 0 || u >= INT_MAX || v >= INT_MAX) throw bad("indice invalido");
+            n = std::max(n, std::max(u, v) + 1);
+            edges.emplace_back((int)u, (int)v);
+        }
+    }
+    if (n == 0) throw std::runtime_error(path + ": el grafo no tiene nodos");
+    return build_csr(n, edges);
+}
+
+std::vector<int> rcm_order(const Graph& g){
+    std::vector<int> order;
+    order.reserve(g.n);
+    std::vector<char> placed(g.n, 0);
+    std::vector<int> stamp(g.n, -1), queue, last, nb;
+    int id = 0;
+    for (int s0=0; s0<g.n; ++s0){
+        if (placed[s0]) continue;
+        // nodo pseudo-periferico: se salta al de menor grado del ultimo nivel
+        // mientras crezca la excentricidad
+        int r = s0;
+        int ecc = bfs_levels(g, r, stamp, id++, queue, last);
+        for (int tries=0; tries<8; ++tries){
+            const int x = *std::min_element(last.begin(), last.end(),
+                [&](int a, int b){ return g.degree(a) < g.degree(b) || (g.degree(a) == g.degree(b) && a < b); });
+            const int e = bfs_levels(g, x, stamp, id++, queue, last);
+            if (e <= ecc) break;
+            r = x;
+            ecc = e;
+        }
+        // Cuthill-McKee: BFS con los vecinos nuevos por grado creciente
+        size_t head = order.size();
+        order.push_back(r);
+        placed[r] = 1;
+        while (head < order.size()){
+            const int v = order[head++];
+            nb.clear();
+            for (int k=g.off[v]; k<g.off[v+1]; ++k){
+                const int w = g.adj[k];
+                if (!placed[w]){ placed[w] = 1; nb.push_back(w); }
+            }
+            std::sort(nb.begin(), nb.end(),
+                [&](int a, int b){ return g.degree(a) < g.degree(b) || (g.degree(a) == g.degree(b) && a < b); });
+            order.insert(order.end(), nb.begin(), nb.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+Graph permute(const Graph& g, const std::vector<int>& new_to_old){
+    std::vector<int> old_to_new(g.n);
+    for (int k=0; k<g.n; ++k) old_to_new[new_to_old[k]] = k;
+    Graph h;
+    h.n = g.n;
+    h.off.assign(g.n + 1, 0);
+    for (int k=0; k<g.n; ++k) h.off[k+1] = h.off[k] + g.degree(new_to_old[k]);
+    h.adj.resize(g.adj.size());
+    for (int k=0; k<g.n; ++k){
+        const int v = new_to_old[k];
+        int* dst = h.adj.data() + h.off[k];
+        for (int j=g.off[v]; j<g.off[v+1]; ++j) *dst++ = old_to_new[g.adj[j]];
+        std::sort(h.adj.begin() + h.off[k], h.adj.begin() + h.off[k+1]);
+    }
+    return h;
+}
+
+std::vector<int> partition_chunks(const Graph& g, size_t budget_bytes){
+    // cut[c] = aristas entre [0,c) y [c,n)
+    std::vector<long long> cut(g.n + 1, 0);
+    long long c = 0;
+    for (int i=0; i<g.n; ++i){
+        for (int k=g.off[i]; k<g.off[i+1]; ++k){
+            if (g.adj[k] > i) ++c;
+            else --c;
+        }
+        cut[i+1] = c;
+    }
+    // huella de un nodo: amplitud actual y nueva, desplazamiento e indices
+    auto cost = [&](int i){ return (size_t)(2*sizeof(double) + sizeof(int) + sizeof(int)*g.degree(i)); };
+    std::vector<int> parts{0};
+    int s = 0;
+    while (s < g.n){
+        int e = s;
+        size_t acc = 0;
+        while (e < g.n && (e == s || acc + cost(e) <= budget_bytes)){ acc += cost(e); ++e; }
+        if (e == g.n){ parts.push_back(g.n); break; }
+        // corte con menos aristas en el ultimo cuarto (empate: el mas largo)
+        const int lo = s + std::max(1, 3*(e - s)/4);
+        int best = e;
+        for (int x=e-1; x>=lo; --x) if (cut[x] < cut[best]) best = x;
+        parts.push_back(best);
+        s = best;
+    }
+    return parts;
+}
+
+double edge_cut_fraction(const Graph& g, const std::vector<int>& parts){
+    if (g.adj.empty() || parts.size() < 2) return 0.0;
+    std::vector<int> part_of(g.n);
+    for (size_t p=0; p+1<parts.size(); ++p)
+        for (int i=parts[p]; i<parts[p+1]; ++i) part_of[i] = (int)p;
+    long long crossing = 0;
+    for (int i=0; i<g.n; ++i)
+        for (int k=g.off[i]; k<g.off[i+1]; ++k) crossing += part_of[g.adj[k]] != part_of[i];
+    return (double)crossing / (double)g.adj.size();
+}
+
+GraphLocality measure_locality(const Graph& g, int cache_kb){
+    GraphLocality r;
+    const long long arcs = g.arcs();
+    if (arcs == 0) return r;
+    long long dist = 0, same = 0;
+    for (int i=0; i<g.n; ++i){
+        for (int k=g.off[i]; k<g.off[i+1]; ++k){
+            const int d = std::abs(g.adj[k] - i);
+            r.bandwidth = std::max(r.bandwidth, d);
+            dist += d;
+            same += (g.adj[k] / 8) == (i / 8);   // 8 amplitudes double por linea
+        }
+    }
+    r.mean_dist = (double)dist / arcs;
+    r.same_line = (double)same / arcs;
+
+    // cache LRU asociativa de 16 vias (lineas de 64 B) con las lecturas de
+    // vecinos de un barrido; la segunda pasada mide el regimen estable
+    constexpr int kWays = 16;
+    const int sets = std::max(1, cache_kb*1024 / 64 / kWays);
+    std::vector<long long> tag((size_t)sets*kWays, -1), used((size_t)sets*kWays, 0);
+    long long clock = 0, misses = 0;
+    for (int pass=0; pass<2; ++pass){
+        for (int i=0; i<g.n; ++i){
+            for (int k=g.off[i]; k<g.off[i+1]; ++k){
+                const long long line = g.adj[k] / 8;
+                const size_t set = (size_t)(line % sets) * kWays;
+                int hit = -1, lru = 0;
+                for (int w=0; w<kWays; ++w){
+                    if (tag[set + w] == line){ hit = w; break; }
+                    if (used[set + w] < used[set + lru]) lru = w;
+                }
+                if (hit < 0){
+                    hit = lru;
+                    tag[set + hit] = line;
+                    if (pass == 1) ++misses;
+                }
+                used[set + hit] = ++clock;
+            }
+        }
+    }
+    r.miss_rate = (double)misses / arcs;
+
+    // barrido CSR real de un hilo (el de update_index), mejor de 5
+    std::vector<double> a(g.n), b(g.n);
+    for (int i=0; i<g.n; ++i) a[i] = (double)((i*2654435761u) % 1000) * 1e-3;
+    double best = 1e300;
+    for (int rep=0; rep<5; ++rep){
+        const double t0 = omp_get_wtime();
+        for (int i=0; i<g.n; ++i){
+            const double ai = a[i];
+            double acc = 0;
+            for (int k=g.off[i]; k<g.off[i+1]; ++k) acc += a[g.adj[k]] - ai;
+            b[i] = ai + 1e-3*acc;
+        }
+        best = std::min(best, omp_get_wtime() - t0);
+        a.swap(b);
+    }
+    volatile double sink = a[g.n/2];
+    (void)sink;
+    r.ns_per_arc = best / arcs * 1e9;
+    return r;
+}
+
+void graph_report(const Graph& before, const Graph& after, const char* order_label,
+                  const std::vector<int>& parts, int cache_kb, std::ostream& os){
+    const GraphLocality b = measure_locality(before, cache_kb);
+    const GraphLocality a = measure_locality(after, cache_kb);
+    os << "[graph] " << before.n << " nodos, " << before.arcs()/2 << " aristas, orden " << order_label << "\n";
+    char line[160];
+    auto row = [&](const char* name, double x, double y, const char* fmt){
+        char f[64];
+        std::snprintf(f, sizeof(f), "  %%-26s %s  %s\n", fmt, fmt);
+        std::snprintf(line, sizeof(line), f, name, x, y);
+        os << line;
+    };
+    os << "  " << std::left << std::setw(26) << "" << std::right << std::setw(12) << "antes" << std::setw(14) << "despues" << "\n";
+    row("ancho de banda", b.bandwidth, a.bandwidth, "%12.0f");
+    row("distancia media", b.mean_dist, a.mean_dist, "%12.1f");
+    row("misma linea de 64 B (%)", 100*b.same_line, 100*a.same_line, "%12.1f");
+    std::snprintf(line, sizeof(line), "fallos cache %d KiB (%%)", cache_kb);
+    const std::string miss_label = line;
+    row(miss_label.c_str(), 100*b.miss_rate, 100*a.miss_rate, "%12.1f");
+    row("ns por vecino (1 hilo)", b.ns_per_arc, a.ns_per_arc, "%12.2f");
+    if (!parts.empty()){
+        const int np = (int)parts.size() - 1;
+        std::snprintf(line, sizeof(line), "[graph] particion: %d tramos (~%d nodos), corte de aristas %.1f%%\n",
+                      np, np > 0 ? after.n / np : 0, 100*edge_cut_fraction(after, parts));
+        os << line;
+    }
+
+    std::ofstream f("results/graph_report.tsv");
+    if (!f) return;
+    f << "# metrica\tantes\tdespues\n";
+    f << "bandwidth\t" << b.bandwidth << '\t' << a.bandwidth << '\n';
+    f << "mean_dist\t" << b.mean_dist << '\t' << a.mean_dist << '\n';
+    f << "same_line\t" << b.same_line << '\t' << a.same_line << '\n';
+    f << "miss_rate\t" << b.miss_rate << '\t' << a.miss_rate << '\n';
+    f << "ns_per_arc\t" << b.ns_per_arc << '\t' << a.ns_per_arc << '\n';
+    if (!parts.empty()) f << "edge_cut\t\t" << edge_cut_fraction(after, parts) << '\n';
+}
@@ -0,0 +1,56 @@
+#pragma once // para que se compile solo una vez
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Grafo no dirigido en CSR compacto: vecinos de i en adj[off[i] .. off[i+1]),
+// ordenados, sin lazos ni aristas repetidas (cada arista aparece en los dos
+// extremos). Es la topologia de --network graph (Network(const Graph&, ...)).
+struct Graph {
+    int n = 0;
+    std::vector<int> off;   // n+1 desplazamientos
+    std::vector<int> adj;
+
+    long long arcs() const { return (long long)adj.size(); }   // 2 x aristas
+    int degree(int i) const { return off[i+1] - off[i]; }
+};
+
+// Carga una lista de aristas ("u v" por linea, indices base 0; '#' o '%'
+// inician un comentario; columnas extra como pesos se ignoran) o, si el
+// archivo termina en .mtx, una matriz Matrix Market en formato coordinate
+// (base 1, general o simetrica; la diagonal y los valores se ignoran). Lanza
+// std::runtime_error si el archivo no se puede leer o no es valido.
+Graph load_graph(const std::string& path);
+
+// Reverse Cuthill-McKee: por componente, BFS desde un nodo pseudo-periferico
+// (George-Liu) visitando vecinos por grado creciente; el orden final se
+// invierte. Devuelve new_to_old (la posicion k la ocupa el nodo original).
+std::vector<int> rcm_order(const Graph& g);
+
+// Renumera: el nodo new_to_old[k] pasa a ser el k (vecinos reordenados)
+Graph permute(const Graph& g, const std::vector<int>& new_to_old);
+
+// Parte los nodos en tramos contiguos cuya huella (amplitudes, desplazamiento
+// e indices de vecinos) cabe en budget_bytes. Cada corte se elige en el ultimo
+// cuarto del tramo donde cruzan menos aristas. Devuelve los limites
+// (parts[0] = 0, parts.back() = n).
+std::vector<int> partition_chunks(const Graph& g, size_t budget_bytes);
+
+// Medidas de localidad del orden actual de los nodos
+struct GraphLocality {
+    int bandwidth = 0;           // max |i - j| sobre las aristas
+    double mean_dist = 0.0;      // |i - j| medio
+    double same_line = 0.0;      // fraccion de lecturas de vecinos en la linea de 64 B del nodo
+    double miss_rate = 0.0;      // fallos por lectura de una cache LRU simulada (cache_kb)
+    double ns_per_arc = 0.0;     // barrido CSR medido (1 hilo, mejor de varias repeticiones)
+};
+GraphLocality measure_locality(const Graph& g, int cache_kb);
+
+// aristas (no dirigidas) con extremos en tramos distintos / total
+double edge_cut_fraction(const Graph& g, const std::vector<int>& parts);
+
+// Informe de --graph-report: antes y despues del reordenamiento y el corte de
+// la particion (parts vacio = sin particion); tambien en results/graph_report.tsv
+void graph_report(const Graph& before, const Graph& after, const char* order_label,
+                  const std::vector<int>& parts, int cache_kb, std::ostream& os);
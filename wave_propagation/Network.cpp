@@ -1,50 +1,229 @@
 #include "Network.h"
+#include "Graph.h"
+#include <algorithm>
 #include <cmath>
+#include <vector>
+#include <omp.h>
 
-Network::Network(int N, double D, double g) : nodes_(N), is2d_(false), Lx_(N), Ly_(1), D_(D), g_(g) {
-    for (int i=0;i<N;++i) nodes_[i] = Node(i);
+Network::Network(int N, double D, double g, int touch_chunk)
+    : cur_(AlignedBuffer<double>::uninitialized(N)), next_(AlignedBuffer<double>::uninitialized(N)),
+      n_(N), is2d_(false), Lx_(N), Ly_(1), D_(D), g_(g), touch_chunk_(touch_chunk)
+{
+    setAll(0.0);   // primera escritura en paralelo
 }
-Network::Network(int Lx, int Ly, double D, double g) : nodes_(Lx*Ly), is2d_(true), Lx_(Lx), Ly_(Ly), D_(D), g_(g) {
-    for (int i=0;i<Lx_*Ly_;++i) nodes_[i] = Node(i);
+Network::Network(int Lx, int Ly, double D, double g, int touch_chunk)
+    : cur_(AlignedBuffer<double>::uninitialized((size_t)Lx*Ly)), next_(AlignedBuffer<double>::uninitialized((size_t)Lx*Ly)),
+      n_(Lx*Ly), is2d_(true), Lx_(Lx), Ly_(Ly), D_(D), g_(g), touch_chunk_(touch_chunk)
+{
+    setAll(0.0);
+}
+Network::Network(const Graph& graph, double D, double g, int touch_chunk, std::vector<int> to_orig)
+    : cur_(AlignedBuffer<double>::uninitialized(graph.n)), next_(AlignedBuffer<double>::uninitialized(graph.n)),
+      csr_(AlignedBuffer<int>::uninitialized((size_t)graph.n + 1 + graph.adj.size())),
+      n_(graph.n), is2d_(false), Lx_(graph.n), Ly_(1), D_(D), g_(g), touch_chunk_(touch_chunk),
+      to_orig_(std::move(to_orig))
+{
+    setAll(0.0);
+    // desplazamientos e indices de cada tramo los escribe el hilo que lo barre
+    int* off = csr_.data();
+    int* nbr = csr_.data() + (n_ + 1);
+    parallel_ranges([&](size_t i0, size_t i1){
+        std::copy(graph.off.begin() + i0, graph.off.begin() + i1, off + i0);
+        std::copy(graph.adj.begin() + graph.off[i0], graph.adj.begin() + graph.off[i1], nbr + graph.off[i0]);
+    });
+    off[n_] = graph.off[n_];
+    if (!to_orig_.empty()){
+        to_internal_.resize(n_);
+        for (int k=0; k<n_; ++k) to_internal_[to_orig_[k]] = k;
+    }
+}
+
+AlignedBuffer<double> Network::placedBuffer() const{
+    AlignedBuffer<double> b = AlignedBuffer<double>::uninitialized(n_);
+    double* p = b.data();
+    parallel_ranges([&](size_t i0, size_t i1){ std::fill(p + i0, p + i1, 0.0); });
+    return b;
+}
+
+// Filas (2D) o nodos (1D) por bloque del reparto de first touch
+int Network::touch_block(int threads) const{
+    const int rows = is2d_ ? Ly_ : n_;
+    if (touch_chunk_ > 0) return touch_chunk_;
+    return std::max(1, (rows + threads - 1) / std::max(1, threads));
+}
+
+int Network::firstTouchThread(long i, int threads) const{
+    const long r = is2d_ ? i / Lx_ : i;
+    return (int)((r / touch_block(threads)) % std::max(1, threads));
+}
+
+// f(i0, i1) sobre tramos [i0,i1) de nodos, repartidos entre los hilos con el
+// mismo esquema que el kernel: bloques de touch_block() filas en round-robin
+// (schedule(static, chunk) sobre filas en 2D y sobre nodos en 1D)
+template <class F>
+void Network::parallel_ranges(F&& f) const{
+    const size_t unit = is2d_ ? (size_t)Lx_ : 1;
+    const int rows = is2d_ ? Ly_ : n_;
+    #pragma omp parallel
+    {
+        const int bs = touch_block(omp_get_num_threads());
+        const int nblk = (rows + bs - 1) / bs;
+        #pragma omp for schedule(static, 1)
+        for (int b=0; b<nblk; ++b){
+            const int r0 = b*bs, r1 = std::min(rows, r0 + bs);
+            f(r0*unit, r1*unit);
+        }
+    }
 }
 
 void Network::makeRegular1D(bool periodic){
     is2d_ = false; Lx_ = size(); Ly_ = 1;
-    const int N = size();
-    for (int i=0;i<N;++i){
-        if (i-1>=0) nodes_[i].addNeighbor(i-1);
-        else if (periodic) nodes_[i].addNeighbor(N-1);
-        if (i+1<N) nodes_[i].addNeighbor(i+1);
-        else if (periodic) nodes_[i].addNeighbor(0);
-    }
+    regular_ = true; periodic_ = periodic;
+    csr_.clear();
 }
 
 void Network::makeRegular2D(bool periodic){
     is2d_ = true;
+    regular_ = true; periodic_ = periodic;
+    csr_.clear();
+}
+
+void Network::buildAdjacency(){
     const int N = size();
-    for (int i=0;i<N;++i){
+    const bool periodic = periodic_;
+    // grado de cada nodo conocido de antemano: se llena el CSR sin push_back
+    auto deg = [&](int i){
+        if (!is2d_) return (i-1>=0 || periodic ? 1 : 0) + (i+1<N || periodic ? 1 : 0);
         int x = i % Lx_, y = i / Lx_;
-        auto idx = [&](int xx, int yy)->int{ return yy*Lx_ + xx; };
-        // left
-        if (x>0) nodes_[i].addNeighbor(idx(x-1,y));
-        else if (periodic) nodes_[i].addNeighbor(idx(Lx_-1,y));
-        // right
-        if (x+1<Lx_) nodes_[i].addNeighbor(idx(x+1,y));
-        else if (periodic) nodes_[i].addNeighbor(idx(0,y));
-        // up
-        if (y>0) nodes_[i].addNeighbor(idx(x,y-1));
-        else if (periodic) nodes_[i].addNeighbor(idx(x,Ly_-1));
-        // down
-        if (y+1<Ly_) nodes_[i].addNeighbor(idx(x,y+1));
-        else if (periodic) nodes_[i].addNeighbor(idx(x,0));
+        return (x>0 || periodic ? 1 : 0) + (x+1<Lx_ || periodic ? 1 : 0)
+             + (y>0 || periodic ? 1 : 0) + (y+1<Ly_ || periodic ? 1 : 0);
+    };
+    auto idx = [&](int xx, int yy)->int{ return yy*Lx_ + xx; };
+    const size_t unit = is2d_ ? (size_t)Lx_ : 1;
+    const int rows = is2d_ ? Ly_ : N;
+    std::vector<int> blk_off;   // aristas antes de cada bloque (suma prefija)
+
+    // dos pasadas en paralelo con el reparto de first touch: grados por
+    // bloque, suma prefija y llenado de cada bloque desde su desplazamiento
+    #pragma omp parallel
+    {
+        const int bs = touch_block(omp_get_num_threads());
+        const int nblk = (rows + bs - 1) / bs;
+        #pragma omp single
+        blk_off.assign((size_t)nblk + 1, 0);
+        #pragma omp for schedule(static, 1)
+        for (int b=0; b<nblk; ++b){
+            const int i0 = (int)(b*bs*unit), i1 = (int)(std::min(rows, (b+1)*bs)*unit);
+            int s = 0;
+            for (int i=i0; i<i1; ++i) s += deg(i);
+            blk_off[b+1] = s;
+        }
+        #pragma omp single
+        {
+            for (int b=0; b<nblk; ++b) blk_off[b+1] += blk_off[b];
+            csr_ = AlignedBuffer<int>::uninitialized((size_t)N + 1 + blk_off[nblk]);
+            csr_[N] = blk_off[nblk];
+        }
+        int* off = csr_.data();
+        int* nbr = csr_.data() + (N + 1);
+        #pragma omp for schedule(static, 1)
+        for (int b=0; b<nblk; ++b){
+            const int i0 = (int)(b*bs*unit), i1 = (int)(std::min(rows, (b+1)*bs)*unit);
+            int k = blk_off[b];
+            for (int i=i0; i<i1; ++i){
+                off[i] = k;
+                if (!is2d_){
+                    if (i-1>=0) nbr[k++] = i-1;
+                    else if (periodic) nbr[k++] = N-1;
+                    if (i+1<N) nbr[k++] = i+1;
+                    else if (periodic) nbr[k++] = 0;
+                } else {
+                    int x = i % Lx_, y = i / Lx_;
+                    // left
+                    if (x>0) nbr[k++] = idx(x-1,y);
+                    else if (periodic) nbr[k++] = idx(Lx_-1,y);
+                    // right
+                    if (x+1<Lx_) nbr[k++] = idx(x+1,y);
+                    else if (periodic) nbr[k++] = idx(0,y);
+                    // up
+                    if (y>0) nbr[k++] = idx(x,y-1);
+                    else if (periodic) nbr[k++] = idx(x,Ly_-1);
+                    // down
+                    if (y+1<Ly_) nbr[k++] = idx(x,y+1);
+                    else if (periodic) nbr[k++] = idx(x,0);
+                }
+            }
+        }
     }
 }
 
 void Network::setAll(double v){
-    for (auto &n : nodes_){ n.set(v); n.setPrev(v); }
+    parallel_ranges([&](size_t i0, size_t i1){
+        if (single_){
+            std::fill(cur32_.begin() + i0, cur32_.begin() + i1, (float)v);
+            std::fill(next32_.begin() + i0, next32_.begin() + i1, (float)v);
+        } else {
+            std::fill(cur_.begin() + i0, cur_.begin() + i1, v);
+            std::fill(next_.begin() + i0, next_.begin() + i1, v);
+        }
+    });
 }
 void Network::setInitialImpulseCenter(double amp){
     // Centro geométrico (1D: Lx_/2 ; 2D: (Lx_/2, Ly_/2))
     int idx = is2d_ ? ((Ly_/2)*Lx_ + (Lx_/2)) : (Lx_/2);
-    if (idx>=0 && idx<(int)nodes_.size()) nodes_[idx].set(amp), nodes_[idx].setPrev(amp);
+    if (idx<0 || idx>=n_) return;
+    idx = internalIndex(idx);   // grafo reordenado: el nodo N/2 original
+    if (single_) cur32_[idx] = (float)amp, next32_[idx] = (float)amp;
+    else cur_[idx] = amp, next_[idx] = amp;
+}
+void Network::loadAmplitudes(const double* v){
+    parallel_ranges([&](size_t i0, size_t i1){
+        if (single_) std::transform(v + i0, v + i1, cur32_.begin() + i0, [](double x){ return (float)x; });
+        else std::copy(v + i0, v + i1, cur_.begin() + i0);
+    });
+}
+
+void Network::setTouchChunk(int touch_chunk){
+    if (touch_chunk == touch_chunk_) return;
+    touch_chunk_ = touch_chunk;
+    if (single_){
+        AlignedBuffer<float> c = AlignedBuffer<float>::uninitialized(n_);
+        AlignedBuffer<float> x = AlignedBuffer<float>::uninitialized(n_);
+        parallel_ranges([&](size_t i0, size_t i1){
+            for (size_t i=i0; i<i1; ++i){ c[i] = cur32_[i]; x[i] = next32_[i]; }
+        });
+        cur32_.swap(c);
+        next32_.swap(x);
+    } else {
+        AlignedBuffer<double> c = AlignedBuffer<double>::uninitialized(n_);
+        AlignedBuffer<double> x = AlignedBuffer<double>::uninitialized(n_);
+        parallel_ranges([&](size_t i0, size_t i1){
+            for (size_t i=i0; i<i1; ++i){ c[i] = cur_[i]; x[i] = next_[i]; }
+        });
+        cur_.swap(c);
+        next_.swap(x);
+    }
+}
+
+void Network::setSinglePrecision(bool on){
+    if (on == single_) return;
+    // el almacenamiento nuevo se toca con el mismo reparto que el anterior
+    if (on){
+        cur32_ = AlignedBuffer<float>::uninitialized(n_);
+        next32_ = AlignedBuffer<float>::uninitialized(n_);
+        parallel_ranges([&](size_t i0, size_t i1){
+            for (size_t i=i0; i<i1; ++i){ cur32_[i] = (float)cur_[i]; next32_[i] = (float)next_[i]; }
+        });
+        cur_.clear();
+        next_.clear();
+    } else {
+        cur_ = AlignedBuffer<double>::uninitialized(n_);
+        next_ = AlignedBuffer<double>::uninitialized(n_);
+        parallel_ranges([&](size_t i0, size_t i1){
+            for (size_t i=i0; i<i1; ++i){ cur_[i] = cur32_[i]; next_[i] = next32_[i]; }
+        });
+        cur32_.clear();
+        next32_.clear();
+    }
+    single_ = on;
 }
@@ -1,36 +1,129 @@
 #pragma once // para que se compile solo una vez
 
 
-#include <vector>   // 
 #include <cassert>
-#include "Node.h"
+#include <type_traits>
+#include <vector>
+#include "AlignedBuffer.h"
+#include "Types.h"
+
+struct Graph;
 
 class Network {
-    std::vector<Node> nodes_;   //arreglo contiguo de nodos
+    // Almacenamiento SoA: dos arreglos contiguos de amplitudes en vez de un vector<Node>
+    AlignedBuffer<double> cur_;   // amplitud confirmada (la que leen los vecinos en el paso)
+    AlignedBuffer<double> next_;  // amplitud nueva escrita durante el paso
+    // Almacenamiento float32 (--precision f32/mixed): mitad de bytes por nodo.
+    // Solo uno de los dos pares esta reservado a la vez.
+    AlignedBuffer<float> cur32_, next32_;
+    bool single_ = false;
+    // Topologia CSR en un solo bloque: [offsets (N+1) | indices (nnz)]
+    // Las grillas regulares no la necesitan (stencil sin matriz): solo se
+    // construye bajo demanda con buildAdjacency().
+    AlignedBuffer<int> csr_;
+    int n_ = 0;                   // numero de nodos
     bool is2d_ = false;         // valor que indica que tipo de topologia es 1D/2D
+    bool regular_ = false;        // grilla regular 1D/2D (admite stencil)
+    bool periodic_ = false;       // bordes periodicos de la grilla regular
     int Lx_ = 0, Ly_ = 0;       // en caso de ser 2D da las dimensiones de la grilla
     double D_ = 0.1, g_ = 0.01; // parametros globales Difusion y amortiguamiento
+    int touch_chunk_ = 0;         // reparto de la primera escritura (ver constructores)
+    // --network graph: nodo original de cada nodo interno (vacio = identidad),
+    // su inversa y los tramos de la particion (vacio = sin particion)
+    std::vector<int> to_orig_, to_internal_;
+    std::vector<int> parts_;
+
+    int touch_block(int threads) const;
+    template <class F> void parallel_ranges(F&& f) const;
 public:
-    Network(int N, double D, double g);            // construccion 1d
-    Network(int Lx, int Ly, double D, double g);   // construccion 2d
+    // Las amplitudes se reservan sin tocar y se inicializan en paralelo con el
+    // mismo reparto estatico que el kernel (first touch: cada pagina queda en
+    // el nodo NUMA del hilo que despues la recorre). touch_chunk > 0 reparte
+    // bloques de touch_chunk filas (2D) o nodos (1D) en round-robin, como
+    // schedule(static, chunk); 0 da un bloque contiguo por hilo.
+    Network(int N, double D, double g, int touch_chunk = 0);            // construccion 1d
+    Network(int Lx, int Ly, double D, double g, int touch_chunk = 0);   // construccion 2d
+    // grafo arbitrario (ya reordenado): CSR copiado con el mismo first touch;
+    // to_orig[k] = nodo original del nodo interno k (vacio = mismo orden)
+    Network(const Graph& graph, double D, double g, int touch_chunk = 0,
+            std::vector<int> to_orig = {});
 
     // Build topologies
-    void makeRegular1D(bool periodic=false);       // construye la conectividad  1D si periodic=true, construye conectividad
-    void makeRegular2D(bool periodic=false);       // construye la conectividad  2D si periodic=true, construye conectividad
+    void makeRegular1D(bool periodic=false);       // define la grilla regular 1D (sin lista de vecinos); periodic=true cierra los extremos
+    void makeRegular2D(bool periodic=false);       // define la grilla regular 2D (sin lista de vecinos); periodic=true cierra los bordes
+    void buildAdjacency();                         // materializa el CSR de la grilla regular (camino de respaldo)
+    void releaseAdjacency(){ csr_.clear(); }       // libera el CSR
+    // tramos contiguos de nodos del barrido CSR (parts[0] = 0, back() = N)
+    void setParts(std::vector<int> parts){ parts_ = std::move(parts); }
 
     // inicializa los estados
-    void setAll(double v);                         // 
+    void setAll(double v);                         //
     void setInitialImpulseCenter(double amp);      //
+    void loadAmplitudes(const double* v);          // copia v (N valores) al estado confirmado
+
+    // Tipo de almacenamiento de las amplitudes: float (true) o double (false).
+    // Convierte el estado actual y libera el almacenamiento anterior.
+    void setSinglePrecision(bool on);
+    // cambia el reparto de first touch (mismo significado que en el constructor)
+    // y mueve las amplitudes a memoria nueva tocada con ese reparto
+    void setTouchChunk(int touch_chunk);
+    bool singlePrecision() const { return single_; }
 
     // Getters
-    int size() const { return (int)nodes_.size(); }
+    int size() const { return n_; }
     bool is2D() const { return is2d_; }
+    bool isRegular() const { return regular_; }
+    bool periodic() const { return periodic_; }
+    Boundary boundary() const { return periodic_ ? Boundary::Periodic : Boundary::Open; }
+    bool hasAdjacency() const { return !csr_.empty(); }
     int Lx() const { return Lx_; }
     int Ly() const { return Ly_; }
     double diffusion() const { return D_; }
     double damping() const { return g_; }
+    // hilo (de `threads`) que escribio primero el nodo i
+    int firstTouchThread(long i, int threads) const;
+    // estado confirmado tal como esta almacenado (double o float) y su tamano en bytes
+    const void* storageData() const { return single_ ? (const void*)cur32_.data() : (const void*)cur_.data(); }
+    size_t storageBytes() const { return (size_t)n_ * (single_ ? sizeof(float) : sizeof(double)); }
+
+    // Acceso directo a las amplitudes (lectura escritura)
+    double* current(){ return cur_.data(); }
+    const double* current() const { return cur_.data(); }
+    double* next(){ return next_.data(); }
+    const double* next() const { return next_.data(); }
+    double amplitude(int i) const { assert(i>=0 && i<n_); return single_ ? cur32_[i] : cur_[i]; }
+
+    // Acceso tipado al almacenamiento activo (Real = double o float)
+    template <class Real> Real* currentAs(){
+        assert(single_ == (std::is_same<Real, float>::value));
+        if constexpr (std::is_same<Real, float>::value) return cur32_.data();
+        else return cur_.data();
+    }
+    template <class Real> Real* nextAs(){
+        assert(single_ == (std::is_same<Real, float>::value));
+        if constexpr (std::is_same<Real, float>::value) return next32_.data();
+        else return next_.data();
+    }
+
+    // Acceso a la topologia CSR: vecinos de i en indices[offsets[i] .. offsets[i+1])
+    const int* rowOffsets() const { return csr_.data(); }
+    const int* colIndices() const { return csr_.data() + (n_ + 1); }
+    int degree(int i) const { return csr_[i+1] - csr_[i]; }
+    int numEdges() const { return csr_.empty() ? 0 : csr_[n_]; }
+    const std::vector<int>& parts() const { return parts_; }
+
+    // Numeracion de --network graph con --reorder: el estado, los checkpoints y
+    // el barrido usan el orden interno; frames, sondas y --noise-node el original
+    bool reordered() const { return !to_orig_.empty(); }
+    const std::vector<int>& originalIds() const { return to_orig_; }
+    int internalIndex(int orig) const { return reordered() ? to_internal_[orig] : orig; }
 
-    // Acceso a los nodos (Lectura escritura)
-    std::vector<Node>& data(){ return nodes_; }
-    const std::vector<Node>& data() const { return nodes_; }
+    // Intercambio O(1) de los buffers: next pasa a ser el estado confirmado
+    void swapBuffers(){ cur_.swap(next_); cur32_.swap(next32_); }
+    // intercambia en O(1) el buffer next con uno externo del mismo tamano
+    // (entrega de instantaneas al escritor asincrono sin copiar)
+    void exchangeNext(AlignedBuffer<double>& buf){ assert(buf.size() == next_.size()); next_.swap(buf); }
+    // buffer de N ceros con el mismo first touch que las amplitudes: los que
+    // entran por exchangeNext no desarman la ubicacion NUMA
+    AlignedBuffer<double> placedBuffer() const;
 };
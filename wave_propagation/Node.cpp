@@ -1 +0,0 @@
-#include "Node.h"  //implementacion en el header
@@ -0,0 +1,184 @@
+#include "Numa.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <omp.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+#if defined(__linux__)
+// conjunto del proceso, leido una vez: despues de pin_threads el hilo
+// maestro ya solo tiene su CPU (el pool de StealPool la pide mas tarde)
+std::vector<int> allowed_cpus(){
+    static const std::vector<int> cpus = []{
+        std::vector<int> v;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) != 0) return v;
+        for (int c=0; c<CPU_SETSIZE; ++c) if (CPU_ISSET(c, &set)) v.push_back(c);
+        return v;
+    }();
+    return cpus;
+}
+#endif
+
+// CPU de cada hilo OpenMP (sched_getcpu dentro de la region)
+std::vector<int> thread_cpus(){
+    std::vector<int> cpu(omp_get_max_threads(), -1);
+    #pragma omp parallel
+    {
+#if defined(__linux__)
+        cpu[omp_get_thread_num()] = sched_getcpu();
+#endif
+    }
+    return cpu;
+}
+
+} // namespace
+
+int numa_node_count(){
+    int n = 0;
+    std::error_code ec;
+    for (const auto& e : std::filesystem::directory_iterator("/sys/devices/system/node", ec)){
+        const std::string name = e.path().filename().string();
+        if (name.rfind("node", 0) == 0 && name.size() > 4 && std::isdigit((unsigned char)name[4])) ++n;
+    }
+    return std::max(1, n);
+}
+
+int numa_node_of_cpu(int cpu){
+    if (cpu < 0) return -1;
+    std::error_code ec;
+    const std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    for (const auto& e : std::filesystem::directory_iterator(dir, ec)){
+        const std::string name = e.path().filename().string();
+        if (name.rfind("node", 0) == 0 && name.size() > 4 && std::isdigit((unsigned char)name[4]))
+            return std::stoi(name.substr(4));
+    }
+    return numa_node_count() == 1 ? 0 : -1;
+}
+
+int allowed_cpu_count(){
+#if defined(__linux__)
+    const int n = (int)allowed_cpus().size();
+    if (n > 0) return n;
+#endif
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+std::vector<int> cpu_order(PinMode mode){
+#if defined(__linux__)
+    if (mode == PinMode::None) return {};
+    std::vector<int> cpus = allowed_cpus();
+    if (mode == PinMode::Spread && !cpus.empty()){
+        // round-robin entre nodos: la CPU k de cada nodo antes que la k+1
+        std::vector<std::vector<int>> by_node;
+        for (int c : cpus){
+            const int n = std::max(0, numa_node_of_cpu(c));
+            if ((int)by_node.size() <= n) by_node.resize(n + 1);
+            by_node[n].push_back(c);
+        }
+        std::vector<int> order;
+        for (size_t k=0; order.size() < cpus.size(); ++k)
+            for (const auto& v : by_node) if (k < v.size()) order.push_back(v[k]);
+        cpus.swap(order);
+    }
+    return cpus;
+#else
+    (void)mode;
+    return {};
+#endif
+}
+
+bool pin_current_thread(int cpu){
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+std::vector<int> pin_threads(PinMode mode){
+    const std::vector<int> cpus = cpu_order(mode);
+    if (cpus.empty()) return {};
+    std::vector<int> pinned(omp_get_max_threads(), -1);
+    #pragma omp parallel
+    {
+        const int t = omp_get_thread_num();
+        const int c = cpus[t % cpus.size()];
+        if (pin_current_thread(c)) pinned[t] = c;
+    }
+    return pinned;
+}
+
+void numa_report(const Network& net, std::ostream& os){
+    const std::vector<int> cpu = thread_cpus();
+    const int threads = (int)cpu.size();
+    std::vector<int> node(threads);
+    for (int t=0; t<threads; ++t) node[t] = numa_node_of_cpu(cpu[t]);
+
+    os << "[numa] nodos: " << numa_node_count() << ", hilos: " << threads << "\n";
+    for (int t=0; t<threads; ++t)
+        os << "[numa] hilo " << t << " -> cpu " << cpu[t] << " (nodo " << node[t] << ")\n";
+
+#if defined(__linux__) && defined(SYS_move_pages)
+    // move_pages con nodes == nullptr solo consulta en que nodo esta cada pagina
+    const long page = sysconf(_SC_PAGESIZE);
+    const uintptr_t base = reinterpret_cast<uintptr_t>(net.storageData());
+    const size_t bytes = net.storageBytes();
+    if (!base || bytes == 0 || page <= 0) return;
+    const uintptr_t first = (base + page - 1) / page * page;   // primera pagina completa
+    const size_t npages = first < base + bytes ? (base + bytes - first) / page : 0;
+    const size_t stride = std::max<size_t>(1, npages / 65536);  // muestreo en grillas enormes
+    std::vector<void*> pages;
+    std::vector<long> index;   // nodo (indice de amplitud) al inicio de cada pagina
+    const size_t elem = bytes / std::max(1, net.size());
+    for (size_t p=0; p<npages; p+=stride){
+        const uintptr_t a = first + p*page;
+        pages.push_back(reinterpret_cast<void*>(a));
+        index.push_back((long)((a - base) / elem));
+    }
+    std::vector<int> status(pages.size(), -1);
+    if (pages.empty() || syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0){
+        os << "[numa] no se pudo consultar la ubicacion de las paginas\n";
+        return;
+    }
+    std::vector<size_t> per_node;
+    size_t resident = 0, local = 0, known = 0;
+    for (size_t k=0; k<pages.size(); ++k){
+        if (status[k] < 0) continue;   // pagina no residente
+        ++resident;
+        if ((int)per_node.size() <= status[k]) per_node.resize(status[k] + 1, 0);
+        ++per_node[status[k]];
+        const int want = node[net.firstTouchThread(index[k], threads)];
+        if (want >= 0){
+            ++known;
+            if (want == status[k]) ++local;
+        }
+    }
+    os << "[numa] amplitudes: " << npages << " paginas (" << pages.size() << " consultadas, "
+       << resident << " residentes)";
+    for (size_t n=0; n<per_node.size(); ++n)
+        os << ", nodo " << n << " " << std::fixed << std::setprecision(1)
+           << (resident ? 100.0 * per_node[n] / resident : 0.0) << "%";
+    os << "\n[numa] paginas en el nodo del hilo que las recorre: "
+       << (known ? 100.0 * local / known : 0.0) << "%\n" << std::defaultfloat;
+#else
+    (void)net;
+#endif
+}
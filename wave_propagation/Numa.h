@@ -0,0 +1,33 @@
+#pragma once // para que se compile solo una vez
+
+#include <ostream>
+#include <vector>
+
+#include "Network.h"
+#include "Types.h"
+
+// Afinidad de hilos y ubicacion NUMA (Linux, via sysfs y sched_setaffinity /
+// move_pages; sin libnuma). En otros sistemas pin_threads no hace nada y el
+// reporte solo muestra lo que puede.
+
+int numa_node_count();
+int numa_node_of_cpu(int cpu);       // -1 si no se sabe
+
+// CPU permitidas en el orden de --pin (vacio con None o fuera de Linux): el
+// hilo t va a la CPU order[t % size]
+std::vector<int> cpu_order(PinMode mode);
+// CPU en las que puede correr el proceso (antes de fijar hilos)
+int allowed_cpu_count();
+// fija el hilo que llama a una CPU (false si no se pudo)
+bool pin_current_thread(int cpu);
+
+// Fija cada hilo OpenMP a una CPU del conjunto permitido. Compact llena las
+// CPU en orden (un socket antes que el siguiente); Spread alterna los nodos
+// NUMA. Se llama antes de construir la red para que el first touch use los
+// mismos hilos que el calculo. Devuelve la CPU de cada hilo (vacio si no fijo nada).
+std::vector<int> pin_threads(PinMode mode);
+
+// Imprime CPU y nodo de cada hilo, y en que nodo quedaron las paginas de las
+// amplitudes: total por nodo y fraccion que esta en el nodo del hilo que las
+// recorre (segun el reparto de first touch de la red).
+void numa_report(const Network& net, std::ostream& os);
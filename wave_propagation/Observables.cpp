@@ -0,0 +1,155 @@
+#include "Observables.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr char kMagic[8] = {'W','A','V','E','O','B','S','1'};
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeader = 64, kName = 16;
+constexpr size_t kFlushDoubles = 8192;   // 64 KiB por bloque escrito
+
+const char* kNames[Observables::kKinds] = {"energy", "max", "centroid", "probes"};
+
+// valores little-endian (como frames.bin)
+template <class T>
+inline void store_le(char* dst, T v){
+    std::memcpy(dst, &v, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    std::reverse(dst, dst + sizeof(T));
+#endif
+}
+
+} // namespace
+
+Observables::Observables(const RunParams& params, int Lx, int Ly, bool is2D, int threads)
+    : Lx_(Lx), Ly_(is2D ? Ly : 1), is2D_(is2D), part_(std::max(1, threads))
+{
+    // "energy:1,max:10,centroid" (sin intervalo = cada paso)
+    std::stringstream ss(params.observe);
+    std::string item;
+    while (std::getline(ss, item, ',')){
+        if (item.empty()) continue;
+        const size_t colon = item.find(':');
+        const std::string name = item.substr(0, colon);
+        const int every = colon == std::string::npos ? 1 : std::stoi(item.substr(colon + 1));
+        const char* const* k = std::find_if(kNames, kNames + kKinds, [&](const char* n){ return name == n; });
+        if (k == kNames + kKinds) throw std::runtime_error("observable desconocido: " + name);
+        if (every < 1) throw std::runtime_error("intervalo invalido para el observable " + name);
+        every_[k - kNames] = every;
+    }
+
+    // sondas "x,y;x,y" (1D: "i;i")
+    std::stringstream sp(params.probes);
+    while (std::getline(sp, item, ';')){
+        if (item.empty()) continue;
+        int x = 0, y = 0;
+        char comma = 0;
+        std::istringstream is(item);
+        if (!(is >> x)) throw std::runtime_error("sonda invalida: " + item);
+        if (is >> comma && !(comma == ',' && is >> y)) throw std::runtime_error("sonda invalida: " + item);
+        if (x < 0 || x >= Lx_ || y < 0 || y >= Ly_) throw std::runtime_error("sonda fuera de la red: " + item);
+        probes_.push_back(y*Lx_ + x);
+    }
+    if (!probes_.empty() && every_[Probes] == 0) every_[Probes] = 1;
+    if (every_[Probes] > 0 && probes_.empty()) throw std::runtime_error("--observe probes sin ninguna --probe");
+
+    for (int k=0; k<kKinds; ++k) enabled_ = enabled_ || every_[k] > 0;
+    out_[Energy].cols = {"step", "energy"};
+    out_[Max].cols = {"step", "max_abs", "value", "x", "y"};
+    out_[Centroid].cols = {"step", "sum_a2", "cx", "cy", "sx", "sy"};
+    out_[Probes].cols = {"step"};
+    for (int i : probes_){
+        std::ostringstream n;
+        n << i % Lx_;
+        if (is2D_) n << ',' << i / Lx_;
+        out_[Probes].cols.push_back(n.str());
+    }
+    probe_row_.assign(out_[Probes].cols.size(), 0.0);
+    resetPartials();
+}
+
+void Observables::mapNodes(const std::vector<int>& to_orig){
+    if (every_[Centroid] > 0) throw std::runtime_error("--observe centroid no esta disponible con --reorder");
+    std::vector<int> to_internal(to_orig.size());
+    for (size_t k=0; k<to_orig.size(); ++k) to_internal[to_orig[k]] = (int)k;
+    for (int& i : probes_) i = to_internal[i];
+    to_orig_ = to_orig;
+}
+
+void Observables::resetPartials(){
+    for (Partial& p : part_){
+        p = Partial{};
+        p.max_abs = -1.0;
+        p.argmax = LONG_MAX;
+    }
+}
+
+void Observables::open(long steps_done){
+    if (!enabled_) return;
+    std::error_code ec;
+    std::filesystem::create_directories("results/observables", ec);
+    for (int k=0; k<kKinds; ++k){
+        if (every_[k] > 0) open_stream((Kind)k, std::string("results/observables/") + kNames[k] + ".bin", steps_done);
+    }
+}
+
+void Observables::open_stream(Kind k, const std::string& path, long steps_done){
+    Stream& s = out_[k];
+    const uint32_t ncols = (uint32_t)s.cols.size();
+    std::vector<char> hdr(kHeader + kName * ncols, 0);
+    std::memcpy(hdr.data(), kMagic, sizeof(kMagic));
+    store_le<uint32_t>(hdr.data() + 8, kVersion);
+    store_le<uint32_t>(hdr.data() + 12, ncols);
+    for (uint32_t c=0; c<ncols; ++c)
+        std::strncpy(hdr.data() + kHeader + kName*c, s.cols[c].c_str(), kName - 1);
+
+    std::error_code ec;
+    if (steps_done > 0 && std::filesystem::exists(path, ec)){
+        // continuacion: se conservan los registros hasta el paso del checkpoint
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> old(hdr.size());
+        if (in.read(old.data(), (std::streamsize)old.size()) && old == hdr){
+            const size_t rec = sizeof(double) * ncols;
+            const uint64_t size = std::filesystem::file_size(path, ec);
+            uint64_t whole = hdr.size() + (size - hdr.size()) / rec * rec;
+            for (uint64_t off = hdr.size(); off < whole; off += rec){
+                double step;
+                in.seekg((std::streamoff)off);
+                if (!in.read(reinterpret_cast<char*>(&step), sizeof(step))) break;
+                if (step > (double)steps_done){ whole = off; break; }
+            }
+            in.close();
+            if (!ec && whole != size) std::filesystem::resize_file(path, whole, ec);
+            s.f.open(path, std::ios::binary | std::ios::app);
+            return;
+        }
+    }
+    s.f.open(path, std::ios::binary | std::ios::trunc);
+    if (!s.f) return;
+    s.f.write(hdr.data(), (std::streamsize)hdr.size());
+}
+
+void Observables::put(Kind k, const double* row){
+    std::vector<double>& b = out_[k].buf;
+    b.insert(b.end(), row, row + out_[k].cols.size());
+    if (b.size() >= kFlushDoubles) flush();
+}
+
+void Observables::flush(){
+    for (Stream& s : out_){
+        if (s.buf.empty()) continue;
+        if (s.f){
+            std::vector<char> bytes(s.buf.size() * sizeof(double));
+            for (size_t i=0; i<s.buf.size(); ++i) store_le<double>(bytes.data() + 8*i, s.buf[i]);
+            s.f.write(bytes.data(), (std::streamsize)bytes.size());
+            s.f.flush();
+        }
+        s.buf.clear();
+    }
+}
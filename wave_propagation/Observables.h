@@ -0,0 +1,188 @@
+#pragma once // para que se compile solo una vez
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+// Observables calculados durante la simulacion (--observe, --probe), en lugar
+// de volcar frames completos para analizarlos despues:
+//   energy:   sum(a^2) del paso (la misma que energy_trace.dat)
+//   max:      max|a|, su valor con signo y su nodo (x, y)
+//   centroid: centroide y dispersion de la distribucion a^2 (x, y)
+//   probes:   amplitud en los nodos pedidos con --probe
+// Cada uno tiene su propio intervalo de pasos ("max:10" = cada 10 pasos).
+//
+// max y centroid se acumulan dentro del barrido: despues de escribir una fila
+// (o un bloque en 1D) el mismo hilo la recorre todavia en cache (el row_hook de
+// stencil_sweep) y suma en su parcial, en su propia linea de cache. Las variantes sin filas
+// (collapse2, taskloop, CSR) hacen una pasada paralela sobre next en el mismo
+// paso. Las sondas se leen en la seccion single.
+//
+// Cada observable va a results/observables/<nombre>.bin:
+//   cabecera (64 bytes): "WAVEOBS1", uint32 version = 1, uint32 ncols, relleno
+//   ncols nombres de columna de 16 bytes (ASCII, relleno con ceros)
+//   registros de ncols float64 little-endian; la columna 0 es el paso
+// (scripts/read_observables.py). Los registros se juntan en un buffer y se
+// escriben por bloques.
+class Observables {
+public:
+    enum Kind { Energy = 0, Max, Centroid, Probes, kKinds };
+
+    // interpreta params.observe y params.probes (lanza si no son validos)
+    Observables(const RunParams& params, int Lx, int Ly, bool is2D, int threads);
+
+    bool enabled() const { return enabled_; }
+    // max o centroid se miden en el paso `step` (1 = primer paso)
+    bool sweepDue(long step) const { return due(Max, step) || due(Centroid, step); }
+    bool due(Kind k, long step) const { return every_[k] > 0 && step % every_[k] == 0; }
+
+    // grafo reordenado: to_orig[k] = nodo original del nodo interno k. Las
+    // sondas y el nodo del maximo siguen en la numeracion original (centroid
+    // no: sus coordenadas serian las del orden interno)
+    void mapNodes(const std::vector<int>& to_orig);
+
+    // abre los archivos; al continuar descarta los registros con paso > steps_done
+    void open(long steps_done);
+    void resetPartials();
+
+    // nodos [i0,i1) recien escritos en `a` (por el hilo tid)
+    template <class Real>
+    void accumulate(int tid, const Real* a, int i0, int i1);
+
+    // cierra el paso: combina los parciales en orden de hilo y lee las sondas en `cur`
+    template <class Real>
+    void record(long step, double E, const Real* cur);
+
+    void flush();
+
+private:
+    static constexpr int kLanes = 8;   // carriles de las sumas parciales de una fila
+    struct alignas(64) Partial {
+        double max_abs, max_val;
+        long argmax;
+        double w, wx, wy, wxx, wyy;   // sumas de a^2 ponderadas por x, y, x^2, y^2 (desde el centro de la red)
+    };
+    struct Stream {
+        std::vector<std::string> cols;
+        std::vector<double> buf;
+        std::ofstream f;
+    };
+
+    bool enabled_ = false;
+    int every_[kKinds] = {};
+    int Lx_, Ly_;
+    bool is2D_;
+    std::vector<int> probes_;   // indices de nodo
+    std::vector<int> to_orig_;  // vacio = numeracion propia
+    std::vector<double> probe_row_;
+    std::vector<Partial> part_;
+    Stream out_[kKinds];
+
+    void put(Kind k, const double* row);
+    void open_stream(Kind k, const std::string& path, long steps_done);
+};
+
+template <class Real>
+void Observables::accumulate(int tid, const Real* a, int i0, int i1){
+    Partial& p = part_[tid];
+    const bool want_max = every_[Max] > 0, want_c = every_[Centroid] > 0;
+    while (i0 < i1){
+        // tramos dentro de una fila: y constante, x consecutivos
+        const int y = i0 / Lx_, x0 = i0 - y*Lx_;
+        const int end = std::min(i1, (y + 1)*Lx_);
+        if (want_max){
+            // maximo por carriles (vectorizable) y una segunda pasada por el
+            // indice solo si la fila mejora el parcial
+            double m[kLanes] = {};
+            int i = i0;
+            for (; i + kLanes <= end; i += kLanes)
+                for (int l=0; l<kLanes; ++l) m[l] = std::max(m[l], std::fabs((double)a[i+l]));
+            double best = 0.0;
+            for (; i<end; ++i) best = std::max(best, std::fabs((double)a[i]));
+            for (int l=0; l<kLanes; ++l) best = std::max(best, m[l]);
+            if (best > p.max_abs || (best == p.max_abs && i0 < p.argmax)){
+                int arg = i0;
+                while (arg < end && std::fabs((double)a[arg]) != best) ++arg;   // (fila toda NaN: arg = end)
+                // empate: gana el nodo de menor indice (no depende del reparto)
+                if (arg < end && (best > p.max_abs || arg < p.argmax)){
+                    p.max_abs = best;
+                    p.max_val = (double)a[arg];
+                    p.argmax = arg;
+                }
+            }
+        }
+        if (want_c){
+            // coordenadas relativas al centro: menos cancelacion en x^2 - cx^2
+            const double xc = x0 - 0.5*(Lx_ - 1), yc = y - 0.5*(Ly_ - 1);
+            double w[kLanes] = {}, wx[kLanes] = {}, wxx[kLanes] = {};
+            const int n = end - i0;
+            int k = 0;
+            for (; k + kLanes <= n; k += kLanes)
+                for (int l=0; l<kLanes; ++l){
+                    const double v = (double)a[i0+k+l];
+                    const double e = v*v, x = xc + (double)(k + l);
+                    w[l] += e;
+                    wx[l] += e*x;
+                    wxx[l] += e*x*x;
+                }
+            for (; k<n; ++k){
+                const double v = (double)a[i0+k];
+                const double e = v*v, x = xc + (double)k;
+                w[0] += e;
+                wx[0] += e*x;
+                wxx[0] += e*x*x;
+            }
+            double sw = 0.0, swx = 0.0, swxx = 0.0;
+            for (int l=0; l<kLanes; ++l){ sw += w[l]; swx += wx[l]; swxx += wxx[l]; }
+            p.w += sw;
+            p.wx += swx;
+            p.wxx += swxx;
+            p.wy += sw*yc;
+            p.wyy += sw*yc*yc;
+        }
+        i0 = end;
+    }
+}
+
+template <class Real>
+void Observables::record(long step, double E, const Real* cur){
+    if (due(Energy, step)){
+        const double r[2] = {(double)step, E};
+        put(Energy, r);
+    }
+    if (sweepDue(step)){
+        Partial t = part_[0];
+        for (size_t k=1; k<part_.size(); ++k){
+            const Partial& p = part_[k];
+            if (p.max_abs > t.max_abs || (p.max_abs == t.max_abs && p.argmax < t.argmax)){
+                t.max_abs = p.max_abs; t.max_val = p.max_val; t.argmax = p.argmax;
+            }
+            t.w += p.w; t.wx += p.wx; t.wy += p.wy; t.wxx += p.wxx; t.wyy += p.wyy;
+        }
+        // max 0 (o nada recorrido, p.ej. con --active-region): el nodo 0, como en la grilla completa
+        if (!(t.max_abs > 0)){ t.max_abs = 0.0; t.max_val = 0.0; t.argmax = 0; }
+        if (due(Max, step)){
+            const long arg = to_orig_.empty() ? t.argmax : to_orig_[t.argmax];
+            const double r[5] = {(double)step, t.max_abs, t.max_val,
+                                 (double)(arg % Lx_), (double)(arg / Lx_)};
+            put(Max, r);
+        }
+        if (due(Centroid, step)){
+            const double mx = t.w > 0 ? t.wx / t.w : 0.0, my = t.w > 0 ? t.wy / t.w : 0.0;
+            const double vx = t.w > 0 ? t.wxx / t.w - mx*mx : 0.0, vy = t.w > 0 ? t.wyy / t.w - my*my : 0.0;
+            const double r[6] = {(double)step, t.w, mx + 0.5*(Lx_ - 1), my + 0.5*(Ly_ - 1),
+                                 std::sqrt(std::max(0.0, vx)), std::sqrt(std::max(0.0, vy))};
+            put(Centroid, r);
+        }
+    }
+    if (due(Probes, step)){
+        probe_row_[0] = (double)step;
+        for (size_t k=0; k<probes_.size(); ++k) probe_row_[k+1] = (double)cur[probes_[k]];
+        put(Probes, probe_row_.data());
+    }
+}
@@ -0,0 +1,238 @@
+#include "Options.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include "SimdKernels.h"
+
+void usage(){
+    std::cout << "Uso: ./wave_propagation [opciones]\n"
+              << "  --network {1d,2d,graph}\n"
+              << "  --N <int> | --Lx <int> --Ly <int> [--periodic]\n"
+              << "  --graph <archivo> --reorder {none,rcm} --partition --part-kb <int> --graph-report\n"
+              << "  --D <double> --gamma <double> --dt <double>\n"
+              << "  --steps <int>\n"
+              << "  --S0 <double> --omega <double>\n"
+              << "  --noise {off,global,pernode,single}\n"
+              << "  --omega-mu <double> --omega-sigma <double> --noise-node <int>\n"
+              << "  --schedule {static,dynamic,guided} --chunk <n|auto>\n"
+              << "  --tune-cache <archivo> --retune\n"
+              << "  --threads <int> --pin {none,compact,spread} --numa-report\n"
+              << "  --perf-counters --profile --profile-steps <int>\n"
+              << "  --taskloop --grain <int>\n"
+              << "  --energy-accum {reduction,atomic,critical}\n"
+              << "  --fused | --no-fused\n"
+              << "  --collapse2\n"
+              << "  --temporal-block <pasos> --tile <int>\n"
+              << "  --kernel {stencil,csr}\n"
+              << "  --simd {auto,scalar,sse2,avx2,avx512}\n"
+              << "  --source-resync <pasos>\n"
+              << "  --precision {f64,f32,mixed} --accuracy-report\n"
+              << "  --dump-frames --frame-every <int>\n"
+              << "  --frame-format {bin,text,compressed} --frame-dtype {f64,f32}\n"
+              << "  --frame-tol <double> --frame-keyframe <int> --frame-threads <int>\n"
+              << "  --sync-io --io-buffers <int>\n"
+              << "  --checkpoint-every <pasos> --checkpoint <archivo> --resume <archivo>\n"
+              << "  --benchmark\n"
+              << "  --microbench --bench-reps <int> --bench-warmup <int>\n"
+              << "  --ensemble <barrido> --ensemble-out <dir>\n"
+              << "  --observe {energy,max,centroid,probes}[:cada],... --probe x[,y] (repetible)\n"
+              << "  --active-region --active-tol <double>\n"
+              << "  --spectral --spectral-every <pasos>\n"
+              << "  --backend {omp,pool} --pool-spin <int> --bench-backends\n"
+              << "  --stream <nombre> --stream-every <pasos> --stream-slots <int> --stream-dtype {f64,f32}\n";
+}
+
+static ScheduleType parse_schedule(const std::string& s){
+    if (s=="static") return ScheduleType::Static;
+    if (s=="dynamic") return ScheduleType::Dynamic;
+    if (s=="guided")  return ScheduleType::Guided;
+    throw std::runtime_error("schedule invalido");
+}
+
+static NoiseMode parse_noise(const std::string& s){
+    if (s=="off") return NoiseMode::Off;
+    if (s=="global") return NoiseMode::Global;
+    if (s=="pernode") return NoiseMode::PerNode;
+    if (s=="single") return NoiseMode::Single;
+    throw std::runtime_error("noise invalido");
+}
+
+static EnergyAccum parse_energy_accum(const std::string& s){
+    if (s=="reduction") return EnergyAccum::Reduction;
+    if (s=="atomic") return EnergyAccum::Atomic;
+    if (s=="critical") return EnergyAccum::Critical;
+    throw std::runtime_error("energy-accum invalido");
+}
+
+static KernelType parse_kernel(const std::string& s){
+    if (s=="stencil") return KernelType::Stencil;
+    if (s=="csr") return KernelType::Csr;
+    throw std::runtime_error("kernel invalido");
+}
+
+static Reorder parse_reorder(const std::string& s){
+    if (s=="none") return Reorder::None;
+    if (s=="rcm") return Reorder::Rcm;
+    throw std::runtime_error("reorder invalido");
+}
+
+static Backend parse_backend(const std::string& s){
+    if (s=="omp") return Backend::OpenMP;
+    if (s=="pool") return Backend::Pool;
+    throw std::runtime_error("backend invalido");
+}
+
+void apply_simd(const std::string& s){
+    if (s=="auto") return;
+    SimdIsa isa;
+    if (s=="scalar") isa = SimdIsa::Scalar;
+    else if (s=="sse2") isa = SimdIsa::SSE2;
+    else if (s=="avx2") isa = SimdIsa::AVX2;
+    else if (s=="avx512") isa = SimdIsa::AVX512;
+    else throw std::runtime_error("simd invalido");
+    if (!simd_select(isa)) throw std::runtime_error("la CPU no soporta simd " + s);
+    std::cout << "[simd] " << simd_kernels().name << "\n";
+}
+
+RunParams parse_args(int argc, const char* const* argv){
+    RunParams params;
+    for (int i=1;i<argc;++i){
+        std::string k = argv[i];
+        auto next = [&](const char* err){
+            if (i+1>=argc) throw std::runtime_error(err);
+            return std::string(argv[++i]);
+        };
+        if (k=="--network") params.network = next("--network <1d|2d|graph>");
+        else if (k=="--N") params.N = std::stoi(next("--N <int>"));
+        else if (k=="--Lx") params.Lx = std::stoi(next("--Lx <int>"));
+        else if (k=="--Ly") params.Ly = std::stoi(next("--Ly <int>"));
+        else if (k=="--periodic") params.periodic = true;
+        else if (k=="--graph") params.graph = next("--graph <archivo>");
+        else if (k=="--reorder") params.reorder = parse_reorder(next("--reorder <none|rcm>"));
+        else if (k=="--partition") params.partition = true;
+        else if (k=="--part-kb") params.part_kb = std::stoi(next("--part-kb <int>"));
+        else if (k=="--graph-report") params.graph_report = true;
+        else if (k=="--D") params.D = std::stod(next("--D <double>"));
+        else if (k=="--gamma") params.gamma = std::stod(next("--gamma <double>"));
+        else if (k=="--dt") params.dt = std::stod(next("--dt <double>"));
+        else if (k=="--steps"){
+            params.steps = std::stoi(next("--steps <int>"));
+            params.steps_set = true;
+        }
+        else if (k=="--S0") params.S0 = std::stod(next("--S0 <double>"));
+        else if (k=="--omega") params.omega = std::stod(next("--omega <double>"));
+        else if (k=="--noise") params.noise = parse_noise(next("--noise <off|global|pernode|single>"));
+        else if (k=="--omega-mu") params.omega_mu = std::stod(next("--omega-mu <double>"));
+        else if (k=="--omega-sigma") params.omega_sigma = std::stod(next("--omega-sigma <double>"));
+        else if (k=="--noise-node") params.noise_node = std::stoi(next("--noise-node <int>"));
+        else if (k=="--schedule") params.schedule = parse_schedule(next("--schedule <static|dynamic|guided>"));
+        else if (k=="--chunk"){
+            std::string v = next("--chunk <n|auto>");
+            if (v=="auto") params.chunk_auto = true;
+            else params.chunk = std::stoi(v);
+        }
+        else if (k=="--tune-cache") params.tune_cache = next("--tune-cache <archivo>");
+        else if (k=="--retune") params.retune = true;
+        else if (k=="--threads"){
+            params.threads = std::stoi(next("--threads <int>"));
+            params.threads_set = true;
+        }
+        else if (k=="--taskloop") params.taskloop = true;
+        else if (k=="--grain") params.grain = std::stoi(next("--grain <int>"));
+        else if (k=="--energy-accum") params.energyAccum = parse_energy_accum(next("--energy-accum <reduction|atomic|critical>"));
+        else if (k=="--fused") params.fused = true;
+        else if (k=="--no-fused") params.fused = false;
+        else if (k=="--collapse2") params.collapse2 = true;
+        else if (k=="--temporal-block") params.tb_steps = std::stoi(next("--temporal-block <pasos>"));
+        else if (k=="--tile") params.tile = std::stoi(next("--tile <int>"));
+        else if (k=="--kernel") params.kernel = parse_kernel(next("--kernel <stencil|csr>"));
+        else if (k=="--source-resync") params.src_resync = std::stoi(next("--source-resync <pasos>"));
+        else if (k=="--simd") params.simd = next("--simd <auto|scalar|sse2|avx2|avx512>");
+        else if (k=="--dump-frames") params.dump_frames = true;
+        else if (k=="--frame-every") params.frame_every = std::stoi(next("--frame-every <int>"));
+        else if (k=="--frame-format"){
+            std::string v = next("--frame-format <bin|text|compressed>");
+            if (v=="bin") params.frame_format = FrameFormat::Binary;
+            else if (v=="text") params.frame_format = FrameFormat::Text;
+            else if (v=="compressed") params.frame_format = FrameFormat::Compressed;
+            else throw std::runtime_error("frame-format invalido");
+        }
+        else if (k=="--frame-dtype"){
+            std::string v = next("--frame-dtype <f64|f32>");
+            if (v=="f64") params.frame_dtype = FrameDtype::F64;
+            else if (v=="f32") params.frame_dtype = FrameDtype::F32;
+            else throw std::runtime_error("frame-dtype invalido");
+        }
+        else if (k=="--frame-tol") params.frame_tol = std::stod(next("--frame-tol <double>"));
+        else if (k=="--frame-keyframe") params.frame_keyframe = std::stoi(next("--frame-keyframe <int>"));
+        else if (k=="--frame-threads") params.frame_threads = std::stoi(next("--frame-threads <int>"));
+        else if (k=="--sync-io") params.async_io = false;
+        else if (k=="--io-buffers") params.io_buffers = std::stoi(next("--io-buffers <int>"));
+        else if (k=="--precision"){
+            std::string v = next("--precision <f64|f32|mixed>");
+            if (v=="f64") params.precision = Precision::F64;
+            else if (v=="f32") params.precision = Precision::F32;
+            else if (v=="mixed") params.precision = Precision::Mixed;
+            else throw std::runtime_error("precision invalida");
+        }
+        else if (k=="--accuracy-report") params.accuracy_report = true;
+        else if (k=="--pin"){
+            std::string v = next("--pin <none|compact|spread>");
+            if (v=="none") params.pin = PinMode::None;
+            else if (v=="compact") params.pin = PinMode::Compact;
+            else if (v=="spread") params.pin = PinMode::Spread;
+            else throw std::runtime_error("pin invalido");
+        }
+        else if (k=="--numa-report") params.numa_report = true;
+        else if (k=="--perf-counters") params.perf_counters = true;
+        else if (k=="--profile") params.profile = true;
+        else if (k=="--profile-steps") params.profile_steps = std::stoi(next("--profile-steps <int>"));
+        else if (k=="--checkpoint-every") params.checkpoint_every = std::stoi(next("--checkpoint-every <pasos>"));
+        else if (k=="--checkpoint") params.checkpoint_path = next("--checkpoint <archivo>");
+        else if (k=="--resume") params.resume = next("--resume <archivo>");
+        else if (k=="--benchmark") params.do_bench = true;
+        else if (k=="--microbench") params.do_microbench = true;
+        else if (k=="--bench-reps") params.bench_reps = std::stoi(next("--bench-reps <int>"));
+        else if (k=="--bench-warmup") params.bench_warmup = std::stoi(next("--bench-warmup <int>"));
+        else if (k=="--ensemble") params.ensemble = next("--ensemble <barrido>");
+        else if (k=="--ensemble-out") params.ensemble_out = next("--ensemble-out <dir>");
+        else if (k=="--observe") params.observe = next("--observe <lista>");
+        else if (k=="--active-region") params.active = true;
+        else if (k=="--active-tol"){
+            params.active_tol = std::stod(next("--active-tol <double>"));
+            params.active = true;
+        }
+        else if (k=="--spectral") params.spectral = true;
+        else if (k=="--spectral-every") params.spectral_every = std::stoi(next("--spectral-every <pasos>"));
+        else if (k=="--backend") params.backend = parse_backend(next("--backend <omp|pool>"));
+        else if (k=="--pool-spin") params.pool_spin = std::stoi(next("--pool-spin <int>"));
+        else if (k=="--bench-backends") params.bench_backends = true;
+        else if (k=="--stream") params.stream = next("--stream <nombre>");
+        else if (k=="--stream-every") params.stream_every = std::stoi(next("--stream-every <pasos>"));
+        else if (k=="--stream-slots") params.stream_slots = std::stoi(next("--stream-slots <int>"));
+        else if (k=="--stream-dtype"){
+            std::string v = next("--stream-dtype <f64|f32>");
+            if (v=="f64") params.stream_dtype = FrameDtype::F64;
+            else if (v=="f32") params.stream_dtype = FrameDtype::F32;
+            else throw std::runtime_error("stream-dtype invalido");
+        }
+        else if (k=="--probe"){
+            const std::string v = next("--probe x[,y]");
+            params.probes += (params.probes.empty() ? "" : ";") + v;
+        }
+        else if (k=="--help" || k=="-h") params.help = true;
+        else throw std::runtime_error("Opcion desconocida: " + k);
+    }
+    return params;
+}
+
+int compute_auto_chunk(int N, ScheduleType st, int p){
+    if (N<=0) return 64;
+    if (st==ScheduleType::Dynamic) return 256;
+    if (st==ScheduleType::Guided)  return 64;
+    int c = std::max(64, N/std::max(1,p*8));
+    c = (c/8)*8;
+    return std::min(std::max(c,64),8192);
+}
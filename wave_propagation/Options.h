@@ -0,0 +1,23 @@
+#pragma once // para que se compile solo una vez
+
+#include <string>
+
+#include "Types.h"
+
+// Opciones de linea de comandos, compartidas por el ejecutable y la
+// biblioteca (Simulation.h, WaveApi.h): la configuracion de una simulacion
+// embebida se escribe con las mismas opciones que una corrida.
+
+void usage();
+
+// argv[0] es el nombre del programa y no se lee. Lanza std::runtime_error
+// con una opcion desconocida o un valor invalido; no imprime nada ni termina
+// el proceso (--help solo marca params.help, la ayuda la muestra main).
+RunParams parse_args(int argc, const char* const* argv);
+
+// Fuerza la ISA de los kernels SIMD; "auto" deja la deteccion por CPUID
+void apply_simd(const std::string& s);
+
+// Regla fija de --chunk auto para --benchmark, --microbench y MPI (en una
+// simulacion normal lo elige el autotuner, Autotune.h)
+int compute_auto_chunk(int N, ScheduleType st, int p);
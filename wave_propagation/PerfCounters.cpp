@@ -0,0 +1,235 @@
+#include "PerfCounters.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char* kEventNames[PerfCounters::kEvents] = {"cycles", "instructions", "llc_misses", "dtlb_misses"};
+
+#if defined(__linux__)
+// Alternativas de cada evento, en orden de preferencia: algunas CPUs (o VMs)
+// no exponen los fallos de lectura de LLC como evento de cache generico
+struct EventCode { uint32_t type; uint64_t config; };
+
+constexpr uint64_t cache_code(uint64_t cache, uint64_t op, uint64_t result){
+    return cache | (op << 8) | (result << 16);
+}
+
+const std::vector<EventCode>& event_codes(int e){
+    static const std::vector<EventCode> codes[PerfCounters::kEvents] = {
+        {{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}},
+        {{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}},
+        {{PERF_TYPE_HW_CACHE, cache_code(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+         {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}},
+        {{PERF_TYPE_HW_CACHE, cache_code(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)}},
+    };
+    return codes[e];
+}
+
+int open_event(const EventCode& c, int group){
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = c.type;
+    attr.config = c.config;
+    attr.disabled = group < 0 ? 1 : 0;   // el grupo arranca junto cuando lo habilita el lider
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+#endif
+
+std::string fmt_count(double v, bool have){
+    if (!have) return "";
+    std::ostringstream s;
+    s << std::fixed << std::setprecision(0) << v;
+    return s.str();
+}
+
+std::string fmt_ratio(double num, double den, double scale, bool have){
+    if (!have || den <= 0.0) return "";
+    std::ostringstream s;
+    s << std::setprecision(6) << scale * num / den;
+    return s.str();
+}
+
+} // namespace
+
+const char* PerfCounters::eventName(int e){ return kEventNames[e]; }
+
+PerfCounters::PerfCounters(int threads) : slots_(std::max(1, threads)) {}
+
+PerfCounters::~PerfCounters(){
+    for (int t=0; t<(int)slots_.size(); ++t) closeThread(t);
+}
+
+bool PerfCounters::Slot::read(uint64_t* v, uint64_t& en, uint64_t& run) const{
+#if defined(__linux__)
+    // formato GROUP: nr, time_enabled, time_running, valor de cada evento
+    uint64_t buf[3 + kEvents];
+    const ssize_t want = (ssize_t)((3 + nopen) * sizeof(uint64_t));
+    if (::read(leader, buf, sizeof(buf)) < want) return false;
+    en = buf[1];
+    run = buf[2];
+    for (int e=0; e<kEvents; ++e) v[e] = order[e] >= 0 ? buf[3 + order[e]] : 0;
+    return true;
+#else
+    (void)v; (void)en; (void)run;
+    return false;
+#endif
+}
+
+void PerfCounters::openThread(int tid){
+#if defined(__linux__)
+    if (tid < 0 || tid >= (int)slots_.size()) return;
+    Slot& s = slots_[tid];
+    for (int e=0; e<kEvents; ++e){
+        for (const EventCode& c : event_codes(e)){
+            const int fd = open_event(c, s.leader);
+            if (fd >= 0){
+                s.fd[e] = fd;
+                s.order[e] = s.nopen++;
+                if (s.leader < 0) s.leader = fd;
+                break;
+            }
+            if (!s.err) s.err = errno;
+        }
+    }
+    if (s.leader < 0) return;
+    ioctl(s.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(s.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    if (!s.read(s.last, s.last_enabled, s.last_running)) closeThread(tid);
+#else
+    (void)tid;
+#endif
+}
+
+void PerfCounters::closeThread(int tid){
+#if defined(__linux__)
+    if (tid < 0 || tid >= (int)slots_.size()) return;
+    Slot& s = slots_[tid];
+    for (int e=0; e<kEvents; ++e){
+        if (s.fd[e] >= 0 && s.fd[e] != s.leader) ::close(s.fd[e]);
+        s.fd[e] = -1;
+    }
+    if (s.leader >= 0) ::close(s.leader);
+    s.leader = -1;
+#else
+    (void)tid;
+#endif
+}
+
+void PerfCounters::mark(int tid, StepPhase p){
+    Slot& s = slots_[tid];
+    if (s.leader < 0) return;
+    uint64_t v[kEvents], en, run;
+    if (!s.read(v, en, run)) return;
+    // multiplexado: lo contado en el intervalo se escala al tiempo habilitado
+    const uint64_t den = en - s.last_enabled, drun = run - s.last_running;
+    const double scale = drun > 0 ? (double)den / (double)drun : 0.0;
+    for (int e=0; e<kEvents; ++e){
+        s.acc[(int)p][e] += (double)(v[e] - s.last[e]) * scale;
+        s.last[e] = v[e];
+    }
+    s.enabled += (double)den;
+    s.running += (double)drun;
+    s.last_enabled = en;
+    s.last_running = run;
+}
+
+bool PerfCounters::available() const{
+    for (const Slot& s : slots_) if (s.nopen > 0) return true;
+    return false;
+}
+
+std::string PerfCounters::unavailableReason() const{
+    for (const Slot& s : slots_)
+        if (s.err) return std::strerror(s.err);
+#if defined(__linux__)
+    return "ningun hilo abrio los contadores";
+#else
+    return "perf_event_open solo existe en Linux";
+#endif
+}
+
+void PerfCounters::report(std::ostream& os, const std::string& csv_path, const RunParams& p,
+                          long steps, long nodes) const{
+    if (!available()){
+        os << "[perf] contadores no disponibles (" << unavailableReason() << "), se omiten\n";
+        return;
+    }
+    // eventos que abrieron en todos los hilos que cuentan
+    bool have[kEvents];
+    double enabled = 0.0, running = 0.0;
+    for (int e=0; e<kEvents; ++e) have[e] = true;
+    for (const Slot& s : slots_){
+        if (s.nopen == 0) continue;
+        for (int e=0; e<kEvents; ++e) have[e] = have[e] && s.order[e] >= 0;
+        enabled += s.enabled;
+        running += s.running;
+    }
+    for (int e=0; e<kEvents; ++e)
+        if (!have[e]) os << "[perf] evento " << kEventNames[e] << " no disponible\n";
+    if (running < enabled)
+        os << "[perf] contadores multiplexados (" << std::fixed << std::setprecision(1)
+           << 100.0 * running / std::max(enabled, 1.0) << "% del tiempo), valores escalados\n" << std::defaultfloat;
+
+    std::error_code ec;
+    std::filesystem::path cp(csv_path);
+    if (cp.has_parent_path()) std::filesystem::create_directories(cp.parent_path(), ec);
+    const bool fresh = !std::filesystem::exists(cp, ec);
+    std::ofstream f(csv_path, std::ios::app);
+
+    if (f && fresh){
+        f << csv_run_config_header() << ",phase,thread,"
+             "cycles,instructions,llc_misses,dtlb_misses,ipc,llc_per_kinst,dtlb_per_kinst,cycles_per_node_step\n";
+    }
+    const std::string cfg = csv_run_config(p, (int)slots_.size(), steps);
+    const double work = (double)std::max(1L, steps) * (double)std::max(1L, nodes);
+    auto row = [&](const char* phase, const std::string& thread, const double* c){
+        if (!f) return;
+        f << cfg << ',' << phase << ',' << thread;
+        for (int e=0; e<kEvents; ++e) f << ',' << fmt_count(c[e], have[e]);
+        f << ',' << fmt_ratio(c[1], c[0], 1.0, have[0] && have[1])
+          << ',' << fmt_ratio(c[2], c[1], 1000.0, have[1] && have[2])
+          << ',' << fmt_ratio(c[3], c[1], 1000.0, have[1] && have[3])
+          << ',' << fmt_ratio(c[0], work, 1.0, have[0]) << '\n';
+    };
+
+    os << "[perf] fase            ciclos           instr     IPC  LLC/kinstr dTLB/kinstr\n";
+    double total[kEvents] = {};
+    for (int ph=0; ph<kPhases; ++ph){
+        double sum[kEvents] = {};
+        for (int t=0; t<(int)slots_.size(); ++t){
+            const Slot& s = slots_[t];
+            if (s.nopen == 0) continue;
+            row(step_phase_name((StepPhase)ph), std::to_string(t), s.acc[ph]);
+            for (int e=0; e<kEvents; ++e) sum[e] += s.acc[ph][e];
+        }
+        row(step_phase_name((StepPhase)ph), "all", sum);
+        for (int e=0; e<kEvents; ++e) total[e] += sum[e];
+        os << "[perf] " << std::left << std::setw(9) << step_phase_name((StepPhase)ph) << std::right
+           << ' ' << std::setw(15) << fmt_count(sum[0], have[0])
+           << ' ' << std::setw(15) << fmt_count(sum[1], have[1])
+           << ' ' << std::setw(7) << fmt_ratio(sum[1], sum[0], 1.0, have[0] && have[1])
+           << ' ' << std::setw(11) << fmt_ratio(sum[2], sum[1], 1000.0, have[1] && have[2])
+           << ' ' << std::setw(11) << fmt_ratio(sum[3], sum[1], 1000.0, have[1] && have[3]) << "\n";
+    }
+    row("total", "all", total);
+    os << "[perf] ciclos por nodo y paso: " << fmt_ratio(total[0], work, 1.0, have[0])
+       << " (resultados en " << csv_path << ")\n";
+}
@@ -0,0 +1,63 @@
+#pragma once // para que se compile solo una vez
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Profiler.h"
+#include "Types.h"
+
+// Contadores de hardware por hilo con perf_event_open (Linux): ciclos,
+// instrucciones, fallos de LLC y fallos de dTLB, solo modo usuario.
+//
+// Cada hilo abre su propio grupo (pid = 0: cuenta solo al hilo que lo abre)
+// dentro de la region paralela y llama mark(fase) al terminar cada fase
+// (StepPhase, Profiler.h; pasada su barrera): lo contado desde la marca
+// anterior se suma a esa fase (una sola lectura del
+// grupo por marca). Si el kernel multiplexa los contadores, los totales se
+// escalan por tiempo habilitado / tiempo corriendo.
+//
+// Si perf_event_open no esta disponible (otro SO, perf_event_paranoid, una
+// VM sin PMU) los eventos que no abren quedan vacios; si no abre ninguno,
+// available() es false, mark() no hace nada y la simulacion sigue igual.
+class PerfCounters {
+public:
+    static constexpr int kEvents = 4;   // cycles, instructions, llc_misses, dtlb_misses
+    static const char* eventName(int e);
+
+    explicit PerfCounters(int threads);
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // llamadas por cada hilo desde la region paralela
+    void openThread(int tid);
+    void closeThread(int tid);
+    void mark(int tid, StepPhase p);
+
+    bool available() const;
+    std::string unavailableReason() const;
+
+    // Resumen por fase (suma de hilos) en os y filas por fase e hilo (y "all")
+    // agregadas a csv_path, con la configuracion de la corrida en cada fila
+    // para poder juntar varias corridas (scripts/analyze_matrix.py).
+    void report(std::ostream& os, const std::string& csv_path, const RunParams& p,
+                long steps, long nodes) const;
+
+private:
+    static constexpr int kPhases = (int)StepPhase::Count;
+    struct alignas(64) Slot {
+        int leader = -1;
+        int fd[kEvents] = {-1, -1, -1, -1};
+        int order[kEvents] = {-1, -1, -1, -1};   // posicion de cada evento en la lectura del grupo
+        int nopen = 0;
+        int err = 0;                              // errno del primer evento que no abrio
+        uint64_t last[kEvents] = {};
+        uint64_t last_enabled = 0, last_running = 0;
+        double acc[kPhases][kEvents] = {};
+        double enabled = 0.0, running = 0.0;
+        bool read(uint64_t* v, uint64_t& enabled, uint64_t& running) const;
+    };
+    std::vector<Slot> slots_;
+};
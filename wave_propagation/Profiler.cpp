@@ -0,0 +1,170 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <omp.h>
+
+namespace {
+
+const char* kPhaseNames[(int)StepPhase::Count] = {"update", "energy", "commit", "source", "serial"};
+
+void open_append(std::ofstream& f, const std::string& path, bool& fresh){
+    std::error_code ec;
+    std::filesystem::path fp(path);
+    if (fp.has_parent_path()) std::filesystem::create_directories(fp.parent_path(), ec);
+    fresh = !std::filesystem::exists(fp, ec);
+    f.open(path, std::ios::app);
+}
+
+} // namespace
+
+const char* step_phase_name(StepPhase p){ return kPhaseNames[(int)p]; }
+
+const char* csv_run_config_header(){
+    return "network,size,schedule,chunk,threads,steps,precision";
+}
+
+std::string csv_run_config(const RunParams& p, int threads, long steps){
+    std::ostringstream s;
+    s << p.network << ',' << (p.network == "1d" ? std::to_string(p.N) : std::to_string(p.Lx) + "x" + std::to_string(p.Ly))
+      << ',' << (p.schedule == ScheduleType::Static ? "static" : p.schedule == ScheduleType::Dynamic ? "dynamic" : "guided")
+      << ',' << p.chunk << ',' << threads << ',' << steps
+      << ',' << (p.precision == Precision::F64 ? "f64" : p.precision == Precision::F32 ? "f32" : "mixed");
+    return s.str();
+}
+
+PhaseProfiler::PhaseProfiler(int threads, int trace_steps)
+    : slots_(std::max(1, threads)), trace_steps_(std::max(0, trace_steps))
+{
+    // reserva fuera del bucle: una fase por paso y por hilo, como maximo kPhases
+    for (Slot& s : slots_){
+        s.cap = (size_t)std::max(0, trace_steps) * kPhases;
+        s.events.reserve(s.cap);
+    }
+    t_start_ = omp_get_wtime();
+}
+
+void PhaseProfiler::begin(int tid){
+    Slot& s = slots_[tid];
+    s.last = omp_get_wtime();
+    s.done = -1.0;
+}
+
+void PhaseProfiler::computeDone(int tid){
+    slots_[tid].done = omp_get_wtime();
+}
+
+void PhaseProfiler::phaseDone(int tid, StepPhase p){
+    Slot& s = slots_[tid];
+    const double now = omp_get_wtime();
+    const double done = s.done >= s.last ? s.done : now;   // sin computeDone: todo es computo
+    s.compute[(int)p] += done - s.last;
+    s.wait[(int)p] += now - done;
+    ++s.calls[(int)p];
+    if (s.events.size() < s.cap)
+        s.events.push_back({s.last - t_start_, done - t_start_, now - t_start_, (int)p});
+    s.last = now;
+    s.done = -1.0;
+}
+
+void PhaseProfiler::report(std::ostream& os, const std::string& csv_path, const std::string& trace_path,
+                           const RunParams& p, long steps) const{
+    const int nth = (int)slots_.size();
+
+    // desbalance por paso: el evento k de cada hilo es la misma fase del mismo
+    // paso (todos los hilos pasan por las mismas barreras)
+    size_t nev = slots_[0].events.size();
+    for (const Slot& s : slots_) nev = std::min(nev, s.events.size());
+    double step_max[kPhases] = {}, step_mean[kPhases] = {};
+    for (size_t k=0; k<nev; ++k){
+        const int ph = slots_[0].events[k].phase;
+        double mx = 0.0, sum = 0.0;
+        for (const Slot& s : slots_){
+            const double c = s.events[k].t1 - s.events[k].t0;
+            mx = std::max(mx, c);
+            sum += c;
+        }
+        step_max[ph] += mx;
+        step_mean[ph] += sum / nth;
+    }
+
+    std::ofstream f;
+    bool fresh = false;
+    open_append(f, csv_path, fresh);
+    if (f && fresh)
+        f << csv_run_config_header() << ",phase,thread,compute_s,wait_s,calls,imbalance,step_imbalance\n";
+    const std::string cfg = csv_run_config(p, nth, steps);
+
+    double total_c = 0.0, total_w = 0.0;
+    os << "[profile] fase     computo[s]  espera[s]  espera%  max/media-1  por paso\n";
+    for (int ph=0; ph<kPhases; ++ph){
+        double sum_c = 0.0, sum_w = 0.0, max_c = 0.0;
+        long calls = 0;
+        for (int t=0; t<nth; ++t){
+            const Slot& s = slots_[t];
+            sum_c += s.compute[ph];
+            sum_w += s.wait[ph];
+            max_c = std::max(max_c, s.compute[ph]);
+            calls = std::max(calls, s.calls[ph]);
+            if (f) f << cfg << ',' << kPhaseNames[ph] << ',' << t << ',' << s.compute[ph] << ','
+                     << s.wait[ph] << ',' << s.calls[ph] << ",,\n";
+        }
+        if (calls == 0) continue;
+        total_c += sum_c;
+        total_w += sum_w;
+        // imbalance = max/media - 1 del computo: 0 con reparto perfecto, nth-1 si trabaja un solo hilo
+        const double mean_c = sum_c / nth;
+        const double imb = mean_c > 0.0 ? max_c / mean_c - 1.0 : 0.0;
+        const double step_imb = step_mean[ph] > 0.0 ? step_max[ph] / step_mean[ph] - 1.0 : 0.0;
+        if (f){
+            // sin linea de tiempo (--profile-steps 0) no hay desbalance por paso
+            f << cfg << ',' << kPhaseNames[ph] << ",all," << sum_c << ',' << sum_w << ',' << calls << ',' << imb << ',';
+            if (nev > 0) f << step_imb;
+            f << '\n';
+        }
+        os << "[profile] " << std::left << std::setw(7) << kPhaseNames[ph] << std::right << std::fixed
+           << std::setprecision(4) << std::setw(12) << sum_c / nth << std::setw(11) << sum_w / nth
+           << std::setprecision(1) << std::setw(8) << (sum_c + sum_w > 0 ? 100.0 * sum_w / (sum_c + sum_w) : 0.0) << '%'
+           << std::setprecision(3) << std::setw(12) << imb;
+        if (nev > 0) os << std::setw(10) << step_imb;
+        os << "\n" << std::defaultfloat;
+    }
+    // eficiencia: fraccion del tiempo de los hilos dentro del bucle que fue computo
+    os << "[profile] hilos: " << nth << ", eficiencia paralela " << std::fixed << std::setprecision(1)
+       << (total_c + total_w > 0 ? 100.0 * total_c / (total_c + total_w) : 0.0) << "%"
+       << " (resultados en " << csv_path << ", linea de tiempo de los primeros "
+       << std::min<long>(trace_steps_, steps) << " pasos en " << trace_path << ")\n" << std::defaultfloat;
+    write_trace(trace_path);
+}
+
+void PhaseProfiler::write_trace(const std::string& path) const{
+    std::error_code ec;
+    std::filesystem::path fp(path);
+    if (fp.has_parent_path()) std::filesystem::create_directories(fp.parent_path(), ec);
+    std::ofstream f(path);
+    if (!f) return;
+    // formato "Trace Event": eventos completos (ph X) con ts/dur en microsegundos
+    f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    f << std::fixed << std::setprecision(3);
+    bool first = true;
+    auto sep = [&]{ if (!first) f << ",\n"; first = false; };
+    for (int t=0; t<(int)slots_.size(); ++t){
+        sep();
+        f << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << t
+          << ",\"args\":{\"name\":\"hilo " << t << "\"}}";
+        for (const Event& e : slots_[t].events){
+            sep();
+            f << "{\"name\":\"" << kPhaseNames[e.phase] << "\",\"cat\":\"computo\",\"ph\":\"X\",\"pid\":0,\"tid\":" << t
+              << ",\"ts\":" << e.t0 * 1e6 << ",\"dur\":" << (e.t1 - e.t0) * 1e6 << "}";
+            if (e.t2 > e.t1){
+                sep();
+                f << "{\"name\":\"espera " << kPhaseNames[e.phase] << "\",\"cat\":\"espera\",\"ph\":\"X\",\"pid\":0,\"tid\":" << t
+                  << ",\"ts\":" << e.t1 * 1e6 << ",\"dur\":" << (e.t2 - e.t1) * 1e6 << "}";
+            }
+        }
+    }
+    f << "\n]}\n";
+}
@@ -0,0 +1,68 @@
+#pragma once // para que se compile solo una vez
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Types.h"
+
+// Fases del bucle temporal de WavePropagator::run. Cada fase termina en una
+// barrera; lo que un hilo pasa en esa barrera cuenta como espera de la fase.
+enum class StepPhase {
+    Update = 0,   // barrido del stencil/CSR (con energia si el paso es fusionado, o los tiles)
+    Energy,       // reduccion de energia del paso no fusionado (y pasada de observables sin row_hook)
+    Commit,       // copia next -> current del paso no fusionado
+    Source,       // rotacion de fases de la fuente
+    Serial,       // secciones single: preparar el paso, swap, energia, frames y checkpoints
+    Count
+};
+
+const char* step_phase_name(StepPhase p);
+
+// Columnas de configuracion comunes a los CSV de perfiles (perf_counters.csv,
+// profile_summary.csv) para juntar corridas en scripts/analyze_matrix.py
+const char* csv_run_config_header();
+std::string csv_run_config(const RunParams& p, int threads, long steps);
+
+// Perfil por fase y por hilo del bucle temporal (--profile).
+//
+// Cada hilo marca el fin de su trabajo en la fase (computeDone) y, pasada la
+// barrera, el fin de la fase (phaseDone): computo = desde la fase anterior
+// hasta computeDone, espera = computeDone..phaseDone. Los totales por hilo y
+// los eventos de los primeros `trace_steps` pasos van a buffers reservados de
+// antemano, uno por hilo en su propia linea de cache: en el bucle solo se lee
+// el reloj y se escribe memoria del propio hilo.
+class PhaseProfiler {
+public:
+    PhaseProfiler(int threads, int trace_steps);
+
+    void begin(int tid);                      // al entrar a la region paralela
+    void computeDone(int tid);
+    void phaseDone(int tid, StepPhase p);
+
+    // Resumen en os (computo, espera y desbalance por fase), filas por fase e
+    // hilo agregadas a csv_path y la linea de tiempo en formato Chrome trace
+    // (chrome://tracing, Perfetto) en trace_path
+    void report(std::ostream& os, const std::string& csv_path, const std::string& trace_path,
+                const RunParams& p, long steps) const;
+
+private:
+    static constexpr int kPhases = (int)StepPhase::Count;
+    struct Event {
+        double t0, t1, t2;    // inicio, fin del computo, fin de la barrera (s desde el inicio)
+        int phase;
+    };
+    struct alignas(64) Slot {
+        double last = 0.0, done = -1.0;
+        double compute[kPhases] = {};
+        double wait[kPhases] = {};
+        long calls[kPhases] = {};
+        std::vector<Event> events;
+        size_t cap = 0;
+    };
+    std::vector<Slot> slots_;
+    double t_start_ = 0.0;
+    int trace_steps_;
+
+    void write_trace(const std::string& path) const;
+};
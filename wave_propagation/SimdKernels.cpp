@@ -0,0 +1,180 @@
+#include "SimdKernels.h"
+
+// Referencia escalar y seleccion de ISA.
+
+namespace {
+
+// carriles canonicos de la suma de energia: 8 en double, 16 en float
+template <class Acc> constexpr int kLanes = sizeof(Acc) == 4 ? 16 : 8;
+
+template <class Acc>
+inline double lane_total(const Acc* p){
+    Acc e = 0;
+    for (int l=0; l<kLanes<Acc>; ++l) e += p[l];
+    return e;
+}
+
+template <class Acc>
+inline Acc update_point(Acc ai, Acc acc, Acc s, Acc dt, Acc D, Acc g){
+    return ai + dt*(D*acc - g*ai + s);
+}
+
+// Nb = 2 (1D, vecinos mid[i-1], mid[i+1]) o 4 (2D, ademas up[i], dn[i]).
+// Real = almacenamiento, Acc = aritmetica.
+template <int Nb, class Real, class Acc>
+double scalar_update(const Real* up, const Real* mid, const Real* dn, Real* out,
+                     int i0, int i1, const StepCoeffs& c, const SpanSource& s, bool energy)
+{
+    const Acc dt = (Acc)c.dt, D = (Acc)c.D, g = (Acc)c.g;
+    const Acc scale = (Acc)s.scale, uni = (Acc)s.uniform;
+    Acc p[kLanes<Acc>] = {};
+    for (int i=i0; i<i1; ++i){
+        const Acc ai = mid[i];
+        Acc acc = 0;
+        acc += ((Acc)mid[i-1] - ai);
+        acc += ((Acc)mid[i+1] - ai);
+        if constexpr (Nb == 4){
+            acc += ((Acc)up[i] - ai);
+            acc += ((Acc)dn[i] - ai);
+        }
+        const Acc si = s.values ? scale*(Acc)s.values[i] : uni;
+        out[i] = (Real)update_point(ai, acc, si, dt, D, g);
+        const Acc v = out[i];
+        if (energy) p[(i - i0) % kLanes<Acc>] += v*v;
+    }
+    return energy ? lane_total(p) : 0.0;
+}
+
+template <class Real, class Acc>
+double scalar_update3(const Real* u, Real* out, int i0, int i1,
+                      const StepCoeffs& c, const SpanSource& s, bool energy)
+{
+    return scalar_update<2, Real, Acc>(nullptr, u, nullptr, out, i0, i1, c, s, energy);
+}
+
+template <class Real, class Acc>
+double scalar_update5(const Real* up, const Real* mid, const Real* dn, Real* out,
+                      int i0, int i1, const StepCoeffs& c, const SpanSource& s, bool energy)
+{
+    return scalar_update<4, Real, Acc>(up, mid, dn, out, i0, i1, c, s, energy);
+}
+
+template <class Real, class Acc>
+double scalar_sumsq(const Real* v, int n){
+    Acc p[kLanes<Acc>] = {};
+    for (int i=0; i<n; ++i){
+        const Acc x = v[i];
+        p[i % kLanes<Acc>] += x*x;
+    }
+    return lane_total(p);
+}
+
+// Ensamble: cada carril hace las operaciones de scalar_update
+template <int Nb>
+void scalar_ens_update(const double* up, const double* mid, const double* dn, double* out,
+                       int i0, int i1, const EnsCoeffs& c, const EnsSource& s, double* energy)
+{
+    constexpr int L = kEnsLanes;
+    double p[L] = {};
+    for (int i=i0; i<i1; ++i){
+        for (int m=0; m<L; ++m){
+            const int o = i*L + m;
+            const double ai = mid[o];
+            double acc = 0;
+            acc += (mid[o-L] - ai);
+            acc += (mid[o+L] - ai);
+            if constexpr (Nb == 4){
+                acc += (up[o] - ai);
+                acc += (dn[o] - ai);
+            }
+            const double si = s.values ? s.scale[m]*s.values[o] : s.uniform[m];
+            const double v = out[o] = update_point(ai, acc, si, c.dt, c.D[m], c.g[m]);
+            if (energy) p[m] += v*v;
+        }
+    }
+    // la suma del tramo se agrega al final, como en los kernels SIMD
+    if (energy) for (int m=0; m<L; ++m) energy[m] += p[m];
+}
+
+void scalar_ens_update3(const double* u, double* out, int i0, int i1,
+                        const EnsCoeffs& c, const EnsSource& s, double* energy)
+{
+    scalar_ens_update<2>(nullptr, u, nullptr, out, i0, i1, c, s, energy);
+}
+
+void scalar_ens_update5(const double* up, const double* mid, const double* dn, double* out,
+                        int i0, int i1, const EnsCoeffs& c, const EnsSource& s, double* energy)
+{
+    scalar_ens_update<4>(up, mid, dn, out, i0, i1, c, s, energy);
+}
+
+void scalar_rotate(double* s, double* c, const double* cw, const double* sw, int n, int k){
+    for (int i=0; i<n; ++i){
+        double si = s[i], ci = c[i];
+        for (int r=0; r<k; ++r){
+            const double sn = si*cw[i] + ci*sw[i];
+            ci = ci*cw[i] - si*sw[i];
+            si = sn;
+        }
+        s[i] = si; c[i] = ci;
+    }
+}
+
+const SimdKernels kScalar = {
+    SimdIsa::Scalar, "scalar",
+    scalar_update3<double, double>, scalar_update5<double, double>, scalar_sumsq<double, double>, scalar_rotate,
+    scalar_update3<float, float>, scalar_update5<float, float>, scalar_sumsq<float, float>,
+    scalar_update3<float, double>, scalar_update5<float, double>, scalar_sumsq<float, double>,
+    scalar_ens_update3, scalar_ens_update5};
+
+bool cpu_supports(SimdIsa isa){
+#if defined(WAVE_HAVE_X86_SIMD)
+    __builtin_cpu_init();
+    switch (isa){
+        case SimdIsa::Scalar: return true;
+        case SimdIsa::SSE2:   return __builtin_cpu_supports("sse2");
+        case SimdIsa::AVX2:   return __builtin_cpu_supports("avx2");
+        case SimdIsa::AVX512: return __builtin_cpu_supports("avx512f");
+    }
+    return false;
+#else
+    return isa == SimdIsa::Scalar;
+#endif
+}
+
+const SimdKernels* table_for(SimdIsa isa){
+#if defined(WAVE_HAVE_X86_SIMD)
+    switch (isa){
+        case SimdIsa::SSE2:   return simd_kernels_sse2();
+        case SimdIsa::AVX2:   return simd_kernels_avx2();
+        case SimdIsa::AVX512: return simd_kernels_avx512();
+        default: break;
+    }
+#endif
+    (void)isa;
+    return &kScalar;
+}
+
+const SimdKernels*& active(){
+    static const SimdKernels* k = table_for(simd_best_supported());
+    return k;
+}
+
+} // namespace
+
+SimdIsa simd_best_supported(){
+    if (cpu_supports(SimdIsa::AVX512)) return SimdIsa::AVX512;
+    if (cpu_supports(SimdIsa::AVX2))   return SimdIsa::AVX2;
+    if (cpu_supports(SimdIsa::SSE2))   return SimdIsa::SSE2;
+    return SimdIsa::Scalar;
+}
+
+const SimdKernels& simd_kernels(){
+    return *active();
+}
+
+bool simd_select(SimdIsa isa){
+    if (!cpu_supports(isa)) return false;
+    active() = table_for(isa);
+    return true;
+}
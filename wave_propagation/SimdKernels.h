@@ -0,0 +1,92 @@
+#pragma once // para que se compile solo una vez
+
+// Interfaz de los kernels vectorizados a mano (SSE2 / AVX2 / AVX-512) con
+// despacho en tiempo de ejecucion segun CPUID. Este header solo contiene tipos
+// POD: se incluye desde las unidades compiladas con -mavx2/-mavx512f y no debe
+// arrastrar funciones inline compartidas con el resto del programa.
+
+// Coeficientes del integrador explicito: a' = a + dt*(D*lap - g*a + s)
+struct StepCoeffs {
+    double dt;
+    double D;
+    double g;
+};
+
+// Fuente de un tramo: s_i = scale*values[i] si values != nullptr, si no uniform
+struct SpanSource {
+    const double* values;
+    double scale;
+    double uniform;
+};
+
+// Ensamble (Ensemble.h): kEnsLanes simulaciones intercaladas por nodo, el
+// valor del miembro m en el nodo i esta en u[i*kEnsLanes + m]
+constexpr int kEnsLanes = 8;
+
+// Coeficientes por miembro del ensamble (dt es comun)
+struct EnsCoeffs {
+    double dt;
+    double D[kEnsLanes];
+    double g[kEnsLanes];
+};
+
+// Fuente por miembro: s = scale[m]*values[i*kEnsLanes + m] si values != nullptr, si no uniform[m]
+struct EnsSource {
+    const double* values;
+    double scale[kEnsLanes];
+    double uniform[kEnsLanes];
+};
+
+enum class SimdIsa { Scalar = 0, SSE2, AVX2, AVX512 };
+
+// Todos los kernels dan resultados identicos bit a bit a la referencia escalar:
+// misma secuencia de operaciones por nodo (sin FMA) y la energia se acumula en
+// 8 carriles fijos (carril = (i-i0) % 8) que se suman en orden al final.
+//
+// Variantes de precision (--precision):
+//  - *_f32:   amplitudes float y aritmetica float (la energia en 16 carriles float)
+//  - *_mixed: amplitudes float, laplaciano y energia en double (8 carriles);
+//             la energia es la del valor ya redondeado a float
+// La fuente (SpanSource) sigue en double y se convierte al cargarla.
+struct SimdKernels {
+    SimdIsa isa;
+    const char* name;
+    // 1D: out[i], i en [i0,i1), vecinos u[i-1] y u[i+1]. Devuelve sum(out^2) si energy.
+    double (*update3)(const double* u, double* out, int i0, int i1,
+                      const StepCoeffs& c, const SpanSource& s, bool energy);
+    // 2D: fila con vecinos mid[i-1], mid[i+1], up[i], dn[i] (orden izq, der, arriba, abajo)
+    double (*update5)(const double* up, const double* mid, const double* dn, double* out,
+                      int i0, int i1, const StepCoeffs& c, const SpanSource& s, bool energy);
+    // sum(v[i]^2), i en [0,n)
+    double (*sumsq)(const double* v, int n);
+    // k rotaciones de fase: (s,c) <- (s*cw + c*sw, c*cw - s*sw), i en [0,n)
+    void (*rotate)(double* s, double* c, const double* cw, const double* sw, int n, int k);
+
+    double (*update3_f32)(const float* u, float* out, int i0, int i1,
+                          const StepCoeffs& c, const SpanSource& s, bool energy);
+    double (*update5_f32)(const float* up, const float* mid, const float* dn, float* out,
+                          int i0, int i1, const StepCoeffs& c, const SpanSource& s, bool energy);
+    double (*sumsq_f32)(const float* v, int n);
+    double (*update3_mixed)(const float* u, float* out, int i0, int i1,
+                            const StepCoeffs& c, const SpanSource& s, bool energy);
+    double (*update5_mixed)(const float* up, const float* mid, const float* dn, float* out,
+                            int i0, int i1, const StepCoeffs& c, const SpanSource& s, bool energy);
+    double (*sumsq_mixed)(const float* v, int n);
+
+    // Ensamble: nodos [i0,i1) con todos sus carriles (indices de nodo, no de
+    // double). Mismas operaciones por carril que update3/update5; con energy
+    // suma out^2 de cada miembro, nodo por nodo, en energy[m].
+    void (*ens_update3)(const double* u, double* out, int i0, int i1,
+                        const EnsCoeffs& c, const EnsSource& s, double* energy);
+    void (*ens_update5)(const double* up, const double* mid, const double* dn, double* out,
+                        int i0, int i1, const EnsCoeffs& c, const EnsSource& s, double* energy);
+};
+
+const SimdKernels& simd_kernels();        // kernels activos (detectados al primer uso)
+bool simd_select(SimdIsa isa);            // fuerza una ISA; false si la CPU no la soporta
+SimdIsa simd_best_supported();            // mejor ISA disponible en esta CPU
+
+// Tablas por ISA (definidas en SimdKernelsIsa.cpp, compilado una vez por ISA)
+const SimdKernels* simd_kernels_sse2();
+const SimdKernels* simd_kernels_avx2();
+const SimdKernels* simd_kernels_avx512();
@@ -0,0 +1,367 @@
+// Kernels vectorizados. Este archivo se compila una vez por ISA con
+// -DWAVE_SIMD_ISA=1 (-msse2), 2 (-mavx2) o 3 (-mavx512f); el binario principal
+// se compila sin -march para que sea portable y elige la tabla en tiempo de
+// ejecucion. Todo es static: ninguna funcion de este archivo puede terminar
+// enlazada en codigo generico.
+//
+// Resultados identicos a la referencia escalar de SimdKernels.cpp: mismas
+// operaciones por nodo (el Makefile compila con -ffp-contract=off, sin FMA) y
+// la energia en L carriles (8 en double, 16 en float): R = L/W registros
+// acumulan bloques de L nodos, la cola escalar cae en los carriles 0..rem-1 y
+// los carriles se suman en orden.
+
+#include "SimdKernels.h"
+
+#if defined(WAVE_SIMD_ISA)
+
+#include <immintrin.h>
+
+namespace {
+
+// Vec<Acc>: registro de W valores Acc. load/put aceptan almacenamiento double
+// o float (modo mixto: se convierte al cargar y se redondea al guardar; put
+// devuelve el valor efectivamente guardado). src() carga la fuente (double).
+template <class Acc> struct Vec;
+
+#if WAVE_SIMD_ISA == 1
+template <> struct Vec<double> {
+    typedef __m128d V;
+    static constexpr int W = 2;
+    static V load(const double* p){ return _mm_loadu_pd(p); }
+    static V load(const float* p){ return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p)))); }
+    static void store(double* p, V v){ _mm_storeu_pd(p, v); }
+    static V put(double* p, V v){ store(p, v); return v; }
+    static V put(float* p, V v){
+        const __m128 f = _mm_cvtpd_ps(v);
+        _mm_store_sd(reinterpret_cast<double*>(p), _mm_castps_pd(f));
+        return _mm_cvtps_pd(f);
+    }
+    static V src(const double* p){ return load(p); }
+    static V set1(double x){ return _mm_set1_pd(x); }
+    static V zero(){ return _mm_setzero_pd(); }
+    static V add(V a, V b){ return _mm_add_pd(a, b); }
+    static V sub(V a, V b){ return _mm_sub_pd(a, b); }
+    static V mul(V a, V b){ return _mm_mul_pd(a, b); }
+};
+template <> struct Vec<float> {
+    typedef __m128 V;
+    static constexpr int W = 4;
+    static V load(const float* p){ return _mm_loadu_ps(p); }
+    static void store(float* p, V v){ _mm_storeu_ps(p, v); }
+    static V put(float* p, V v){ store(p, v); return v; }
+    static V src(const double* p){ return _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(p)), _mm_cvtpd_ps(_mm_loadu_pd(p + 2))); }
+    static V set1(float x){ return _mm_set1_ps(x); }
+    static V zero(){ return _mm_setzero_ps(); }
+    static V add(V a, V b){ return _mm_add_ps(a, b); }
+    static V sub(V a, V b){ return _mm_sub_ps(a, b); }
+    static V mul(V a, V b){ return _mm_mul_ps(a, b); }
+};
+#define WAVE_SIMD_ENTRY simd_kernels_sse2
+#define WAVE_SIMD_NAME "sse2"
+#define WAVE_SIMD_TAG SimdIsa::SSE2
+#elif WAVE_SIMD_ISA == 2
+template <> struct Vec<double> {
+    typedef __m256d V;
+    static constexpr int W = 4;
+    static V load(const double* p){ return _mm256_loadu_pd(p); }
+    static V load(const float* p){ return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+    static void store(double* p, V v){ _mm256_storeu_pd(p, v); }
+    static V put(double* p, V v){ store(p, v); return v; }
+    static V put(float* p, V v){
+        const __m128 f = _mm256_cvtpd_ps(v);
+        _mm_storeu_ps(p, f);
+        return _mm256_cvtps_pd(f);
+    }
+    static V src(const double* p){ return load(p); }
+    static V set1(double x){ return _mm256_set1_pd(x); }
+    static V zero(){ return _mm256_setzero_pd(); }
+    static V add(V a, V b){ return _mm256_add_pd(a, b); }
+    static V sub(V a, V b){ return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b){ return _mm256_mul_pd(a, b); }
+};
+template <> struct Vec<float> {
+    typedef __m256 V;
+    static constexpr int W = 8;
+    static V load(const float* p){ return _mm256_loadu_ps(p); }
+    static void store(float* p, V v){ _mm256_storeu_ps(p, v); }
+    static V put(float* p, V v){ store(p, v); return v; }
+    static V src(const double* p){
+        const __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(p));
+        const __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(p + 4));
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    }
+    static V set1(float x){ return _mm256_set1_ps(x); }
+    static V zero(){ return _mm256_setzero_ps(); }
+    static V add(V a, V b){ return _mm256_add_ps(a, b); }
+    static V sub(V a, V b){ return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b){ return _mm256_mul_ps(a, b); }
+};
+#define WAVE_SIMD_ENTRY simd_kernels_avx2
+#define WAVE_SIMD_NAME "avx2"
+#define WAVE_SIMD_TAG SimdIsa::AVX2
+#elif WAVE_SIMD_ISA == 3
+template <> struct Vec<double> {
+    typedef __m512d V;
+    static constexpr int W = 8;
+    static V load(const double* p){ return _mm512_loadu_pd(p); }
+    static V load(const float* p){ return _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(p)); }
+    static void store(double* p, V v){ _mm512_storeu_pd(p, v); }
+    static V put(double* p, V v){ store(p, v); return v; }
+    static V put(float* p, V v){
+        const __m256 f = _mm512_maskz_cvtpd_ps(0xFF, v);
+        _mm256_storeu_ps(p, f);
+        return _mm512_maskz_cvtps_pd(0xFF, f);
+    }
+    static V src(const double* p){ return load(p); }
+    static V set1(double x){ return _mm512_set1_pd(x); }
+    static V zero(){ return _mm512_setzero_pd(); }
+    static V add(V a, V b){ return _mm512_add_pd(a, b); }
+    static V sub(V a, V b){ return _mm512_sub_pd(a, b); }
+    static V mul(V a, V b){ return _mm512_mul_pd(a, b); }
+};
+template <> struct Vec<float> {
+    typedef __m512 V;
+    static constexpr int W = 16;
+    static V load(const float* p){ return _mm512_loadu_ps(p); }
+    static void store(float* p, V v){ _mm512_storeu_ps(p, v); }
+    static V put(float* p, V v){ store(p, v); return v; }
+    static V src(const double* p){
+        // mascara completa: mismas conversiones sin los registros "undefined" de los intrinsics
+        const __m256 lo = _mm512_maskz_cvtpd_ps(0xFF, _mm512_loadu_pd(p));
+        const __m256 hi = _mm512_maskz_cvtpd_ps(0xFF, _mm512_loadu_pd(p + 8));
+        const __m512d wide = _mm512_maskz_insertf64x4(0xFF, _mm512_setzero_pd(), _mm256_castps_pd(lo), 0);
+        return _mm512_castpd_ps(_mm512_maskz_insertf64x4(0xFF, wide, _mm256_castps_pd(hi), 1));
+    }
+    static V set1(float x){ return _mm512_set1_ps(x); }
+    static V zero(){ return _mm512_setzero_ps(); }
+    static V add(V a, V b){ return _mm512_add_ps(a, b); }
+    static V sub(V a, V b){ return _mm512_sub_ps(a, b); }
+    static V mul(V a, V b){ return _mm512_mul_ps(a, b); }
+};
+#define WAVE_SIMD_ENTRY simd_kernels_avx512
+#define WAVE_SIMD_NAME "avx512"
+#define WAVE_SIMD_TAG SimdIsa::AVX512
+#else
+#error "WAVE_SIMD_ISA debe ser 1 (sse2), 2 (avx2) o 3 (avx512)"
+#endif
+
+// carriles canonicos de la energia: 8 en double, 16 en float
+template <class Acc> constexpr int kLanes = sizeof(Acc) == 4 ? 16 : 8;
+
+template <class Acc>
+static inline Acc point(Acc ai, Acc acc, Acc s, Acc dt, Acc D, Acc g){
+    return ai + dt*(D*acc - g*ai + s);
+}
+
+// cierre de la suma: vuelca los R registros a los carriles, suma la cola y reduce en orden
+template <class Acc>
+static inline double lane_total(const typename Vec<Acc>::V* acc, const Acc* tail){
+    using VA = Vec<Acc>;
+    constexpr int L = kLanes<Acc>, R = L / VA::W;
+    alignas(64) Acc p[L];
+    for (int r=0; r<R; ++r) VA::store(p + r*VA::W, acc[r]);
+    Acc e = 0;
+    for (int l=0; l<L; ++l) e += (p[l] + tail[l]);
+    return e;
+}
+
+// Cuerpo comun de update3/update5. Nb = 2 (1D) o 4 (2D); Real = almacenamiento,
+// Acc = aritmetica (double/double, float/float o float/double en modo mixto).
+template <int Nb, class Real, class Acc>
+static inline double update_span(const Real* up, const Real* mid, const Real* dn, Real* out,
+                                 int i0, int i1, const StepCoeffs& c, const SpanSource& s, bool energy)
+{
+    using VA = Vec<Acc>;
+    using V = typename VA::V;
+    constexpr int W = VA::W, L = kLanes<Acc>, R = L / W;
+    const Acc dt = (Acc)c.dt, D = (Acc)c.D, g = (Acc)c.g;
+    const Acc scale = (Acc)s.scale, uni = (Acc)s.uniform;
+    const V vdt = VA::set1(dt), vD = VA::set1(D), vg = VA::set1(g);
+    const V vscale = VA::set1(scale), vuni = VA::set1(uni);
+    V acc_e[R];
+    for (int r=0; r<R; ++r) acc_e[r] = VA::zero();
+
+    auto vec = [&](int i){
+        const V ai = VA::load(mid + i);
+        V acc = VA::zero();
+        acc = VA::add(acc, VA::sub(VA::load(mid + i - 1), ai));
+        acc = VA::add(acc, VA::sub(VA::load(mid + i + 1), ai));
+        if constexpr (Nb == 4){
+            acc = VA::add(acc, VA::sub(VA::load(up + i), ai));
+            acc = VA::add(acc, VA::sub(VA::load(dn + i), ai));
+        }
+        const V si = s.values ? VA::mul(vscale, VA::src(s.values + i)) : vuni;
+        const V t = VA::add(VA::sub(VA::mul(vD, acc), VA::mul(vg, ai)), si);
+        return VA::put(out + i, VA::add(ai, VA::mul(vdt, t)));
+    };
+
+    int i = i0;
+    if (energy){
+        for (; i + L <= i1; i += L){
+            for (int r=0; r<R; ++r){
+                const V v = vec(i + r*W);
+                acc_e[r] = VA::add(acc_e[r], VA::mul(v, v));
+            }
+        }
+    } else {
+        for (; i + W <= i1; i += W) vec(i);
+    }
+
+    Acc tail[L] = {};
+    for (int l=0; i<i1; ++i, ++l){
+        const Acc ai = mid[i];
+        Acc acc = 0;
+        acc += ((Acc)mid[i-1] - ai);
+        acc += ((Acc)mid[i+1] - ai);
+        if constexpr (Nb == 4){
+            acc += ((Acc)up[i] - ai);
+            acc += ((Acc)dn[i] - ai);
+        }
+        const Acc si = s.values ? scale*(Acc)s.values[i] : uni;
+        out[i] = (Real)point(ai, acc, si, dt, D, g);
+        const Acc v = out[i];
+        if (energy) tail[l] += v*v;
+    }
+    return energy ? lane_total<Acc>(acc_e, tail) : 0.0;
+}
+
+static double isa_update3(const double* u, double* out, int i0, int i1,
+                          const StepCoeffs& c, const SpanSource& s, bool energy)
+{
+    return update_span<2, double, double>(nullptr, u, nullptr, out, i0, i1, c, s, energy);
+}
+
+static double isa_update5(const double* up, const double* mid, const double* dn, double* out,
+                          int i0, int i1, const StepCoeffs& c, const SpanSource& s, bool energy)
+{
+    return update_span<4, double, double>(up, mid, dn, out, i0, i1, c, s, energy);
+}
+
+template <class Acc>
+static double isa_update3_r(const float* u, float* out, int i0, int i1,
+                            const StepCoeffs& c, const SpanSource& s, bool energy)
+{
+    return update_span<2, float, Acc>(nullptr, u, nullptr, out, i0, i1, c, s, energy);
+}
+
+template <class Acc>
+static double isa_update5_r(const float* up, const float* mid, const float* dn, float* out,
+                            int i0, int i1, const StepCoeffs& c, const SpanSource& s, bool energy)
+{
+    return update_span<4, float, Acc>(up, mid, dn, out, i0, i1, c, s, energy);
+}
+
+template <class Real, class Acc>
+static double isa_sumsq(const Real* v, int n){
+    using VA = Vec<Acc>;
+    using V = typename VA::V;
+    constexpr int W = VA::W, L = kLanes<Acc>, R = L / W;
+    V acc[R];
+    for (int r=0; r<R; ++r) acc[r] = VA::zero();
+    int i = 0;
+    for (; i + L <= n; i += L){
+        for (int r=0; r<R; ++r){
+            const V x = VA::load(v + i + r*W);
+            acc[r] = VA::add(acc[r], VA::mul(x, x));
+        }
+    }
+    Acc tail[L] = {};
+    for (int l=0; i<n; ++i, ++l){
+        const Acc x = v[i];
+        tail[l] += x*x;
+    }
+    return lane_total<Acc>(acc, tail);
+}
+
+// Ensamble: los kEnsLanes carriles de un nodo son R = kEnsLanes/W registros
+// contiguos; coeficientes, fuente y energia van por registro
+template <int Nb>
+static void isa_ens_update(const double* up, const double* mid, const double* dn, double* out,
+                           int i0, int i1, const EnsCoeffs& c, const EnsSource& s, double* energy)
+{
+    using VA = Vec<double>;
+    using V = VA::V;
+    constexpr int W = VA::W, L = kEnsLanes, R = L / W;
+    const V vdt = VA::set1(c.dt);
+    V vD[R], vg[R], vscale[R], vuni[R], acc_e[R];
+    for (int r=0; r<R; ++r){
+        vD[r] = VA::load(c.D + r*W);
+        vg[r] = VA::load(c.g + r*W);
+        vscale[r] = VA::load(s.scale + r*W);
+        vuni[r] = VA::load(s.uniform + r*W);
+        acc_e[r] = VA::zero();
+    }
+    for (int i=i0; i<i1; ++i){
+        for (int r=0; r<R; ++r){
+            const int o = i*L + r*W;
+            const V ai = VA::load(mid + o);
+            V acc = VA::zero();
+            acc = VA::add(acc, VA::sub(VA::load(mid + o - L), ai));
+            acc = VA::add(acc, VA::sub(VA::load(mid + o + L), ai));
+            if constexpr (Nb == 4){
+                acc = VA::add(acc, VA::sub(VA::load(up + o), ai));
+                acc = VA::add(acc, VA::sub(VA::load(dn + o), ai));
+            }
+            const V si = s.values ? VA::mul(vscale[r], VA::load(s.values + o)) : vuni[r];
+            const V t = VA::add(VA::sub(VA::mul(vD[r], acc), VA::mul(vg[r], ai)), si);
+            const V v = VA::put(out + o, VA::add(ai, VA::mul(vdt, t)));
+            if (energy) acc_e[r] = VA::add(acc_e[r], VA::mul(v, v));
+        }
+    }
+    if (!energy) return;
+    alignas(64) double p[L];
+    for (int r=0; r<R; ++r) VA::store(p + r*W, acc_e[r]);
+    for (int m=0; m<L; ++m) energy[m] += p[m];
+}
+
+static void isa_ens_update3(const double* u, double* out, int i0, int i1,
+                            const EnsCoeffs& c, const EnsSource& s, double* energy)
+{
+    isa_ens_update<2>(nullptr, u, nullptr, out, i0, i1, c, s, energy);
+}
+
+static void isa_ens_update5(const double* up, const double* mid, const double* dn, double* out,
+                            int i0, int i1, const EnsCoeffs& c, const EnsSource& s, double* energy)
+{
+    isa_ens_update<4>(up, mid, dn, out, i0, i1, c, s, energy);
+}
+
+static void isa_rotate(double* s, double* c, const double* cw, const double* sw, int n, int k){
+    using VA = Vec<double>;
+    using V = VA::V;
+    constexpr int W = VA::W;
+    int i = 0;
+    for (; i + W <= n; i += W){
+        V si = VA::load(s + i), ci = VA::load(c + i);
+        const V vcw = VA::load(cw + i), vsw = VA::load(sw + i);
+        for (int r=0; r<k; ++r){
+            const V sn = VA::add(VA::mul(si, vcw), VA::mul(ci, vsw));
+            ci = VA::sub(VA::mul(ci, vcw), VA::mul(si, vsw));
+            si = sn;
+        }
+        VA::store(s + i, si); VA::store(c + i, ci);
+    }
+    for (; i<n; ++i){
+        double si = s[i], ci = c[i];
+        for (int r=0; r<k; ++r){
+            const double sn = si*cw[i] + ci*sw[i];
+            ci = ci*cw[i] - si*sw[i];
+            si = sn;
+        }
+        s[i] = si; c[i] = ci;
+    }
+}
+
+const SimdKernels kTable = {
+    WAVE_SIMD_TAG, WAVE_SIMD_NAME, isa_update3, isa_update5, isa_sumsq<double, double>, isa_rotate,
+    isa_update3_r<float>, isa_update5_r<float>, isa_sumsq<float, float>,
+    isa_update3_r<double>, isa_update5_r<double>, isa_sumsq<float, double>,
+    isa_ens_update3, isa_ens_update5};
+
+} // namespace
+
+const SimdKernels* WAVE_SIMD_ENTRY(){
+    return &kTable;
+}
+
+#endif // WAVE_SIMD_ISA
@@ -0,0 +1,139 @@
+#include "Simulation.h"
+
+#include <algorithm>
+#include <climits>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <omp.h>
+
+#include "Autotune.h"
+#include "Numa.h"
+#include "Options.h"
+
+NetworkBuilder::NetworkBuilder(const RunParams& params, std::ostream* report)
+    : params_(params), is_graph_(params.network == "graph")
+{
+    if (!is_graph_){
+        if (!params_.graph.empty()) throw std::runtime_error("--graph requiere --network graph");
+        return;
+    }
+    if (params_.graph.empty()) throw std::runtime_error("--network graph requiere --graph <archivo>");
+    if (params_.part_kb < 1) throw std::runtime_error("--part-kb debe ser >= 1");
+    Graph loaded = load_graph(params_.graph);
+    if (params_.reorder == Reorder::Rcm){
+        order_ = rcm_order(loaded);
+        graph_ = permute(loaded, order_);
+    } else {
+        graph_ = loaded;
+    }
+    if (params_.partition) parts_ = partition_chunks(graph_, (size_t)params_.part_kb * 1024);
+    if (report)
+        graph_report(loaded, graph_, params_.reorder == Reorder::Rcm ? "rcm" : "none", parts_, params_.part_kb, *report);
+}
+
+int NetworkBuilder::nodes() const{
+    if (is_graph_) return graph_.n;
+    return params_.network == "1d" ? params_.N : params_.Lx * params_.Ly;
+}
+
+Network NetworkBuilder::make(int touch_chunk) const{
+    // el constructor ya deja todo en 0
+    if (is_graph_){
+        Network n(graph_, params_.D, params_.gamma, touch_chunk, order_);
+        n.setParts(parts_);
+        n.setInitialImpulseCenter(1.0);
+        return n;
+    }
+    Network n = (params_.network == "1d")
+        ? Network(params_.N, params_.D, params_.gamma, touch_chunk)
+        : Network(params_.Lx, params_.Ly, params_.D, params_.gamma, touch_chunk);
+    if (params_.network == "1d") n.makeRegular1D(params_.periodic);
+    else                          n.makeRegular2D(params_.periodic);
+    n.setInitialImpulseCenter(1.0);
+    return n;
+}
+
+Simulation::Simulation(const RunParams& params) : params_(params){
+    if (params_.help) throw std::runtime_error("--help no se admite en la biblioteca (la ayuda es la del ejecutable)");
+    if (params_.do_bench || params_.do_microbench || params_.bench_backends || !params_.ensemble.empty() ||
+        !params_.resume.empty() || params_.accuracy_report || !params_.observe.empty() || !params_.probes.empty())
+        throw std::runtime_error("la biblioteca no admite --benchmark, --microbench, --bench-backends, --ensemble, --resume, --accuracy-report, --observe ni --probe");
+    apply_simd(params_.simd);
+    if (params_.dump_frames) std::filesystem::create_directories("results/frames");
+
+    // mismo orden que el ejecutable: hilos y afinidad antes del first touch
+    if (params_.threads > 0) omp_set_num_threads(params_.threads);
+    pin_threads(params_.pin);
+    NetworkBuilder builder(params_, params_.graph_report ? &std::cout : nullptr);
+    const bool tune = params_.chunk_auto && !params_.active && !builder.isGraph() && !params_.spectral;
+    if (params_.chunk_auto && !tune)
+        params_.chunk = compute_auto_chunk(builder.nodes(), params_.schedule, omp_get_max_threads());
+    const int touch_chunk = params_.schedule == ScheduleType::Static && !builder.partitioned() ? params_.chunk : 0;
+    net_ = std::make_unique<Network>(builder.make(touch_chunk));
+    if (tune) autotune(*net_, params_, std::cout);
+    if (params_.numa_report) numa_report(*net_, std::cout);
+    // almacenamiento de la corrida desde el principio (amplitudesF32() antes del primer paso)
+    net_->setSinglePrecision(params_.precision != Precision::F64);
+
+    wp_ = std::make_unique<WavePropagator>(*net_, params_);
+    wp_->captureEnergy(&trace_);
+}
+
+Simulation::~Simulation() = default;
+
+long Simulation::next_callback(long from, long to) const{
+    // primer paso en (from, to] en que toca algun callback (to si ninguno)
+    long stop = to;
+    for (const Callback& c : callbacks_)
+        stop = std::min(stop, (from / c.every + 1) * c.every);
+    return stop;
+}
+
+void Simulation::step(long n){
+    trace_.clear();
+    if (n <= 0) return;
+    const long target = stepsDone() + n;
+    if (target > INT_MAX) throw std::runtime_error("step: se supera el maximo de pasos de una corrida");
+    while (stepsDone() < target){
+        const long stop = next_callback(stepsDone(), target);
+        wp_->runTo(stop, "");
+        if (!trace_.empty()) energy_ = trace_.back();
+        // copia: un callback puede agregar o quitar callbacks
+        const std::vector<Callback> due = callbacks_;
+        for (const Callback& c : due)
+            if (stop % c.every == 0) c.fn(*this);
+    }
+}
+
+void Simulation::reset(){
+    net_->setAll(0.0);
+    net_->setInitialImpulseCenter(1.0);
+    wp_->rewind();
+    trace_.clear();
+    energy_ = 0.0;
+}
+
+int Simulation::onStep(StepCallback cb, int every){
+    if (every < 1) throw std::runtime_error("onStep: every debe ser >= 1");
+    callbacks_.push_back({next_id_, every, std::move(cb)});
+    return next_id_++;
+}
+
+void Simulation::removeCallback(int id){
+    callbacks_.erase(std::remove_if(callbacks_.begin(), callbacks_.end(),
+                                    [id](const Callback& c){ return c.id == id; }),
+                     callbacks_.end());
+}
+
+ConstView<double> Simulation::amplitudes() const{
+    if (net_->singlePrecision())
+        throw std::runtime_error("amplitudes(): el estado esta en float32 (--precision f32/mixed), usar amplitudesF32()");
+    return {net_->current(), nodes()};
+}
+
+ConstView<float> Simulation::amplitudesF32() const{
+    if (!net_->singlePrecision())
+        throw std::runtime_error("amplitudesF32(): el estado esta en float64, usar amplitudes()");
+    return {static_cast<const float*>(net_->storageData()), nodes()};
+}
@@ -0,0 +1,120 @@
+#pragma once // para que se compile solo una vez
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "Types.h"
+#include "Graph.h"
+#include "Network.h"
+#include "WavePropagator.h"
+
+// Red descrita por RunParams: grilla regular 1D/2D o grafo cargado (con
+// --reorder y --partition). El grafo se lee y se reordena una sola vez; cada
+// make() construye una red nueva con el impulso inicial en el centro.
+class NetworkBuilder {
+public:
+    // report != nullptr: imprime --graph-report (orden del archivo contra el simulado)
+    explicit NetworkBuilder(const RunParams& params, std::ostream* report = nullptr);
+
+    bool isGraph() const { return is_graph_; }
+    int nodes() const;
+    // --partition: el first touch va por tramos (un bloque contiguo por hilo)
+    bool partitioned() const { return !parts_.empty(); }
+    Network make(int touch_chunk) const;
+
+private:
+    RunParams params_;
+    bool is_graph_ = false;
+    Graph graph_;
+    std::vector<int> order_, parts_;
+};
+
+// Vista de solo lectura sobre un arreglo de la simulacion (sin copia). Sigue
+// valida hasta el proximo step() o reset().
+template <class T>
+struct ConstView {
+    const T* ptr = nullptr;
+    size_t count = 0;
+
+    const T* data() const { return ptr; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + count; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+};
+
+// Simulacion embebible: la red se construye una vez y se avanza por tramos.
+//
+//   RunParams p = parse_args(argc, argv);      // o campos a mano
+//   Simulation sim(p);
+//   sim.onStep([](const Simulation& s){ ... s.amplitudes() ... }, 10);
+//   sim.step(1000);
+//   sim.reset();                                // mismo estado inicial, misma red
+//
+// step(n) equivale a los pasos stepsDone()+1 .. stepsDone()+n de una corrida
+// del ejecutable con las mismas opciones (mismas amplitudes bit a bit): cada
+// tramo es un WavePropagator::run() que continua donde quedo el anterior. Un
+// tramo termina en cada paso en que toca un callback, asi que los callbacks
+// ven el estado confirmado de ese paso, sin copia, en el hilo que llamo a
+// step(). Frames, checkpoints y --stream se escriben igual que en una corrida;
+// la energia no va a archivo: energies() devuelve la de cada paso del ultimo
+// step(). Con --noise pernode/single las frecuencias se sortean una vez y
+// reset() las conserva.
+class Simulation {
+public:
+    using StepCallback = std::function<void(const Simulation&)>;
+
+    // Fija hilos, afinidad e ISA (procesales, como el ejecutable) y construye
+    // la red. Lanza std::runtime_error con opciones que no aplican a una
+    // simulacion embebida (benchmarks, ensambles, --resume, observables).
+    explicit Simulation(const RunParams& params);
+    ~Simulation();
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    // avanza n pasos (n <= 0 no hace nada)
+    void step(long n);
+    // vuelve al estado inicial sin reconstruir la red ni el grafo
+    void reset();
+
+    // callback despues de cada paso multiplo de `every` (>= 1); devuelve un id
+    int onStep(StepCallback cb, int every = 1);
+    void removeCallback(int id);
+
+    long stepsDone() const { return wp_->stepsDone(); }
+    double time() const { return wp_->time(); }
+    // energia del ultimo paso (0 antes del primero)
+    double energy() const { return energy_; }
+    // energia de cada paso del ultimo step()
+    ConstView<double> energies() const { return {trace_.data(), trace_.size()}; }
+
+    int nx() const { return net_->Lx(); }
+    int ny() const { return net_->is2D() ? net_->Ly() : 1; }
+    size_t nodes() const { return (size_t)net_->size(); }
+    bool singlePrecision() const { return net_->singlePrecision(); }
+    // estado confirmado; amplitudes() con --precision f64, amplitudesF32() con
+    // f32/mixed (la otra lanza). Grafo reordenado: orden interno, ver originalIds()
+    ConstView<double> amplitudes() const;
+    ConstView<float> amplitudesF32() const;
+    ConstView<int> originalIds() const { return {net_->originalIds().data(), net_->originalIds().size()}; }
+
+    const RunParams& params() const { return params_; }
+    const Network& network() const { return *net_; }
+
+private:
+    struct Callback { int id; int every; StepCallback fn; };
+
+    RunParams params_;
+    std::unique_ptr<Network> net_;
+    std::unique_ptr<WavePropagator> wp_;
+    std::vector<Callback> callbacks_;
+    int next_id_ = 0;
+    std::vector<double> trace_;
+    double energy_ = 0.0;
+
+    long next_callback(long from, long to) const;
+};
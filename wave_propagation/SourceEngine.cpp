@@ -0,0 +1,67 @@
+#include "SourceEngine.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "SimdKernels.h"
+
+namespace {
+constexpr int kBlock = 2048;   // osciladores por bloque en advanceParallel
+}
+
+void SourceEngine::init(const double* omega, int n, double t0, double dt, int resync){
+    s_.assign(n, 0.0);
+    c_.assign(n, 0.0);
+    cw_.assign(n, 0.0);
+    sw_.assign(n, 0.0);
+    w_.assign(n, 0.0);
+    for (int i=0; i<n; ++i){
+        w_[i]  = omega[i];
+        s_[i]  = std::sin(omega[i] * t0);
+        c_[i]  = std::cos(omega[i] * t0);
+        cw_[i] = std::cos(omega[i] * dt);
+        sw_[i] = std::sin(omega[i] * dt);
+    }
+    step_ = 0;
+    resync_ = std::max(1, resync);
+}
+
+void SourceEngine::setState(const double* s, const double* c, long step){
+    std::copy(s, s + size(), s_.data());
+    std::copy(c, c + size(), c_.data());
+    step_ = step;
+}
+
+void SourceEngine::advance_span(int i0, int i1, int k, double t){
+    if ((step_ + k) % resync_ == 0){
+        // renormalizacion: fase exacta en t (descarta el error acumulado)
+        for (int i=i0; i<i1; ++i){
+            s_[i] = std::sin(w_[i] * t);
+            c_[i] = std::cos(w_[i] * t);
+        }
+        return;
+    }
+    simd_kernels().rotate(s_.data() + i0, c_.data() + i0, cw_.data() + i0, sw_.data() + i0, i1 - i0, k);
+}
+
+void SourceEngine::advance(int k, double t){
+    advance_span(0, size(), k, t);
+    step_ += k;
+}
+
+void SourceEngine::advanceParallel(int k, double t){
+    advanceParallelNowait(k, t);
+    // todos los hilos ya leyeron step_
+    #pragma omp barrier
+    #pragma omp single nowait
+    finishParallel(k);
+}
+
+void SourceEngine::advanceParallelNowait(int k, double t){
+    const int n = size();
+    const int nblk = (n + kBlock - 1) / kBlock;
+    #pragma omp for schedule(static) nowait
+    for (int b=0; b<nblk; ++b){
+        advance_span(b*kBlock, std::min(n, (b+1)*kBlock), k, t);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once // para que se compile solo una vez
+
+#include "AlignedBuffer.h"
+
+// Osciladores sin(omega_i * t) avanzados por recurrencia de rotacion en lugar
+// de llamar a std::sin en cada paso:
+//     sin(w(t+dt)) = sin(wt)*cos(w dt) + cos(wt)*sin(w dt)
+//     cos(w(t+dt)) = cos(wt)*cos(w dt) - sin(wt)*sin(w dt)
+// cos(w dt) y sin(w dt) se precalculan una vez por oscilador. El redondeo de
+// la recurrencia se acumula, asi que cada `resync` pasos la fase se
+// renormaliza recalculandola exacta con std::sin/std::cos (resync=1 equivale
+// a evaluar el seno en cada paso).
+//
+// Los arreglos son SoA alineados: el kernel del stencil lee values()
+// directamente y la rotacion se hace con el kernel SIMD despachado.
+// Un solo oscilador cubre los modos global y single.
+class SourceEngine {
+    AlignedBuffer<double> s_, c_;    // sin/cos de la fase actual
+    AlignedBuffer<double> cw_, sw_;  // cos/sin(omega_i*dt)
+    AlignedBuffer<double> w_;        // omega_i (para renormalizar)
+    long step_ = 0;                  // pasos avanzados desde init()
+    int resync_ = 256;
+
+    void advance_span(int i0, int i1, int k, double t);
+public:
+    // n osciladores de frecuencia omega[i] con fase en t0
+    void init(const double* omega, int n, double t0, double dt, int resync);
+
+    int size() const { return (int)s_.size(); }
+    const double* values() const { return s_.data(); }   // sin(omega_i*t) del paso actual
+    const double* cosines() const { return c_.data(); }
+    const double* cosStep() const { return cw_.data(); }
+    const double* sinStep() const { return sw_.data(); }
+
+    long step() const { return step_; }
+    // restaura fases y contador guardados (checkpoint); init() debe haberse llamado con el mismo n
+    void setState(const double* s, const double* c, long step);
+
+    // pasos que se pueden avanzar antes de la proxima renormalizacion
+    int stepsToResync() const { return resync_ - (int)(step_ % resync_); }
+
+    // avanza k pasos (k <= stepsToResync()); t es el tiempo del estado final.
+    // advance() es secuencial; advanceParallel() reparte los osciladores entre
+    // los hilos (worksharing huerfano: llamar desde dentro de la region paralela).
+    void advance(int k, double t);
+    void advanceParallel(int k, double t);
+    // Igual que advanceParallel pero sin la barrera final: el que llama pone la
+    // barrera y despues, desde un solo hilo, finishParallel(k) (actualiza el
+    // contador que leen todos los hilos durante el avance)
+    void advanceParallelNowait(int k, double t);
+    void finishParallel(int k){ step_ += k; }
+    // solo los osciladores [i0,i1) de un avance repartido por otro backend
+    // (StealPool); despues, desde un solo hilo, finishParallel(k)
+    void advanceRange(int i0, int i1, int k, double t){ advance_span(i0, i1, k, t); }
+};
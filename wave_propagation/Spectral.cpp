@@ -0,0 +1,94 @@
+#include "Spectral.h"
+
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+SpectralSolver::SpectralSolver(int W, int H, const StepCoeffs& c)
+    : W_(W), H_(H), fx_(W), fy_(H), PW_(W/2 + 1), PH_(H/2 + 1),
+      hat_((size_t)W*H), buf_((size_t)W*H),
+      fold_g_((size_t)PW_*PH_), fold_w_((size_t)PW_*PH_, 0.0)
+{
+    // autovalores del laplaciano periodico por eje (1 nodo: sin vecinos distintos, 0)
+    std::vector<double> lx(PW_), ly(PH_);
+    for (int p=0; p<PW_; ++p){ const double s = std::sin(M_PI*p / W_); lx[p] = 4.0*s*s; }
+    for (int q=0; q<PH_; ++q){ const double s = std::sin(M_PI*q / H_); ly[q] = 4.0*s*s; }
+    for (int q=0; q<PH_; ++q){
+        for (int p=0; p<PW_; ++p){
+            const double G = 1.0 - c.dt*(c.D*(lx[p] + ly[q]) + c.g);
+            fold_g_[(size_t)q*PW_ + p] = G;
+            max_growth_ = std::max(max_growth_, std::fabs(G));
+        }
+    }
+}
+
+void SpectralSolver::transform(cd* a, bool inv) const{
+    const int W = W_, H = H_;
+    #pragma omp parallel
+    {
+        std::vector<cd> work(std::max(fx_.workSize(), fy_.workSize()));
+        std::vector<cd> col(H > 1 ? H : 0);
+        #pragma omp for schedule(static)
+        for (int y=0; y<H; ++y){
+            cd* row = a + (size_t)y*W;
+            if (inv) fx_.inverse(row, work.data());
+            else fx_.forward(row, work.data());
+        }
+        if (H > 1){
+            #pragma omp for schedule(static)
+            for (int x=0; x<W; ++x){
+                for (int y=0; y<H; ++y) col[y] = a[(size_t)y*W + x];
+                if (inv) fy_.inverse(col.data(), work.data());
+                else fy_.forward(col.data(), work.data());
+                for (int y=0; y<H; ++y) a[(size_t)y*W + x] = col[y];
+            }
+        }
+    }
+}
+
+void SpectralSolver::load(const double* a){
+    const size_t N = (size_t)W_*H_;
+    for (size_t i=0; i<N; ++i) hat_[i] = cd(a[i], 0.0);
+    transform(hat_.data(), false);
+    // Parseval por modo plegado
+    std::fill(fold_w_.begin(), fold_w_.end(), 0.0);
+    const double inv_n = 1.0 / (double)N;
+    for (int ky=0; ky<H_; ++ky)
+        for (int kx=0; kx<W_; ++kx)
+            fold_w_[fold(kx, ky)] += std::norm(hat_[(size_t)ky*W_ + kx]) * inv_n;
+}
+
+void SpectralSolver::energies(long first, long stride, long count, double* out){
+    // termino de cada pliegue en el paso actual; avanza multiplicando por G^(2 stride)
+    const size_t F = fold_w_.size();
+    term_.resize(F);
+    ratio_.resize(F);
+    for (size_t f=0; f<F; ++f){
+        term_[f] = fold_w_[f] * std::pow(fold_g_[f], 2.0*(double)first);
+        ratio_[f] = std::pow(fold_g_[f], 2.0*(double)stride);
+    }
+    for (long j=0; j<count; ++j){
+        double E = 0.0;
+        for (size_t f=0; f<F; ++f){
+            E += term_[f];
+            const double t = term_[f]*ratio_[f];
+            term_[f] = t < 1e-300 ? 0.0 : t;   // sin subnormales (lentos) en los modos que se apagan
+        }
+        out[j] = E;
+    }
+}
+
+void SpectralSolver::state(long n, double* out){
+    const double e = (double)n;
+    #pragma omp parallel for schedule(static)
+    for (int ky=0; ky<H_; ++ky){
+        for (int kx=0; kx<W_; ++kx){
+            const size_t i = (size_t)ky*W_ + kx;
+            buf_[i] = hat_[i] * std::pow(fold_g_[fold(kx, ky)], e);
+        }
+    }
+    transform(buf_.data(), true);
+    const size_t N = (size_t)W_*H_;
+    #pragma omp parallel for schedule(static)
+    for (size_t i=0; i<N; ++i) out[i] = buf_[i].real();
+}
@@ -0,0 +1,52 @@
+#pragma once // para que se compile solo una vez
+
+#include <algorithm>
+#include <complex>
+#include <vector>
+
+#include "Fft.h"
+#include "SimdKernels.h"
+
+// Propagacion espectral (--spectral) de una grilla periodica sin fuente. El
+// paso a' = a + dt (D L a - g a), con L el laplaciano de 3/5 puntos periodico,
+// es lineal y diagonal en la base de Fourier: el modo (kx, ky) se multiplica
+// cada paso por
+//   G_k = 1 - dt (D (4 sin^2(pi kx/W) + 4 sin^2(pi ky/H)) + g)
+// asi que el estado tras n pasos es IFFT(G_k^n FFT(a0)), en O(N log N) para
+// cualquier n, y la energia sale de Parseval, sum a^2 = (1/N) sum |G_k^n A_k|^2,
+// sin transformar de vuelta. G_k solo depende de min(k, W-k) y min(ky, H-ky):
+// la energia se suma sobre esos ~N/4 modos plegados.
+class SpectralSolver {
+public:
+    using cd = std::complex<double>;
+
+    // grilla periodica W x H (1D: H = 1)
+    SpectralSolver(int W, int H, const StepCoeffs& c);
+
+    // FFT del estado de partida (paso relativo 0)
+    void load(const double* a);
+    // energia tras first, first + stride, ... pasos (count valores en out)
+    void energies(long first, long stride, long count, double* out);
+    // estado tras n pasos
+    void state(long n, double* out);
+
+    // max |G_k|: > 1 significa que el esquema explicito diverge
+    double maxGrowth() const { return max_growth_; }
+
+private:
+    int W_, H_;
+    Fft fx_, fy_;
+    int PW_, PH_;                  // modos plegados por eje (W/2+1, H/2+1)
+    std::vector<cd> hat_;          // espectro H x W del estado de partida
+    std::vector<cd> buf_;
+    std::vector<double> fold_g_;   // G por modo plegado
+    std::vector<double> fold_w_;   // (1/N) sum |A_k|^2 de los modos de cada pliegue
+    std::vector<double> term_, ratio_;
+    double max_growth_ = 0.0;
+
+    int fold(int kx, int ky) const {
+        return std::min(ky, H_ - ky)*PW_ + std::min(kx, W_ - kx);
+    }
+    // FFT 2D en el lugar (filas y luego columnas, en paralelo)
+    void transform(cd* a, bool inv) const;
+};
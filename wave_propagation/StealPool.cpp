@@ -0,0 +1,175 @@
+#include "StealPool.h"
+
+#include <algorithm>
+#include "Numa.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+static inline void cpu_relax(){ _mm_pause(); }
+#else
+static inline void cpu_relax(){}
+#endif
+
+// con mas trabajadores que CPUs girar le quita el procesador al que tiene
+// trabajo: se cede el turno en vez de esperar activamente
+void StealPool::relax() const{
+    if (oversub_) std::this_thread::yield();
+    else cpu_relax();
+}
+
+// ============================ ChaseLevDeque ============================
+
+void ChaseLevDeque::reserve(int capacity){
+    long cap = 1;
+    while (cap < capacity) cap <<= 1;
+    if (cap <= mask_) return;
+    // solo entre trabajos (deque vacio y sin ladrones)
+    buf_.reset(new std::atomic<int>[cap]);
+    mask_ = cap - 1;
+}
+
+void ChaseLevDeque::push(int v){
+    const long b = bottom_.load(std::memory_order_relaxed);
+    buf_[b & mask_].store(v, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+}
+
+bool ChaseLevDeque::pop(int& v){
+    const long b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long t = top_.load(std::memory_order_relaxed);
+    if (t > b){
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+    v = buf_[b & mask_].load(std::memory_order_relaxed);
+    if (t == b){
+        // ultimo elemento: se disputa con los ladrones
+        const bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+bool ChaseLevDeque::steal(int& v){
+    long t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const long b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) return false;
+    v = buf_[t & mask_].load(std::memory_order_relaxed);
+    return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+// ============================ StealPool ============================
+
+StealPool& StealPool::shared(int threads, PinMode pin, int spin){
+    static std::unique_ptr<StealPool> pool;
+    threads = std::max(1, threads);
+    if (!pool || pool->size() != threads || pool->pin_ != pin || pool->spin_ != spin){
+        pool.reset();
+        pool = std::make_unique<StealPool>(threads, pin, spin);
+    }
+    return *pool;
+}
+
+StealPool::StealPool(int threads, PinMode pin, int spin) : pin_(pin), spin_(spin) {
+    threads = std::max(1, threads);
+    for (int w=0; w<threads; ++w) deques_.push_back(std::make_unique<Slot>());
+    // misma CPU que el hilo OpenMP del mismo numero (pin_threads)
+    cpus_ = cpu_order(pin);
+    oversub_ = threads > allowed_cpu_count();
+    threads_.reserve(threads - 1);
+    for (int w=1; w<threads; ++w) threads_.emplace_back([this, w]{ loop(w); });
+}
+
+StealPool::~StealPool(){
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        stop_.store(true);
+    }
+    cv_.notify_all();
+    for (std::thread& t : threads_) t.join();
+}
+
+void StealPool::launch(int ntiles){
+    ++jobs_;
+    if (ntiles > capacity_){
+        // ningun trabajador esta dentro de un trabajo: se pueden agrandar los deques
+        capacity_ = ntiles;
+        for (auto& s : deques_) s->q.reserve(capacity_);
+    }
+    // reparto inicial: rango contiguo por trabajador, empujado al reves (pop()
+    // lo recorre en orden creciente y los ladrones se llevan el extremo alto).
+    // Lo llena el que lanza, con todos los trabajadores fuera de los deques: los
+    // tiles de un trabajador que tarda en despertar ya se pueden robar
+    const int P = size();
+    for (int w=0; w<P; ++w){
+        ChaseLevDeque& q = deques_[w]->q;
+        const int k0 = (int)((long)ntiles * w / P), k1 = (int)((long)ntiles * (w + 1) / P);
+        for (int k=k1-1; k>=k0; --k) q.push(k);
+    }
+    remaining_.store(ntiles, std::memory_order_relaxed);
+    finished_.store(0, std::memory_order_relaxed);
+    epoch_.fetch_add(1, std::memory_order_seq_cst);   // publica fn_, ctx_ y los deques
+    if (sleepers_.load(std::memory_order_seq_cst) > 0){
+        std::lock_guard<std::mutex> lk(m_);
+        cv_.notify_all();
+    }
+    work(0);
+    // los demas terminan de mirar los deques antes del trabajo siguiente
+    const int others = size() - 1;
+    while (finished_.load(std::memory_order_acquire) < others) relax();
+}
+
+void StealPool::work(int w){
+    const int P = size();
+    ChaseLevDeque& mine = deques_[w]->q;
+    int k;
+    while (mine.pop(k)){
+        fn_(ctx_, k, w);
+        remaining_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    // robo: recorre a los demas desde el vecino hasta que no queden tiles
+    long stolen = 0;
+    while (remaining_.load(std::memory_order_acquire) > 0){
+        bool got = false;
+        for (int d=1; d<P && !got; ++d){
+            if (deques_[(w + d) % P]->q.steal(k)){
+                got = true;
+                ++stolen;
+                fn_(ctx_, k, w);
+                remaining_.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        }
+        if (!got) relax();
+    }
+    if (stolen) steals_.fetch_add(stolen, std::memory_order_relaxed);
+}
+
+void StealPool::loop(int w){
+    if (!cpus_.empty()) pin_current_thread(cpus_[w % cpus_.size()]);
+    long seen = 0;
+    while (true){
+        // gira un rato esperando el trabajo siguiente y despues duerme
+        long e = epoch_.load(std::memory_order_acquire);
+        const int spin = oversub_ ? 0 : spin_;
+        for (int s=0; s<spin && e == seen && !stop_.load(std::memory_order_relaxed); ++s){
+            cpu_relax();
+            e = epoch_.load(std::memory_order_acquire);
+        }
+        if (e == seen){
+            std::unique_lock<std::mutex> lk(m_);
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            cv_.wait(lk, [&]{ return epoch_.load(std::memory_order_seq_cst) != seen || stop_.load(); });
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            e = epoch_.load(std::memory_order_acquire);
+        }
+        if (stop_.load()) return;
+        seen = e;
+        work(w);
+        finished_.fetch_add(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once // para que se compile solo una vez
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Types.h"
+
+// Deque de Chase-Lev (version de Le et al. para memoria debil) de indices de
+// tile: el dueno empuja y saca por abajo sin bloqueo; los demas roban por
+// arriba con un CAS. Capacidad fija (potencia de 2 >= tiles por trabajo).
+class ChaseLevDeque {
+public:
+    void reserve(int capacity);
+    void push(int v);          // solo el dueno (o quien llena el deque entre trabajos)
+    bool pop(int& v);          // solo el dueno (LIFO)
+    bool steal(int& v);        // cualquier hilo (FIFO)
+
+private:
+    alignas(64) std::atomic<long> top_{0};
+    alignas(64) std::atomic<long> bottom_{0};
+    std::unique_ptr<std::atomic<int>[]> buf_;
+    long mask_ = 0;
+};
+
+// Backend --backend pool: hilos persistentes (el que llama es el trabajador 0)
+// fijados con --pin, que se reparten los tiles de cada paso sin volver a
+// entrar en una region OpenMP. Cada trabajador empieza por su rango contiguo
+// de tiles (como schedule static) y, al vaciar su deque, roba a los demas.
+// Entre pasos los trabajadores giran `spin` iteraciones mirando el contador
+// de trabajos y despues duermen en una variable de condicion (con mas
+// trabajadores que CPUs no giran: duermen enseguida y ceden el turno).
+class StealPool {
+public:
+    StealPool(int threads, PinMode pin, int spin = 20000);
+    ~StealPool();
+    StealPool(const StealPool&) = delete;
+    StealPool& operator=(const StealPool&) = delete;
+
+    // pool del proceso: se crea en la primera llamada y se recrea solo si
+    // cambian los hilos, --pin o el giro (las corridas siguientes, p.ej. del
+    // benchmark, no vuelven a lanzar hilos)
+    static StealPool& shared(int threads, PinMode pin, int spin);
+
+    int size() const { return (int)deques_.size(); }
+
+    // f(tile, trabajador) para cada tile de [0, ntiles); vuelve cuando todos
+    // los trabajadores terminaron
+    template <class F>
+    void run(int ntiles, F& f){
+        fn_ = [](void* ctx, int k, int w){ (*static_cast<F*>(ctx))(k, w); };
+        ctx_ = &f;
+        launch(ntiles);
+    }
+
+    long steals() const { return steals_.load(std::memory_order_relaxed); }
+    long jobs() const { return jobs_; }
+
+private:
+    struct alignas(64) Slot { ChaseLevDeque q; };
+    std::vector<std::unique_ptr<Slot>> deques_;
+    std::vector<std::thread> threads_;
+    std::vector<int> cpus_;
+    PinMode pin_;
+    int spin_;
+    bool oversub_ = false;   // mas trabajadores que CPUs permitidas: sin giro
+
+    void (*fn_)(void*, int, int) = nullptr;
+    void* ctx_ = nullptr;
+    int capacity_ = 0;
+    long jobs_ = 0;
+    alignas(64) std::atomic<long> epoch_{0};
+    alignas(64) std::atomic<int> remaining_{0};   // tiles sin terminar
+    alignas(64) std::atomic<int> finished_{0};    // trabajadores que salieron del trabajo
+    std::atomic<long> steals_{0};
+    std::atomic<int> sleepers_{0};
+    std::atomic<bool> stop_{false};
+    std::mutex m_;
+    std::condition_variable cv_;
+
+    void relax() const;
+    void launch(int ntiles);
+    void work(int w);
+    void loop(int w);
+};
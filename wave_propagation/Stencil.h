@@ -0,0 +1,217 @@
+#pragma once // para que se compile solo una vez
+
+#include <algorithm>
+#include <cstddef>
+#include "SimdKernels.h"
+#include "Types.h"
+
+template <class Acc>
+inline Acc stencil_update(Acc ai, Acc acc, Acc s, const StepCoeffs& c){
+    return ai + (Acc)c.dt*((Acc)c.D*acc - (Acc)c.g*ai + s);
+}
+
+// Kernels SIMD de cada variante de precision: Real = almacenamiento de las
+// amplitudes, Acc = aritmetica del laplaciano y de la energia
+//   double/double (f64), float/float (f32), float/double (mixto)
+template <class Real, class Acc> struct SimdOps;
+
+template <> struct SimdOps<double, double> {
+    static double update3(const SimdKernels& K, const double* u, double* out, int i0, int i1,
+                          const StepCoeffs& c, const SpanSource& s, bool e){
+        return K.update3(u, out, i0, i1, c, s, e);
+    }
+    static double update5(const SimdKernels& K, const double* up, const double* mid, const double* dn, double* out,
+                          int i0, int i1, const StepCoeffs& c, const SpanSource& s, bool e){
+        return K.update5(up, mid, dn, out, i0, i1, c, s, e);
+    }
+    static double sumsq(const SimdKernels& K, const double* v, int n){ return K.sumsq(v, n); }
+};
+
+template <> struct SimdOps<float, float> {
+    static double update3(const SimdKernels& K, const float* u, float* out, int i0, int i1,
+                          const StepCoeffs& c, const SpanSource& s, bool e){
+        return K.update3_f32(u, out, i0, i1, c, s, e);
+    }
+    static double update5(const SimdKernels& K, const float* up, const float* mid, const float* dn, float* out,
+                          int i0, int i1, const StepCoeffs& c, const SpanSource& s, bool e){
+        return K.update5_f32(up, mid, dn, out, i0, i1, c, s, e);
+    }
+    static double sumsq(const SimdKernels& K, const float* v, int n){ return K.sumsq_f32(v, n); }
+};
+
+template <> struct SimdOps<float, double> {
+    static double update3(const SimdKernels& K, const float* u, float* out, int i0, int i1,
+                          const StepCoeffs& c, const SpanSource& s, bool e){
+        return K.update3_mixed(u, out, i0, i1, c, s, e);
+    }
+    static double update5(const SimdKernels& K, const float* up, const float* mid, const float* dn, float* out,
+                          int i0, int i1, const StepCoeffs& c, const SpanSource& s, bool e){
+        return K.update5_mixed(up, mid, dn, out, i0, i1, c, s, e);
+    }
+    static double sumsq(const SimdKernels& K, const float* v, int n){ return K.sumsq_mixed(v, n); }
+};
+
+// Termino fuente de un paso, resuelto fuera del bucle interno:
+//  - por nodo: s_i = scale*values[i]
+//  - uniforme: s_i = uniform
+//  - puntual (modo single): s_i = single_val en single_idx y uniform en el resto
+struct SourceTerm {
+    const double* values = nullptr;
+    double scale = 0.0;
+    double uniform = 0.0;
+    int single_idx = -1;
+    double single_val = 0.0;
+
+    double at(int i) const {
+        if (values) return scale*values[i];
+        return (i == single_idx) ? single_val : uniform;
+    }
+    // vista para un tramo cuyo indice 0 corresponde al nodo global `base`
+    SpanSource span(int base) const {
+        return SpanSource{values ? values + base : nullptr, scale, uniform};
+    }
+};
+
+// Tramo interior [i0,i1) (indices globales) por el kernel SIMD despachado.
+// El nodo con fuente puntual se pela y se actualiza con point(i).
+template <class Kern, class Point>
+inline double stencil_span(const SourceTerm& src, int i0, int i1, Kern&& kern, Point&& point){
+    const int k = src.single_idx;
+    if (src.values || k < i0 || k >= i1) return kern(i0, i1);
+    double e = kern(i0, k);
+    const auto v = point(k);
+    e += v*v;
+    return e + kern(k+1, i1);
+}
+
+// Kernels sin matriz para grillas regulares. El laplaciano se obtiene por
+// aritmetica de indices (sin CSR) y se especializa en tiempo de compilacion
+// segun dimension y tipo de borde. Los vecinos se suman en el mismo orden que
+// el CSR (izq, der, arriba, abajo), asi ambos caminos dan resultados identicos.
+// Bordes (nodos extremos en 1D, filas/columnas extremas en 2D) se pelan: el
+// tramo interior no tiene ramas y lo recorre el kernel SIMD (SimdKernels.h).
+// Real/Acc eligen la variante de precision (ver SimdOps); los nodos pelados
+// devuelven el valor guardado convertido a Acc.
+template <int Dim, Boundary B, class Real = double, class Acc = double>
+struct Stencil;
+
+template <Boundary B, class Real, class Acc>
+struct Stencil<1, B, Real, Acc> {
+    static constexpr bool periodic = (B == Boundary::Periodic);
+
+    // nodo extremo (i=0 o i=N-1), con ramas
+    static inline Acc edge(const Real* u, Real* out, int N, int i, const StepCoeffs& c,
+                           const SourceTerm& src){
+        const Acc ai = u[i];
+        Acc acc = 0;
+        if (i-1>=0) acc += ((Acc)u[i-1] - ai);
+        else if (periodic) acc += ((Acc)u[N-1] - ai);
+        if (i+1<N) acc += ((Acc)u[i+1] - ai);
+        else if (periodic) acc += ((Acc)u[0] - ai);
+        return out[i] = (Real)stencil_update<Acc>(ai, acc, (Acc)src.at(i), c);
+    }
+
+    // nodo interior 0<i<N-1: 3 puntos sin ramas
+    static inline Acc interior(const Real* u, Real* out, int i, const StepCoeffs& c,
+                               const SourceTerm& src){
+        const Acc ai = u[i];
+        Acc acc = 0;
+        acc += ((Acc)u[i-1] - ai);
+        acc += ((Acc)u[i+1] - ai);
+        return out[i] = (Real)stencil_update<Acc>(ai, acc, (Acc)src.at(i), c);
+    }
+
+    // tramo interior [i0,i1) con 1<=i0, i1<=N-1. Con Energy=true devuelve sum(a^2).
+    template <bool Energy>
+    static inline double range(const Real* u, Real* out, int i0, int i1,
+                               const StepCoeffs& c, const SourceTerm& src){
+        const SimdKernels& K = simd_kernels();
+        const SpanSource ss = src.span(0);
+        return stencil_span(src, i0, i1,
+            [&](int a, int b){ return SimdOps<Real, Acc>::update3(K, u, out, a, b, c, ss, Energy); },
+            [&](int i){ return interior(u, out, i, c, src); });
+    }
+};
+
+template <Boundary B, class Real, class Acc>
+struct Stencil<2, B, Real, Acc> {
+    static constexpr bool periodic = (B == Boundary::Periodic);
+
+    // nodo del perimetro de la grilla, con ramas
+    static inline Acc edge(const Real* u, Real* out, int Lx, int Ly, int x, int y,
+                           const StepCoeffs& c, const SourceTerm& src){
+        const int i = y*Lx + x;
+        const Acc ai = u[i];
+        Acc acc = 0;
+        // left
+        if (x>0) acc += ((Acc)u[i-1] - ai);
+        else if (periodic) acc += ((Acc)u[y*Lx + (Lx-1)] - ai);
+        // right
+        if (x+1<Lx) acc += ((Acc)u[i+1] - ai);
+        else if (periodic) acc += ((Acc)u[y*Lx] - ai);
+        // up
+        if (y>0) acc += ((Acc)u[i-Lx] - ai);
+        else if (periodic) acc += ((Acc)u[(Ly-1)*Lx + x] - ai);
+        // down
+        if (y+1<Ly) acc += ((Acc)u[i+Lx] - ai);
+        else if (periodic) acc += ((Acc)u[x] - ai);
+        return out[i] = (Real)stencil_update<Acc>(ai, acc, (Acc)src.at(i), c);
+    }
+
+    // nodo interior (0<x<Lx-1, 0<y<Ly-1): 5 puntos sin ramas
+    static inline Acc interior(const Real* u, Real* out, int Lx, int i,
+                               const StepCoeffs& c, const SourceTerm& src){
+        const Acc ai = u[i];
+        Acc acc = 0;
+        acc += ((Acc)u[i-1]  - ai);
+        acc += ((Acc)u[i+1]  - ai);
+        acc += ((Acc)u[i-Lx] - ai);
+        acc += ((Acc)u[i+Lx] - ai);
+        return out[i] = (Real)stencil_update<Acc>(ai, acc, (Acc)src.at(i), c);
+    }
+
+    // fila completa y: las filas extremas van por edge(), las interiores pelan x=0 y x=Lx-1.
+    // Con Energy=true devuelve la suma de a^2 de la fila (paso fusionado).
+    template <bool Energy>
+    static inline double row(const Real* u, Real* out, int Lx, int Ly, int y,
+                             const StepCoeffs& c, const SourceTerm& src){
+        return row_span<Energy>(u, out, Lx, Ly, y, 0, Lx, c, src);
+    }
+
+    // tramo [x0,x1) de la fila y (region activa, ActiveRegion.h). Los nodos
+    // fuera del tramo aportan a^2 = 0, asi que con x0 = 1 + 16k la energia es la
+    // misma que la de la fila completa
+    template <bool Energy>
+    static inline double row_span(const Real* u, Real* out, int Lx, int Ly, int y, int x0, int x1,
+                                  const StepCoeffs& c, const SourceTerm& src){
+        double e = 0.0;
+        if (y==0 || y==Ly-1 || Lx<3){
+            for (int x=x0; x<x1; ++x){
+                const Acc v = edge(u, out, Lx, Ly, x, y, c, src);
+                if constexpr (Energy) e += v*v;
+            }
+            return e;
+        }
+        const int base = y*Lx;
+        if (x0 == 0){
+            const Acc v0 = edge(u, out, Lx, Ly, 0, y, c, src);
+            if constexpr (Energy) e += v0*v0;
+        }
+        const int a = std::max(x0, 1), b = std::min(x1, Lx-1);
+        if (a < b){
+            const SimdKernels& K = simd_kernels();
+            const Real* mid = u + base;
+            Real* orow = out + base;
+            const SpanSource ss = src.span(base);
+            const double es = stencil_span(src, base+a, base+b,
+                [&](int i0, int i1){ return SimdOps<Real, Acc>::update5(K, mid - Lx, mid, mid + Lx, orow, i0 - base, i1 - base, c, ss, Energy); },
+                [&](int i){ return interior(u, out, Lx, i, c, src); });
+            if constexpr (Energy) e += es;
+        }
+        if (x1 == Lx){
+            const Acc v1 = edge(u, out, Lx, Ly, Lx-1, y, c, src);
+            if constexpr (Energy) e += v1*v1;
+        }
+        return e;
+    }
+};
@@ -0,0 +1,352 @@
+#pragma once // para que se compile solo una vez
+
+#include <algorithm>
+#include <omp.h>
+
+#include "Stencil.h"
+#include "Types.h"
+
+// Barridos de un paso completo (stencil y CSR), compartidos por
+// WavePropagator y el microbenchmark de kernels (Benchmark::run_kernels).
+// Ningun barrido termina con barrera: el que llama pone la barrera antes de
+// leer `out` (asi cada hilo puede marcar cuando termino su parte).
+
+// Relleno por hilo para las sumas parciales de energia (una linea de cache)
+constexpr int kPad = 8;
+
+// row_hook(i0, i1): lo llama el hilo que acaba de escribir los nodos [i0,i1)
+// de `out` (una fila en 2D, un bloque o un extremo en 1D), con la fila todavia
+// en cache. Sin hook no cuesta nada.
+struct NoRowHook {
+    void operator()(int, int) const {}
+};
+
+// Variantes del barrido stencil que llaman al row_hook: collapse2 y taskloop
+// reparten nodos sueltos y no lo llaman
+inline bool sweep_has_row_hook(bool is2D, const RunParams& p, int Lx, int Ly){
+    return !p.taskloop && !(is2D && p.collapse2 && Lx >= 3 && Ly >= 3);
+}
+
+// Barrido stencil de un paso completo. Se llama desde dentro de la region
+// paralela (worksharing huerfano) y respeta las mismas variantes de
+// planificacion que el camino CSR: filas en 2D, (y,x) con collapse2, indices en
+// 1D o taskloop. Los bordes se actualizan aparte para que el bucle interior no
+// tenga ramas. Con Energy=true acumula sum(a^2) en el mismo barrido y devuelve
+// la suma parcial de este hilo. Real/Acc: variante de precision.
+template <int Dim, Boundary B, class Real, class Acc, bool Energy, class RowHook = NoRowHook>
+double stencil_sweep(const Real* u, Real* out, int Lx, int Ly, const StepCoeffs& c,
+                     const RunParams& p, int chunk, int grain, const SourceTerm& src,
+                     const RowHook& row_hook = RowHook())
+{
+    using K = Stencil<Dim, B, Real, Acc>;
+    double e = 0.0;
+    if constexpr (Dim == 1){
+        const int N = Lx;
+        #pragma omp single nowait
+        {
+            const Acc v0 = K::edge(u, out, N, 0, c, src);
+            if constexpr (Energy) e += v0*v0;
+            row_hook(0, 1);
+            if (N > 1){
+                const Acc v1 = K::edge(u, out, N, N-1, c, src);
+                if constexpr (Energy) e += v1*v1;
+                row_hook(N-1, N);
+            }
+        }
+        // el interior se reparte en bloques de `chunk` nodos (misma distribucion
+        // que schedule(kind, chunk) por nodo) y cada bloque es un tramo contiguo
+        const int n_in = std::max(0, N-2);
+        if (p.taskloop){
+            const int nblk = (n_in + grain - 1) / grain;
+            #pragma omp single nowait
+            {
+                double et = 0.0;
+                #pragma omp taskloop grainsize(1) reduction(+:et)
+                for (int b=0; b<nblk; ++b){
+                    const int i0 = 1 + b*grain;
+                    et += K::template range<Energy>(u, out, i0, std::min(i0 + grain, N-1), c, src);
+                }
+                e += et;
+            }
+        } else {
+            const int nblk = (n_in + chunk - 1) / chunk;
+            auto block = [&](int b){
+                const int i0 = 1 + b*chunk, i1 = std::min(i0 + chunk, N-1);
+                const double eb = K::template range<Energy>(u, out, i0, i1, c, src);
+                row_hook(i0, i1);
+                return eb;
+            };
+            if (p.schedule == ScheduleType::Static){
+                #pragma omp for schedule(static, 1) nowait
+                for (int b=0; b<nblk; ++b) e += block(b);
+            } else if (p.schedule == ScheduleType::Dynamic){
+                #pragma omp for schedule(dynamic, 1) nowait
+                for (int b=0; b<nblk; ++b) e += block(b);
+            } else {
+                #pragma omp for schedule(guided, 1) nowait
+                for (int b=0; b<nblk; ++b) e += block(b);
+            }
+        }
+    } else {
+        if (p.taskloop){
+            #pragma omp single nowait
+            {
+                double et = 0.0;
+                #pragma omp taskloop grainsize(grain) reduction(+:et)
+                for (int y=0; y<Ly; ++y){
+                    et += K::template row<Energy>(u, out, Lx, Ly, y, c, src);
+                }
+                e += et;
+            }
+        } else if (p.collapse2 && Lx >= 3 && Ly >= 3){
+            // perimetro (2*Lx + 2*(Ly-2) nodos) y luego el interior colapsado
+            const int nper = 2*Lx + 2*(Ly-2);
+            #pragma omp for nowait
+            for (int k=0; k<nper; ++k){
+                int x, y;
+                if (k < Lx)              { x = k;           y = 0;    }
+                else if (k < 2*Lx)       { x = k - Lx;      y = Ly-1; }
+                else if (k < 2*Lx+Ly-2)  { x = 0;           y = k - 2*Lx + 1; }
+                else                     { x = Lx-1;        y = k - (2*Lx+Ly-2) + 1; }
+                const Acc v = K::edge(u, out, Lx, Ly, x, y, c, src);
+                if constexpr (Energy) e += v*v;
+            }
+            if (p.schedule == ScheduleType::Static){
+                #pragma omp for schedule(static, chunk) collapse(2) nowait
+                for (int y=1; y<Ly-1; ++y){
+                    for (int x=1; x<Lx-1; ++x){
+                        const Acc v = K::interior(u, out, Lx, y*Lx + x, c, src);
+                        if constexpr (Energy) e += v*v;
+                    }
+                }
+            } else if (p.schedule == ScheduleType::Dynamic){
+                #pragma omp for schedule(dynamic, chunk) collapse(2) nowait
+                for (int y=1; y<Ly-1; ++y){
+                    for (int x=1; x<Lx-1; ++x){
+                        const Acc v = K::interior(u, out, Lx, y*Lx + x, c, src);
+                        if constexpr (Energy) e += v*v;
+                    }
+                }
+            } else {
+                #pragma omp for schedule(guided, chunk) collapse(2) nowait
+                for (int y=1; y<Ly-1; ++y){
+                    for (int x=1; x<Lx-1; ++x){
+                        const Acc v = K::interior(u, out, Lx, y*Lx + x, c, src);
+                        if constexpr (Energy) e += v*v;
+                    }
+                }
+            }
+        } else if (p.schedule == ScheduleType::Static){
+            #pragma omp for schedule(static, chunk) nowait
+            for (int y=0; y<Ly; ++y){
+                e += K::template row<Energy>(u, out, Lx, Ly, y, c, src);
+                row_hook(y*Lx, (y+1)*Lx);
+            }
+        } else if (p.schedule == ScheduleType::Dynamic){
+            #pragma omp for schedule(dynamic, chunk) nowait
+            for (int y=0; y<Ly; ++y){
+                e += K::template row<Energy>(u, out, Lx, Ly, y, c, src);
+                row_hook(y*Lx, (y+1)*Lx);
+            }
+        } else {
+            #pragma omp for schedule(guided, chunk) nowait
+            for (int y=0; y<Ly; ++y){
+                e += K::template row<Energy>(u, out, Lx, Ly, y, c, src);
+                row_hook(y*Lx, (y+1)*Lx);
+            }
+        }
+    }
+    return e;
+}
+
+// Selecciona la especializacion del stencil segun dimension y borde
+template <class Real, class Acc, bool Energy, class RowHook = NoRowHook>
+double stencil_dispatch(bool is2D, Boundary b, const Real* u, Real* out, int Lx, int Ly,
+                        const StepCoeffs& c, const RunParams& p, int chunk, int grain, const SourceTerm& src,
+                        const RowHook& row_hook = RowHook())
+{
+    if (is2D){
+        if (b == Boundary::Periodic)
+            return stencil_sweep<2, Boundary::Periodic, Real, Acc, Energy>(u, out, Lx, Ly, c, p, chunk, grain, src, row_hook);
+        return stencil_sweep<2, Boundary::Open, Real, Acc, Energy>(u, out, Lx, Ly, c, p, chunk, grain, src, row_hook);
+    }
+    if (b == Boundary::Periodic)
+        return stencil_sweep<1, Boundary::Periodic, Real, Acc, Energy>(u, out, Lx, 1, c, p, chunk, grain, src, row_hook);
+    return stencil_sweep<1, Boundary::Open, Real, Acc, Energy>(u, out, Lx, 1, c, p, chunk, grain, src, row_hook);
+}
+
+// Tiles del backend --backend pool (StealPool.h): bloques de `chunk` filas en
+// 2D o de `chunk` nodos del interior en 1D; el tile 0 tambien hace los dos
+// extremos. Cada tile devuelve su energia y el que llama las suma en orden de
+// tile, asi el resultado no depende de quien robo que tile.
+inline int stencil_tile_count(bool is2D, int Lx, int Ly, int chunk){
+    const int rows = is2D ? Ly : std::max(0, Lx - 2);
+    return std::max(1, (rows + chunk - 1) / chunk);
+}
+
+template <int Dim, Boundary B, class Real, class Acc, bool Energy, class RowHook>
+double stencil_tile_impl(const Real* u, Real* out, int Lx, int Ly, const StepCoeffs& c,
+                         const SourceTerm& src, int chunk, int k, const RowHook& row_hook)
+{
+    using K = Stencil<Dim, B, Real, Acc>;
+    double e = 0.0;
+    if constexpr (Dim == 2){
+        const int y1 = std::min(Ly, (k + 1)*chunk);
+        for (int y=k*chunk; y<y1; ++y){
+            e += K::template row<Energy>(u, out, Lx, Ly, y, c, src);
+            row_hook(y*Lx, (y+1)*Lx);
+        }
+    } else {
+        const int N = Lx;
+        if (k == 0){
+            const Acc v0 = K::edge(u, out, N, 0, c, src);
+            if constexpr (Energy) e += v0*v0;
+            row_hook(0, 1);
+            if (N > 1){
+                const Acc v1 = K::edge(u, out, N, N-1, c, src);
+                if constexpr (Energy) e += v1*v1;
+                row_hook(N-1, N);
+            }
+        }
+        const int i0 = 1 + k*chunk, i1 = std::min(i0 + chunk, N-1);
+        if (i0 < i1){
+            e += K::template range<Energy>(u, out, i0, i1, c, src);
+            row_hook(i0, i1);
+        }
+    }
+    return e;
+}
+
+template <class Real, class Acc, bool Energy, class RowHook = NoRowHook>
+double stencil_tile(bool is2D, Boundary b, const Real* u, Real* out, int Lx, int Ly, const StepCoeffs& c,
+                    const SourceTerm& src, int chunk, int k, const RowHook& row_hook = RowHook())
+{
+    if (is2D){
+        if (b == Boundary::Periodic)
+            return stencil_tile_impl<2, Boundary::Periodic, Real, Acc, Energy>(u, out, Lx, Ly, c, src, chunk, k, row_hook);
+        return stencil_tile_impl<2, Boundary::Open, Real, Acc, Energy>(u, out, Lx, Ly, c, src, chunk, k, row_hook);
+    }
+    if (b == Boundary::Periodic)
+        return stencil_tile_impl<1, Boundary::Periodic, Real, Acc, Energy>(u, out, Lx, 1, c, src, chunk, k, row_hook);
+    return stencil_tile_impl<1, Boundary::Open, Real, Acc, Energy>(u, out, Lx, 1, c, src, chunk, k, row_hook);
+}
+
+// Barrido sobre la lista de vecinos CSR (camino de respaldo y --network
+// graph). update(idx) escribe el nodo y devuelve su nuevo valor. Con parts
+// (--partition) la unidad de reparto es el tramo [parts[q], parts[q+1]),
+// con el --schedule pedido y de a un tramo.
+template <bool Energy, class Update>
+double csr_sweep(int N, int Lx, int Ly, bool is2D, const RunParams& p, int chunk, int grain,
+                 Update&& update_index, const int* parts = nullptr, int nparts = 0)
+{
+    double e = 0.0;
+    auto visit = [&](int idx){
+        const auto v = update_index(idx);
+        if constexpr (Energy) e += v*v;
+    };
+    if (nparts > 0){
+        if (p.schedule == ScheduleType::Static){
+            #pragma omp for schedule(static) nowait
+            for (int q=0; q<nparts; ++q){
+                for (int i=parts[q]; i<parts[q+1]; ++i) visit(i);
+            }
+        } else if (p.schedule == ScheduleType::Dynamic){
+            #pragma omp for schedule(dynamic, 1) nowait
+            for (int q=0; q<nparts; ++q){
+                for (int i=parts[q]; i<parts[q+1]; ++i) visit(i);
+            }
+        } else {
+            #pragma omp for schedule(guided, 1) nowait
+            for (int q=0; q<nparts; ++q){
+                for (int i=parts[q]; i<parts[q+1]; ++i) visit(i);
+            }
+        }
+    } else if (p.taskloop){
+        #pragma omp single nowait
+        {
+            double et = 0.0;
+            if (is2D){
+                #pragma omp taskloop grainsize(grain) reduction(+:et)
+                for (int y=0; y<Ly; ++y){
+                    for (int x=0; x<Lx; ++x){
+                        const auto v = update_index(y*Lx + x);
+                        if constexpr (Energy) et += v*v;
+                    }
+                }
+            } else {
+                #pragma omp taskloop grainsize(grain) reduction(+:et)
+                for (int i=0; i<N; ++i){
+                    const auto v = update_index(i);
+                    if constexpr (Energy) et += v*v;
+                }
+            }
+            e += et;
+        }
+    } else if (is2D){
+        if (p.collapse2){
+            if (p.schedule == ScheduleType::Static){
+                #pragma omp for schedule(static, chunk) collapse(2) nowait
+                for (int y=0; y<Ly; ++y){
+                    for (int x=0; x<Lx; ++x){
+                        visit(y*Lx + x);
+                    }
+                }
+            } else if (p.schedule == ScheduleType::Dynamic){
+                #pragma omp for schedule(dynamic, chunk) collapse(2) nowait
+                for (int y=0; y<Ly; ++y){
+                    for (int x=0; x<Lx; ++x){
+                        visit(y*Lx + x);
+                    }
+                }
+            } else {
+                #pragma omp for schedule(guided, chunk) collapse(2) nowait
+                for (int y=0; y<Ly; ++y){
+                    for (int x=0; x<Lx; ++x){
+                        visit(y*Lx + x);
+                    }
+                }
+            }
+        } else {
+            if (p.schedule == ScheduleType::Static){
+                #pragma omp for schedule(static, chunk) nowait
+                for (int y=0; y<Ly; ++y){
+                    for (int x=0; x<Lx; ++x){
+                        visit(y*Lx + x);
+                    }
+                }
+            } else if (p.schedule == ScheduleType::Dynamic){
+                #pragma omp for schedule(dynamic, chunk) nowait
+                for (int y=0; y<Ly; ++y){
+                    for (int x=0; x<Lx; ++x){
+                        visit(y*Lx + x);
+                    }
+                }
+            } else {
+                #pragma omp for schedule(guided, chunk) nowait
+                for (int y=0; y<Ly; ++y){
+                    for (int x=0; x<Lx; ++x){
+                        visit(y*Lx + x);
+                    }
+                }
+            }
+        }
+    } else {
+        if (p.schedule == ScheduleType::Static){
+            #pragma omp for schedule(static, chunk) nowait
+            for (int i=0; i<N; ++i){
+                visit(i);
+            }
+        } else if (p.schedule == ScheduleType::Dynamic){
+            #pragma omp for schedule(dynamic, chunk) nowait
+            for (int i=0; i<N; ++i){
+                visit(i);
+            }
+        } else {
+            #pragma omp for schedule(guided, chunk) nowait
+            for (int i=0; i<N; ++i){
+                visit(i);
+            }
+        }
+    }
+    return e;
+}
@@ -0,0 +1,167 @@
+#pragma once // para que se compile solo una vez
+
+#include <algorithm>
+#include <vector>
+
+#include "SourceEngine.h"
+#include "Stencil.h"
+#include "Types.h"
+
+// Bloqueo temporal para grillas 2D (tiles trapezoidales con halo solapado).
+//
+// Cada tile [x0,x1)x[y0,y1) se copia junto con un halo de `steps` celdas a un
+// buffer local del hilo y avanza `steps` pasos seguidos mientras sigue en
+// cache. En el sub-paso s solo se calcula la region interior expandida en
+// (steps - s) celdas, que es exactamente lo que el sub-paso siguiente necesita
+// leer: el trapezoide se encoge una celda por paso y el halo absorbe la
+// dependencia de los tiles vecinos (calculo redundante en lugar de
+// sincronizacion). Los vecinos se suman en el mismo orden que Stencil<2,B>,
+// asi el resultado es identico al barrido paso a paso.
+struct TileRange {
+    int x0, x1;   // columnas [x0, x1)
+    int y0, y1;   // filas    [y0, y1)
+};
+
+// Fuente de los sub-pasos de un bloque: terms[s] describe el sub-paso s
+// (uniforme o puntual). Si engine != nullptr la fuente es por nodo,
+// S0*sin(omega_i*t): el tile copia las fases del inicio del bloque y las rota
+// localmente con la misma recurrencia que SourceEngine (el bloque nunca cruza
+// una renormalizacion), asi los valores son identicos al barrido paso a paso.
+struct TileSource {
+    const SourceTerm* terms;
+    const SourceEngine* engine;
+    double S0;
+};
+
+// Real/Acc: variante de precision, como en Stencil<Dim,B,Real,Acc>.
+template <class Real = double, class Acc = double>
+class TileStepper {
+    std::vector<Real> a_, b_;     // buffers locales (doble buffer del tile + halo)
+    std::vector<double> ps_, pc_, pcw_, psw_;   // fases locales (fuente por nodo)
+
+    static int wrap(int v, int n){ v %= n; return v < 0 ? v + n : v; }
+
+    // celda generica (con ramas) para las celdas en el borde del dominio
+    static inline Acc cell(const Real* A, Real* Bf, int W, int li,
+                           bool hasL, bool hasR, bool hasU, bool hasD,
+                           double s, const StepCoeffs& c){
+        const Acc ai = A[li];
+        Acc acc = 0;
+        if (hasL) acc += ((Acc)A[li-1] - ai);
+        if (hasR) acc += ((Acc)A[li+1] - ai);
+        if (hasU) acc += ((Acc)A[li-W] - ai);
+        if (hasD) acc += ((Acc)A[li+W] - ai);
+        return Bf[li] = (Real)stencil_update<Acc>(ai, acc, (Acc)s, c);
+    }
+
+public:
+    // Avanza `steps` pasos el tile t leyendo u (estado confirmado) y escribe el
+    // interior del tile en out. energy[s] acumula sum(a^2) del interior en el
+    // sub-paso s.
+    template <Boundary B>
+    void advance(const Real* u, Real* out, int Lx, int Ly, const TileRange& t, int steps,
+                 const StepCoeffs& c, const TileSource& src, double* energy)
+    {
+        constexpr bool periodic = (B == Boundary::Periodic);
+        const SimdKernels& K = simd_kernels();
+        const int h = steps;
+        // extension del buffer en coordenadas globales (sin recortar si es periodico)
+        const int bx0 = periodic ? t.x0 - h : std::max(0,  t.x0 - h);
+        const int bx1 = periodic ? t.x1 + h : std::min(Lx, t.x1 + h);
+        const int by0 = periodic ? t.y0 - h : std::max(0,  t.y0 - h);
+        const int by1 = periodic ? t.y1 + h : std::min(Ly, t.y1 + h);
+        const int W = bx1 - bx0, H = by1 - by0;
+        const size_t need = (size_t)W * H;
+        if (a_.size() < need){ a_.resize(need); b_.resize(need); }
+        const bool per_node = src.engine != nullptr;
+        if (per_node && ps_.size() < need){
+            ps_.resize(need); pc_.resize(need); pcw_.resize(need); psw_.resize(need);
+        }
+        Real* A = a_.data();
+        Real* Bf = b_.data();
+
+        // copia tile + halo
+        for (int ly=0; ly<H; ++ly){
+            const int gy = periodic ? wrap(by0 + ly, Ly) : by0 + ly;
+            const Real* src_row = u + (size_t)gy*Lx;
+            Real* dst = A + (size_t)ly*W;
+            if (!periodic){
+                std::copy(src_row + bx0, src_row + bx1, dst);
+            } else {
+                for (int lx=0; lx<W; ++lx) dst[lx] = src_row[wrap(bx0 + lx, Lx)];
+            }
+            if (per_node){
+                const size_t o = (size_t)ly*W;
+                const size_t g = (size_t)gy*Lx;
+                for (int lx=0; lx<W; ++lx){
+                    const size_t gi = g + (periodic ? wrap(bx0 + lx, Lx) : bx0 + lx);
+                    ps_[o+lx]  = src.engine->values()[gi];
+                    pc_[o+lx]  = src.engine->cosines()[gi];
+                    pcw_[o+lx] = src.engine->cosStep()[gi];
+                    psw_[o+lx] = src.engine->sinStep()[gi];
+                }
+            }
+        }
+
+        const int single = per_node ? -1 : src.terms[0].single_idx;
+        const int single_y = single >= 0 ? single / Lx : -1;
+
+        for (int s=0; s<steps; ++s){
+            const int r = steps - 1 - s;   // halo que aun se necesita tras este sub-paso
+            const int cy0 = std::max(by0, t.y0 - r), cy1 = std::min(by1, t.y1 + r);
+            const int cx0 = std::max(bx0, t.x0 - r), cx1 = std::min(bx1, t.x1 + r);
+            // columnas del borde del dominio (solo con bordes abiertos)
+            const bool leftEdge  = !periodic && cx0 == 0;
+            const bool rightEdge = !periodic && cx1 == Lx;
+            double e = 0.0;
+            for (int gy=cy0; gy<cy1; ++gy){
+                const int ly = gy - by0;
+                const bool hasU = periodic || gy > 0;
+                const bool hasD = periodic || gy+1 < Ly;
+                const int gyw = periodic ? wrap(gy, Ly) : gy;
+                const int row = ly*W - bx0;    // indice local = row + gx
+                auto sval = [&](int gx){
+                    return per_node ? src.S0*ps_[row + gx]
+                                    : src.terms[s].at(gyw*Lx + (periodic ? wrap(gx, Lx) : gx));
+                };
+                int gx = cx0, gxe = cx1;
+                if (hasU && hasD && gyw != single_y){
+                    if (leftEdge && gx < gxe){
+                        cell(A, Bf, W, row + gx, false, gx+1 < Lx, true, true, sval(gx), c);
+                        ++gx;
+                    }
+                    if (rightEdge && gx < gxe){
+                        --gxe;
+                        cell(A, Bf, W, row + gxe, gxe > 0, false, true, true, sval(gxe), c);
+                    }
+                    if (gx < gxe){
+                        const SpanSource ss = per_node
+                            ? SpanSource{ps_.data() + (size_t)ly*W, src.S0, 0.0}
+                            : SpanSource{nullptr, 0.0, src.terms[s].uniform};
+                        const Real* mid = A + (size_t)ly*W;
+                        SimdOps<Real, Acc>::update5(K, mid - W, mid, mid + W, Bf + (size_t)ly*W, gx - bx0, gxe - bx0, c, ss, false);
+                    }
+                } else {
+                    for (int x=gx; x<gxe; ++x){
+                        const bool hasL = periodic || x > 0;
+                        const bool hasR = periodic || x+1 < Lx;
+                        cell(A, Bf, W, row + x, hasL, hasR, hasU, hasD, sval(x), c);
+                    }
+                }
+                // energia del interior del tile (fila recien escrita, caliente en cache)
+                if (gy >= t.y0 && gy < t.y1){
+                    e += SimdOps<Real, Acc>::sumsq(K, Bf + row + t.x0, t.x1 - t.x0);
+                }
+            }
+            energy[s] += e;
+            std::swap(A, Bf);
+            if (per_node && s+1 < steps) K.rotate(ps_.data(), pc_.data(), pcw_.data(), psw_.data(), (int)need, 1);
+        }
+
+        // escribe el interior del tile (A tiene el ultimo sub-paso)
+        for (int gy=t.y0; gy<t.y1; ++gy){
+            const Real* v = A + (size_t)(gy - by0)*W - bx0;
+            std::copy(v + t.x0, v + t.x1, out + (size_t)gy*Lx + t.x0);
+        }
+    }
+};
@@ -10,16 +10,32 @@ enum class ScheduleType {      //Enumeracion con Scope para evitar colisiones de
 
 enum class NoiseMode { Off = 0, Global, PerNode, Single };
 enum class EnergyAccum { Reduction = 0, Atomic, Critical };
+enum class Boundary { Open = 0, Periodic };
+enum class KernelType { Stencil = 0, Csr };   // stencil sin matriz o lista de vecinos CSR
+enum class FrameFormat { Binary = 0, Text, Compressed };   // frames.bin (FrameFile.h), un archivo de texto por frame o frames.wfz (FrameCodec.h)
+enum class FrameDtype { F64 = 0, F32 };
+enum class PinMode { None = 0, Compact, Spread };   // afinidad de los hilos OpenMP
+enum class Precision { F64 = 0, F32, Mixed };   // almacenamiento/aritmetica: double, float, float con acumulacion double
+enum class Reorder { None = 0, Rcm };   // orden de los nodos de un grafo cargado (Graph.h)
+enum class Backend { OpenMP = 0, Pool };   // ejecucion del paso: regiones OpenMP o StealPool.h
 
 struct RunParams {
+    bool help = false;          // --help/-h: el ejecutable imprime la ayuda y termina
     // parámetros de topología / simulación
-    std::string network = "2d"; // {1d,2d}
+    std::string network = "2d"; // {1d,2d,graph}
     int N = 10000;              // tamaño 1D
     int Lx = 100, Ly = 100;     // tamaño 2D
+    bool periodic = false;      // bordes periodicos
+    std::string graph;          // lista de aristas o Matrix Market (--network graph)
+    Reorder reorder = Reorder::None;
+    bool partition = false;     // tramos de nodos del tamano de la cache por hilo (Graph.h)
+    int part_kb = 256;          // presupuesto de cada tramo en KiB
+    bool graph_report = false;  // localidad antes/despues del reordenamiento
     double D = 0.1;             // difusión
     double gamma = 0.01;        // amortiguamiento
     double dt = 0.01;           // paso de tiempo
     int steps = 200;            // pasos a simular
+    bool steps_set = false;     // --steps explicito (al continuar reemplaza al del checkpoint)
 
     // fuente base
     double S0 = 0.0;
@@ -34,12 +50,31 @@ struct RunParams {
     // openmp / scheduling
     ScheduleType schedule = ScheduleType::Dynamic;
     int chunk = 32;
-    bool chunk_auto = false;
+    bool chunk_auto = false;       // autotuner (Autotune.h): schedule, chunk, variante e hilos
+    std::string tune_cache = "results/tuning_cache.tsv";   // configuraciones ganadoras por CPU y red
+    bool retune = false;           // ignora el cache y vuelve a medir
     int threads = 0; // 0 => usar configuracion por defecto de OMP
+    bool threads_set = false;      // --threads explicito (idem)
+    PinMode pin = PinMode::None;   // fija cada hilo a una CPU
+    bool numa_report = false;      // imprime CPU/nodo de los hilos y nodo de las paginas
+    bool perf_counters = false;    // contadores de hardware por fase e hilo (PerfCounters.h)
+    bool profile = false;          // computo/espera por fase e hilo y linea de tiempo (Profiler.h)
+    int profile_steps = 200;       // pasos que entran en la linea de tiempo
     bool fused = true;
     bool taskloop = false;
     int grain = 4096;
 
+    // bloqueo temporal 2D (1 = desactivado): pasos fusionados por tile y lado del tile
+    int tb_steps = 1;
+    int tile = 64;
+
+    // kernel de actualizacion (stencil solo aplica a grillas regulares)
+    KernelType kernel = KernelType::Stencil;
+    int src_resync = 256;          // pasos entre renormalizaciones de la fuente (1 = std::sin cada paso)
+    std::string simd = "auto";    // auto|scalar|sse2|avx2|avx512 (despacho en ejecucion)
+    Precision precision = Precision::F64;
+    bool accuracy_report = false;  // compara la traza de energia con una referencia double
+
     // acumulación de energía
     EnergyAccum energyAccum = EnergyAccum::Reduction;
 
@@ -47,6 +82,34 @@ struct RunParams {
     bool collapse2 = false;
     bool dump_frames = false;
     int frame_every = 10;
+    FrameFormat frame_format = FrameFormat::Binary;
+    FrameDtype frame_dtype = FrameDtype::F64;
+    double frame_tol = 0.0;     // compressed: cota del error absoluto (0 = sin perdida)
+    int frame_keyframe = 16;    // compressed: un frame independiente cada tantos (1 = sin delta temporal)
+    int frame_threads = 0;      // compressed: hilos que comprimen (0 = CPUs que no usa la simulacion)
+    bool async_io = true;       // energia y frames los escribe un hilo aparte
+    int io_buffers = 3;         // buffers de instantanea en vuelo (contrapresion)
+    int checkpoint_every = 0;   // pasos entre checkpoints (0 = sin checkpoint)
+    std::string checkpoint_path = "results/checkpoint.bin";
+    std::string resume;         // checkpoint desde el que continuar (vacio = inicio)
     bool do_bench = false;
+    bool do_microbench = false; // microbenchmark de kernels (Benchmark::run_kernels)
+    int bench_reps = 20;        // muestras por kernel
+    int bench_warmup = 3;       // corridas de calentamiento por kernel
+    bool bench_backends = false;   // compara OpenMP y el pool con robo de trabajo (Benchmark::run_backends)
     std::string energy_out = "results/energy_trace.dat";
+    std::string ensemble;       // archivo de barrido (Ensemble.h); vacio = una sola simulacion
+    std::string ensemble_out = "results/ensemble";   // trazas de energia de los miembros
+    std::string observe;        // observables en linea, p.ej. "energy:1,max:10,centroid" (Observables.h)
+    std::string probes;         // nodos sonda "x,y;x,y" (1D: "i;i")
+    bool active = false;        // solo actualiza la region que puede ser != 0 (ActiveRegion.h)
+    double active_tol = 0.0;    // > 0: ademas descarta (pone en cero) los nodos con |a| <= tol
+    Backend backend = Backend::OpenMP;
+    int pool_spin = 20000;      // giros de espera entre pasos antes de dormir (--backend pool)
+    bool spectral = false;      // salto espectral sin fuente en grillas periodicas (Spectral.h)
+    int spectral_every = 0;     // pasos entre lineas de energia con --spectral (0 = hasta 10000 lineas)
+    std::string stream;         // anillo en memoria compartida /dev/shm/<nombre> (FrameStream.h); vacio = sin transmision
+    int stream_every = 10;      // pasos entre frames transmitidos
+    int stream_slots = 8;       // frames que guarda el anillo
+    FrameDtype stream_dtype = FrameDtype::F32;
 };
@@ -0,0 +1,97 @@
+#include "WaveApi.h"
+
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "Options.h"
+#include "Simulation.h"
+
+struct wave_sim {
+    Simulation sim;
+    explicit wave_sim(const RunParams& p) : sim(p) {}
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+// corre f atrapando las excepciones: 0 si salio bien, -1 con el mensaje en last_error
+template <class F>
+int guarded(F&& f){
+    try {
+        f();
+        return 0;
+    } catch (const std::exception& e){
+        last_error = e.what();
+    } catch (...){
+        last_error = "error desconocido";
+    }
+    return -1;
+}
+
+} // namespace
+
+extern "C" {
+
+int wave_api_version(void){ return WAVE_API_VERSION; }
+
+const char* wave_last_error(void){ return last_error.c_str(); }
+
+wave_sim* wave_create(int argc, const char* const* argv){
+    wave_sim* s = nullptr;
+    guarded([&]{
+        // parse_args salta argv[0]
+        std::vector<const char*> args{"wave"};
+        for (int i=0; i<argc; ++i) args.push_back(argv[i]);
+        s = new wave_sim(parse_args((int)args.size(), args.data()));
+    });
+    return s;
+}
+
+void wave_destroy(wave_sim* sim){ delete sim; }
+
+int wave_step(wave_sim* sim, long n){ return guarded([&]{ sim->sim.step(n); }); }
+
+int wave_reset(wave_sim* sim){ return guarded([&]{ sim->sim.reset(); }); }
+
+int wave_on_step(wave_sim* sim, wave_step_fn fn, void* user, int every){
+    int id = -1;
+    guarded([&]{
+        id = sim->sim.onStep([sim, fn, user](const Simulation& s){ fn(sim, s.stepsDone(), user); }, every);
+    });
+    return id;
+}
+
+int wave_remove_callback(wave_sim* sim, int id){ return guarded([&]{ sim->sim.removeCallback(id); }); }
+
+long wave_steps_done(const wave_sim* sim){ return sim->sim.stepsDone(); }
+double wave_time(const wave_sim* sim){ return sim->sim.time(); }
+double wave_energy(const wave_sim* sim){ return sim->sim.energy(); }
+
+const double* wave_energies(const wave_sim* sim, size_t* n){
+    const ConstView<double> e = sim->sim.energies();
+    if (n) *n = e.size();
+    return e.data();
+}
+
+void wave_shape(const wave_sim* sim, int* nx, int* ny){
+    if (nx) *nx = sim->sim.nx();
+    if (ny) *ny = sim->sim.ny();
+}
+
+int wave_elem_size(const wave_sim* sim){ return sim->sim.singlePrecision() ? 4 : 8; }
+
+const void* wave_amplitudes(const wave_sim* sim, size_t* n){
+    if (n) *n = sim->sim.nodes();
+    if (sim->sim.singlePrecision()) return sim->sim.amplitudesF32().data();
+    return sim->sim.amplitudes().data();
+}
+
+const int* wave_original_ids(const wave_sim* sim, size_t* n){
+    const ConstView<int> ids = sim->sim.originalIds();
+    if (n) *n = ids.size();
+    return ids.empty() ? nullptr : ids.data();
+}
+
+} // extern "C"
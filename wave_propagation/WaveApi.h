@@ -0,0 +1,66 @@
+#ifndef WAVE_API_H   /* para que se compile solo una vez (tambien desde C) */
+#define WAVE_API_H
+
+/*
+ * API C de la biblioteca (libwave.so / libwave.a; make lib). Envuelve
+ * Simulation.h con tipos de C para usarla desde otros lenguajes (Python con
+ * ctypes: scripts/wave_lib.py).
+ *
+ * La configuracion son las mismas opciones que el ejecutable ("--network",
+ * "2d", "--Lx", "300", ...): el formato no cambia al agregar campos. Las
+ * funciones que devuelven int dan 0 si salio bien y -1 si hubo error;
+ * wave_last_error() devuelve el mensaje del ultimo error del hilo. Ninguna
+ * excepcion de C++ cruza esta interfaz.
+ *
+ * Los punteros a amplitudes y energias apuntan a la memoria de la simulacion
+ * (sin copia) y valen hasta el proximo wave_step, wave_reset o wave_destroy.
+ * Un handle no se usa desde dos hilos a la vez.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WAVE_API_VERSION 1
+
+typedef struct wave_sim wave_sim;
+
+/* despues de cada paso multiplo de `every` (wave_on_step), en el hilo que llamo a wave_step */
+typedef void (*wave_step_fn)(wave_sim* sim, long step, void* user);
+
+int wave_api_version(void);
+const char* wave_last_error(void);
+
+/* argv sin el nombre del programa; NULL si las opciones no son validas (o --help) */
+wave_sim* wave_create(int argc, const char* const* argv);
+void wave_destroy(wave_sim* sim);
+
+int wave_step(wave_sim* sim, long n);
+int wave_reset(wave_sim* sim);
+
+/* devuelve el id del callback (>= 0) o -1 */
+int wave_on_step(wave_sim* sim, wave_step_fn fn, void* user, int every);
+int wave_remove_callback(wave_sim* sim, int id);
+
+long wave_steps_done(const wave_sim* sim);
+double wave_time(const wave_sim* sim);
+double wave_energy(const wave_sim* sim);
+/* energia de cada paso del ultimo wave_step; *n = cantidad */
+const double* wave_energies(const wave_sim* sim, size_t* n);
+
+/* forma de la red (1D o grafo: nx = nodos, ny = 1) */
+void wave_shape(const wave_sim* sim, int* nx, int* ny);
+/* 8 (float64) o 4 (float32, --precision f32/mixed) */
+int wave_elem_size(const wave_sim* sim);
+/* estado confirmado: float64* o float32* segun wave_elem_size; *n = nodos */
+const void* wave_amplitudes(const wave_sim* sim, size_t* n);
+/* grafo reordenado: nodo original de cada nodo interno (NULL y *n = 0 si no hay) */
+const int* wave_original_ids(const wave_sim* sim, size_t* n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WAVE_API_H */
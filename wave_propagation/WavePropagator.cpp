@@ -1,11 +1,26 @@
 #include "WavePropagator.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <filesystem>
 #include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <type_traits>
 #include <omp.h>
 
+#include "ActiveRegion.h"
+#include "Numa.h"
+#include "Observables.h"
+#include "PerfCounters.h"
+#include "Profiler.h"
+#include "Spectral.h"
+#include "StealPool.h"
+#include "Stencil.h"
+#include "Sweep.h"
+#include "TemporalBlocking.h"
+
 WavePropagator::WavePropagator(Network& net, const RunParams& params)
     : net_(net), params_(params), rng_(std::random_device{}()), norm_(params_.omega_mu, params_.omega_sigma)
 {
@@ -19,6 +34,7 @@ WavePropagator::WavePropagator(Network& net, const RunParams& params)
                 ? ((net_.Ly()/2) * net_.Lx() + (net_.Lx()/2))
                 : (net_.Lx()/2);
         }
+        single_idx_ = net_.internalIndex(single_idx_);   // --noise-node es un nodo original
         omega_i_.assign(net_.size(), 0.0);
         if (single_idx_ >= 0 && single_idx_ < net_.size()){
             omega_i_[single_idx_] = norm_(rng_);
@@ -26,22 +42,50 @@ WavePropagator::WavePropagator(Network& net, const RunParams& params)
     }
 }
 
-double WavePropagator::source_val(int idx, double time) const{
+void WavePropagator::init_source(){
+    if (source_ready_) return;
+    source_ready_ = true;
+    const double t0 = tcur_;
+    const double dt = params_.dt;
+    const int resync = params_.src_resync;
     switch (params_.noise){
         case NoiseMode::Off:
-            return 0.0;
+            source_.init(nullptr, 0, t0, dt, resync);
+            break;
         case NoiseMode::Global:
-            return params_.S0 * std::sin(params_.omega * time);
+            source_.init(&params_.omega, 1, t0, dt, resync);
+            break;
         case NoiseMode::PerNode:
-            if (idx >= 0 && idx < (int)omega_i_.size())
-                return params_.S0 * std::sin(omega_i_[idx] * time);
-            return 0.0;
+            source_.init(omega_i_.data(), (int)omega_i_.size(), t0, dt, resync);
+            break;
         case NoiseMode::Single:
-            if (idx == single_idx_ && idx >= 0 && idx < (int)omega_i_.size())
-                return params_.S0 * std::sin(omega_i_[idx] * time);
-            return 0.0;
+            if (single_idx_ >= 0 && single_idx_ < (int)omega_i_.size())
+                source_.init(&omega_i_[single_idx_], 1, t0, dt, resync);
+            else
+                source_.init(nullptr, 0, t0, dt, resync);
+            break;
     }
-    return 0.0;
+}
+
+SourceTerm WavePropagator::source_term() const{
+    SourceTerm s;
+    if (source_.size() == 0) return s;
+    switch (params_.noise){
+        case NoiseMode::Off:
+            break;
+        case NoiseMode::Global:
+            s.uniform = params_.S0 * source_.values()[0];
+            break;
+        case NoiseMode::PerNode:
+            s.values = source_.values();
+            s.scale = params_.S0;
+            break;
+        case NoiseMode::Single:
+            s.single_idx = single_idx_;
+            s.single_val = params_.S0 * source_.values()[0];
+            break;
+    }
+    return s;
 }
 
 void WavePropagator::dump_energy(std::ofstream& fe, int step, double E){
@@ -49,31 +93,220 @@ void WavePropagator::dump_energy(std::ofstream& fe, int step, double E){
     fe << step << "\t" << std::setprecision(12) << E << "\n";
 }
 
-void WavePropagator::dump_frame_1d(int step){
+void WavePropagator::open_frames(){
+    if (!params_.dump_frames) return;
+    if (params_.frame_format == FrameFormat::Compressed && !zframes_.isOpen()){
+        if (params_.frame_tol < 0) throw std::runtime_error("--frame-tol debe ser >= 0");
+        // por defecto comprimen las CPUs que no usa la simulacion (al menos una)
+        const int threads = params_.frame_threads > 0 ? params_.frame_threads
+                                                      : std::max(1, allowed_cpu_count() - omp_get_max_threads());
+        zframes_.open("results/frames/frames.wfz", net_.Lx(), net_.is2D() ? net_.Ly() : 1, params_.frame_dtype,
+                      params_.frame_tol, params_.frame_keyframe, threads, steps_done_ > 0, steps_done_);
+        return;
+    }
+    if (params_.frame_format != FrameFormat::Binary) return;
+    if (!frames_.isOpen()){
+        // al continuar se agregan frames y se descartan los posteriores al checkpoint
+        frames_.open("results/frames/frames.bin", net_.Lx(), net_.is2D() ? net_.Ly() : 1, params_.frame_dtype,
+                     steps_done_ > 0, steps_done_);
+    }
+}
+
+void WavePropagator::open_energy(std::ofstream& f, const std::string& path){
+    std::filesystem::path p(path);
+    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
+    if (steps_done_ > 0 && std::filesystem::exists(p)){
+        // continuacion: conserva las lineas hasta el paso del checkpoint
+        std::ifstream in(path);
+        std::string kept, line;
+        while (std::getline(in, line)){
+            if (!line.empty() && line[0] != '#' && std::atol(line.c_str()) > steps_done_) break;
+            kept += line;
+            kept += '\n';
+        }
+        in.close();
+        f.open(path, std::ios::trunc);
+        f << kept;
+        return;
+    }
+    f.open(path);
+}
+
+std::shared_ptr<CheckpointState> WavePropagator::capture_checkpoint(long step, double time, double last_1d) const{
+    auto ck = std::make_shared<CheckpointState>();
+    ck->params = params_;
+    ck->step = step;
+    ck->time = time;
+    ck->last_1d_sample = last_1d;
+    ck->single_idx = single_idx_;
+    std::ostringstream r, n;
+    r << rng_;
+    n << norm_;
+    ck->rng = r.str();
+    ck->norm = n.str();
+    ck->omega = omega_i_;
+    // la fuente se inicia en el paso 0 y avanza uno por paso: su contador es `step`
+    // (no se lee source_.step(), que otro hilo puede estar actualizando)
+    ck->src_step = step;
+    ck->src_sin.assign(source_.values(), source_.values() + source_.size());
+    ck->src_cos.assign(source_.cosines(), source_.cosines() + source_.size());
+    return ck;
+}
+
+void WavePropagator::copyNoise(const WavePropagator& o){
+    omega_i_ = o.omega_i_;
+    single_idx_ = o.single_idx_;
+    source_ready_ = false;
+}
+
+void WavePropagator::restore(const CheckpointState& ck){
+    if ((int)ck.amp.size() != net_.size())
+        throw std::runtime_error("el checkpoint no coincide con el tamano de la red");
+    net_.loadAmplitudes(ck.amp.data());
+    tcur_ = ck.time;
+    steps_done_ = ck.step;
+    last_1d_sample_ = ck.last_1d_sample;
+    omega_i_ = ck.omega;
+    single_idx_ = ck.single_idx;
+    std::istringstream r(ck.rng), n(ck.norm);
+    r >> rng_;
+    n >> norm_;
+    source_ready_ = false;
+    init_source();
+    if ((int)ck.src_sin.size() != source_.size() || (int)ck.src_cos.size() != source_.size())
+        throw std::runtime_error("checkpoint: estado de la fuente inconsistente");
+    source_.setState(ck.src_sin.data(), ck.src_cos.data(), ck.src_step);
+}
+
+void WavePropagator::dump_frame(int step, double time, const double* amp){
+    if (net_.reordered()){
+        // grafo reordenado: los frames van en la numeracion original
+        const std::vector<int>& ids = net_.originalIds();
+        frame_orig_.resize(ids.size());
+        for (size_t k=0; k<ids.size(); ++k) frame_orig_[ids[k]] = amp[k];
+        amp = frame_orig_.data();
+    }
+    if (params_.frame_format == FrameFormat::Binary){
+        frames_.write(step, time, amp);
+        return;
+    }
+    if (params_.frame_format == FrameFormat::Compressed){
+        zframes_.write(step, time, amp);
+        return;
+    }
+    if (net_.is2D()) dump_frame_2d(step, amp);
+    else dump_frame_1d(step, amp);
+}
+
+void WavePropagator::open_stream(){
+    if (params_.stream.empty() || stream_.isOpen()) return;
+    if (params_.stream_every < 1 || params_.stream_slots < 1)
+        throw std::runtime_error("--stream-every y --stream-slots deben ser >= 1");
+    if (!stream_.open(params_.stream, net_.Lx(), net_.is2D() ? net_.Ly() : 1, params_.stream_slots, params_.stream_dtype))
+        throw std::runtime_error("no se pudo crear la memoria compartida del stream " + params_.stream);
+    std::cout << "[stream] /dev/shm" << stream_.name() << ": " << params_.stream_slots
+              << " slots, un frame cada " << params_.stream_every << " pasos\n";
+}
+
+void WavePropagator::publish_stream(int step, double time, const double* amp){
+    if (net_.reordered()){
+        // mismo buffer que dump_frame: los dos corren en el hilo escritor
+        const std::vector<int>& ids = net_.originalIds();
+        frame_orig_.resize(ids.size());
+        for (size_t k=0; k<ids.size(); ++k) frame_orig_[ids[k]] = amp[k];
+        amp = frame_orig_.data();
+    }
+    stream_.publish(step, time, amp);
+}
+
+void WavePropagator::flush_frames(){
+    frames_.flush();
+    zframes_.flush();
+}
+
+void WavePropagator::report_frames() const{
+    if (zframes_.frames() == 0) return;
+    const double mb = 1.0 / (1024.0*1024.0);
+    const double s = zframes_.encodeSeconds();
+    char line[224];
+    std::snprintf(line, sizeof(line), "[frames] %ld frames comprimidos: %.1f MB -> %.1f MB (x%.1f), %.0f MB/s%s\n",
+                  zframes_.frames(), zframes_.rawBytes()*mb, zframes_.storedBytes()*mb,
+                  zframes_.storedBytes() > 0 ? zframes_.rawBytes() / zframes_.storedBytes() : 0.0,
+                  s > 0 ? zframes_.rawBytes()*mb / s : 0.0,
+                  params_.frame_tol > 0 ? ", error <= --frame-tol" : ", sin perdida");
+    std::cout << line;
+    if (zframes_.clamped() > 0)
+        std::cout << "[frames] " << zframes_.clamped() << " nodos fuera del rango de --frame-tol (saturados)\n";
+}
+
+template <class Real>
+void WavePropagator::hand_off_snapshot(AsyncWriter& out, PendingSnapshot& p, bool in_next){
+    if (p.frame_step < 0 && !p.ckpt && p.stream_step < 0) return;
+    int k;
+    if (p.frame_step < 0 && !p.ckpt){
+        // solo transmision: nunca espera al escritor, con el pool lleno se pierde
+        k = out.tryAcquireFrame();
+        if (k < 0){
+            ++stream_dropped_;
+            p = PendingSnapshot{};
+            return;
+        }
+    } else {
+        k = out.acquireFrame();   // bloquea si el pool esta lleno (contrapresion)
+    }
+    if constexpr (std::is_same<Real, double>::value){
+        // con region activa next debe seguir en cero fuera de la region: se copia
+        if (in_next && !params_.active) net_.exchangeNext(out.frame(k));
+        else {
+            const double* v = in_next ? net_.next() : net_.current();
+            std::copy(v, v + net_.size(), out.frame(k).data());
+        }
+    } else {
+        // almacenamiento float: se convierte al buffer (double) del pool
+        const Real* v = in_next ? net_.nextAs<Real>() : net_.currentAs<Real>();
+        std::copy(v, v + net_.size(), out.frame(k).data());
+    }
+    std::function<void(const double*)> extra;
+    if (p.ckpt){
+        // checkpoint en el hilo escritor: .tmp + rename, la simulacion no espera
+        extra = [ck = p.ckpt, path = params_.checkpoint_path, n = (size_t)net_.size()](const double* amp){
+            if (!save_checkpoint(path, *ck, amp, n))
+                std::cerr << "[checkpoint] no se pudo escribir " << path << "\n";
+        };
+    }
+    if (p.stream_step >= 0){
+        extra = [this, ck = std::move(extra), step = p.stream_step, time = p.time](const double* amp){
+            if (ck) ck(amp);
+            publish_stream(step, time, amp);
+        };
+    }
+    out.submitFrame(k, p.frame_step, p.time, p.frame_step >= 0, std::move(extra));
+    p = PendingSnapshot{};
+}
+
+void WavePropagator::dump_frame_1d(int step, const double* amp){
     char name[256];
     std::snprintf(name, sizeof(name), "results/frames/amp_t%06d.dat", step);
     std::ofstream f(name);
     if (!f) return;
-    auto& nodes = net_.data();
     for (int x=0; x<net_.Lx(); ++x){
         int idx = x;
-        if (idx >= 0 && idx < (int)nodes.size())
-            f << nodes[idx].get() << "\n";
+        if (idx >= 0 && idx < net_.size())
+            f << amp[idx] << "\n";
     }
 }
 
-void WavePropagator::dump_frame_2d(int step){
+void WavePropagator::dump_frame_2d(int step, const double* amp){
     char name[256];
     std::snprintf(name, sizeof(name), "results/frames/amp_t%06d.csv", step);
     std::ofstream f(name);
     if (!f) return;
-    auto& nodes = net_.data();
     const int Lx = net_.Lx();
     const int Ly = net_.Ly();
     for (int y=0; y<Ly; ++y){
         for (int x=0; x<Lx; ++x){
             int idx = y*Lx + x;
-            double val = (idx >= 0 && idx < (int)nodes.size()) ? nodes[idx].get() : 0.0;
+            double val = (idx >= 0 && idx < net_.size()) ? amp[idx] : 0.0;
             f << val;
             if (x+1<Lx) f << ',';
         }
@@ -81,21 +314,225 @@ void WavePropagator::dump_frame_2d(int step){
     }
 }
 
+void WavePropagator::report_profiles(const PerfCounters* pc, const PhaseProfiler* prof, long steps) const{
+    if (pc) pc->report(std::cout, "results/perf_counters.csv", params_, steps, net_.size());
+    if (prof) prof->report(std::cout, "results/profile_summary.csv", "results/profile_trace.json", params_, steps);
+}
+
 void WavePropagator::run(const std::string& energy_out){
-    auto& nodes = net_.data();
+    advance(energy_out);
+    report_frames();
+}
+
+void WavePropagator::runTo(long step, const std::string& energy_out){
+    params_.steps = (int)step;
+    advance(energy_out);
+}
+
+void WavePropagator::rewind(){
+    tcur_ = 0.0;
+    last_1d_sample_ = 0.0;
+    steps_done_ = 0;
+    source_ready_ = false;
+    // el proximo open_frames los reescribe desde el paso 0
+    frames_.close();
+    zframes_.close();
+}
+
+void WavePropagator::advance(const std::string& energy_out){
+    if (params_.spectral){
+        run_spectral(energy_out);
+    } else {
+        net_.setSinglePrecision(params_.precision != Precision::F64);
+        switch (params_.precision){
+            case Precision::F64:   run_impl<double, double>(energy_out); break;
+            case Precision::F32:   run_impl<float, float>(energy_out);   break;
+            case Precision::Mixed: run_impl<float, double>(energy_out);  break;
+        }
+    }
+}
+
+void WavePropagator::run_spectral(const std::string& energy_out){
+    if (!net_.isRegular() || !net_.periodic())
+        throw std::runtime_error("--spectral requiere una grilla 1D/2D con --periodic");
+    if (params_.noise != NoiseMode::Off)
+        throw std::runtime_error("--spectral requiere --noise off (el paso tiene que ser lineal y sin fuente)");
+    if (params_.precision != Precision::F64 || params_.tb_steps > 1 || params_.active ||
+        !params_.observe.empty() || !params_.probes.empty() || params_.perf_counters || params_.profile)
+        throw std::runtime_error("--spectral solo admite f64, sin --temporal-block, --active-region, observables ni perfiles");
+    if (params_.spectral_every < 0) throw std::runtime_error("--spectral-every debe ser >= 0");
+    if (!params_.stream.empty()) throw std::runtime_error("--stream no esta disponible con --spectral");
+
+    const int N = net_.size();
+    const int W = net_.is2D() ? net_.Lx() : N;
+    const int H = net_.is2D() ? net_.Ly() : 1;
+    const long n0 = steps_done_;
+    const long total = std::max(0L, (long)params_.steps - n0);
+    const double t0 = tcur_;
+    const double dt = params_.dt;
+    init_source();   // sin fuente: solo para el estado del checkpoint
+
+    const double t_start = omp_get_wtime();
+    SpectralSolver sp(W, H, StepCoeffs{dt, net_.diffusion(), net_.damping()});
+    sp.load(net_.current());
+    if (sp.maxGrowth() > 1.0){
+        char line[128];
+        std::snprintf(line, sizeof(line), "[spectral] aviso: max |G| = %.6g > 1, el esquema explicito diverge con este dt\n", sp.maxGrowth());
+        std::cout << line;
+    }
+
+    // energia: una linea cada `every` pasos y la del ultimo, por bloques
+    std::ofstream energy_file;
+    if (!energy_out.empty()) open_energy(energy_file, energy_out);
+    const long every = params_.spectral_every > 0 ? params_.spectral_every : std::max(1L, (total + 9999) / 10000);
+    if (energy_file && n0 == 0 && every > 1) energy_file << "# step\tE\n";
+    std::vector<double> E(4096);
+    auto emit = [&](long step, double e){
+        if (energy_file) dump_energy(energy_file, (int)step, e);
+        if (energy_trace_) energy_trace_->push_back(e);
+    };
+    const long samples = total / every;
+    for (long j0=0; j0<samples; j0+=(long)E.size()){
+        const long cnt = std::min((long)E.size(), samples - j0);
+        sp.energies((j0 + 1)*every, every, cnt, E.data());
+        for (long j=0; j<cnt; ++j) emit(n0 + (j0 + j + 1)*every, E[j]);
+    }
+    if (total > 0 && total % every != 0){
+        sp.energies(total, 1, 1, E.data());
+        emit(n0 + total, E[0]);
+    }
+
+    // frames (el frame `it` es el estado tras el paso it, como en run_impl) y
+    // checkpoints: una FFT inversa por instante pedido
+    if (params_.dump_frames){
+        std::filesystem::create_directories("results/frames");
+        open_frames();
+    }
+    const int fe = params_.dump_frames ? params_.frame_every : 0;
+    const int ck_every = params_.checkpoint_every;
+    if (ck_every > 0){
+        std::filesystem::path cp(params_.checkpoint_path);
+        if (cp.has_parent_path()) std::filesystem::create_directories(cp.parent_path());
+    }
+    std::vector<double> amp(N);
+    long inverses = 0;
+    for (long it=n0; it<n0+total; ++it){
+        const bool frame_due = fe > 0 && it % fe == 0;
+        const bool ckpt_due = ck_every > 0 && (it+1) % ck_every == 0;
+        if (!frame_due && !ckpt_due) continue;
+        const long n = it + 1 - n0;
+        sp.state(n, amp.data());
+        ++inverses;
+        const double time = t0 + n*dt;
+        if (frame_due) dump_frame((int)it, time, amp.data());
+        if (ckpt_due){
+            auto ck = capture_checkpoint(it+1, time, net_.is2D() ? last_1d_sample_ : amp[N-1]);
+            if (!save_checkpoint(params_.checkpoint_path, *ck, amp.data(), (size_t)N))
+                std::cerr << "[checkpoint] no se pudo escribir " << params_.checkpoint_path << "\n";
+        }
+    }
+
+    // estado final confirmado en los dos buffers, como tras el commit
+    sp.state(total, amp.data());
+    std::copy(amp.begin(), amp.end(), net_.current());
+    std::copy(amp.begin(), amp.end(), net_.next());
+    if (!net_.is2D() && N > 0) last_1d_sample_ = amp[N-1];
+    tcur_ = t0 + total*dt;
+    steps_done_ = std::max(steps_done_, (long)params_.steps);
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "[spectral] %ld pasos en %.3f s (%ld lineas de energia, %ld FFT inversas)\n",
+                  total, omp_get_wtime() - t_start, samples + (total % every != 0 ? 1 : 0), inverses + 1);
+    std::cout << line;
+    if (energy_file) energy_file.flush();
+    flush_frames();
+}
+
+template <class Real, class Acc>
+void WavePropagator::run_impl(const std::string& energy_out){
+    // Grillas regulares usan el stencil sin matriz; el CSR queda como respaldo
+    const bool use_stencil = net_.isRegular() && params_.kernel == KernelType::Stencil;
+    if (!use_stencil && !net_.hasAdjacency()) net_.buildAdjacency();
+    const Boundary boundary = net_.boundary();
+    // Paso fusionado: actualizacion + energia en un barrido y swap O(1) de buffers
+    const bool fused = params_.fused;
+
+    Real* cur = net_.currentAs<Real>();
+    Real* nxt = net_.nextAs<Real>();
+    const int* off = net_.rowOffsets();
+    const int* nbr = net_.colIndices();
+    const int* parts = net_.parts().data();
+    const int nparts = net_.parts().empty() ? 0 : (int)net_.parts().size() - 1;
     const int N = net_.size();
     const double D = net_.diffusion();
     const double g = net_.damping();
 
     std::ofstream energy_file;
-    if (!energy_out.empty()){
-        std::filesystem::path p(energy_out);
-        if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
-        energy_file.open(energy_out);
-    }
+    if (!energy_out.empty()) open_energy(energy_file, energy_out);
 
     if (params_.dump_frames){
         std::filesystem::create_directories("results/frames");
+        open_frames();
+    }
+    open_stream();
+
+    // Salida asincrona: el hilo escritor vuelca energia (en bloques), frames y
+    // la transmision en vivo
+    const bool want_frames = params_.dump_frames && params_.frame_every > 0;
+    const bool want_ckpt = params_.checkpoint_every > 0;
+    const bool want_stream = stream_.isOpen();
+    if (want_ckpt){
+        std::filesystem::path cp(params_.checkpoint_path);
+        if (cp.has_parent_path()) std::filesystem::create_directories(cp.parent_path());
+    }
+    AsyncWriter out((want_frames || want_ckpt || want_stream) ? (size_t)N : 0, params_.io_buffers,
+                    params_.async_io && (energy_file.is_open() || want_frames || want_ckpt || want_stream),
+                    [&](int step, double E){
+                        if (energy_file) dump_energy(energy_file, step, E);
+                        if (energy_trace_) energy_trace_->push_back(E);
+                    },
+                    [&](int step, double time, const double* amp){ dump_frame(step, time, amp); },
+                    [this]{ return net_.placedBuffer(); });
+
+    // Bloqueo temporal: solo grillas 2D con stencil (el frame/energia por paso se conserva)
+    // contadores de hardware por fase (nullptr = desactivados)
+    std::unique_ptr<PerfCounters> counters;
+    if (params_.perf_counters) counters = std::make_unique<PerfCounters>(omp_get_max_threads());
+    PerfCounters* pc = counters.get();
+    // computo y espera por fase e hilo (nullptr = sin perfil)
+    std::unique_ptr<PhaseProfiler> profiler;
+    if (params_.profile) profiler = std::make_unique<PhaseProfiler>(omp_get_max_threads(), params_.profile_steps);
+    PhaseProfiler* prof = profiler.get();
+    const long first_step = steps_done_;
+    // observables en linea (nullptr = ninguno pedido)
+    Observables observables(params_, net_.Lx(), net_.Ly(), net_.is2D(), omp_get_max_threads());
+    Observables* ob = observables.enabled() ? &observables : nullptr;
+    if (ob && net_.reordered()) observables.mapNodes(net_.originalIds());
+
+    if (params_.active && (!use_stencil || params_.collapse2 || params_.taskloop || params_.tb_steps > 1))
+        throw std::runtime_error("--active-region solo admite el stencil por filas (sin --kernel csr, --collapse2, --taskloop ni --temporal-block)");
+    if (params_.active_tol < 0) throw std::runtime_error("--active-tol debe ser >= 0");
+
+    if (params_.backend == Backend::Pool){
+        if (!use_stencil || !fused || params_.taskloop || params_.collapse2 || params_.tb_steps > 1 || pc || prof)
+            throw std::runtime_error("--backend pool solo admite el stencil fusionado (sin --kernel csr, --no-fused, --taskloop, --collapse2, --temporal-block ni perfiles)");
+        if (params_.active) throw std::runtime_error("--backend pool no admite --active-region");
+        run_pool<Real, Acc>(out, ob);
+        out.finish();
+        if (ob) ob->flush();
+        if (energy_file) energy_file.flush();
+        flush_frames();
+        return;
+    }
+
+    if (use_stencil && net_.is2D() && params_.tb_steps > 1){
+        if (ob) throw std::runtime_error("--observe y --probe no estan disponibles con --temporal-block");
+        run_temporal_blocked<Real, Acc>(out, pc, prof);
+        report_profiles(pc, prof, steps_done_ - first_step);
+        out.finish();
+        if (energy_file) energy_file.flush();
+        flush_frames();
+        return;
     }
 
     const int chunk = params_.chunk > 0 ? params_.chunk : 1;
@@ -103,195 +540,451 @@ void WavePropagator::run(const std::string& energy_out){
 
     double dt = params_.dt;
     double local_t = tcur_;
-    double final_t = local_t;
-    double time_for_step = 0.0;
     double E_global = 0.0;
     double last_committed_value = last_1d_sample_;
+    PendingSnapshot pending;
+    SourceTerm src;
+    init_source();
+    const int step0 = (int)steps_done_;
+    const int ck_every = params_.checkpoint_every;
+    const int se = stream_every();
 
     const int Lx = net_.Lx();
     const int Ly = net_.Ly();
     const bool is2D = net_.is2D();
 
+    // sumas parciales por hilo (modo fusionado con reduction): se suman en orden de hilo
+    std::vector<double> partial((size_t)omp_get_max_threads() * kPad, 0.0);
+
+    // max/centroide: en el barrido (row_hook) o, en variantes sin filas, en
+    // una pasada sobre next por bloques de obs_blk nodos
+    if (ob) ob->open(steps_done_);
+    bool obs_sweep = false;
+    const bool obs_hooked = use_stencil && sweep_has_row_hook(is2D, params_, Lx, Ly);
+    const int obs_blk = is2D ? Lx : 4096;
+    const int obs_nblk = (N + obs_blk - 1) / obs_blk;
+
+    // region activa (nullptr = se actualiza toda la grilla)
+    std::unique_ptr<ActiveRegion> region;
+    if (params_.active){
+        region = std::make_unique<ActiveRegion>(params_, is2D ? Lx : N, is2D ? Ly : 1, is2D, boundary == Boundary::Periodic,
+                                                params_.noise == NoiseMode::Single ? single_idx_ : -1);
+        region->init(cur, nxt);
+    }
+    ActiveRegion* ar = region.get();
+
     #pragma omp parallel default(none) \
-        shared(nodes, N, D, g, dt, time_for_step, E_global, chunk, grain, Lx, Ly, energy_file, final_t, last_committed_value, is2D) \
-        firstprivate(local_t)
+        shared(cur, nxt, off, nbr, parts, nparts, N, D, g, dt, use_stencil, boundary, fused, partial, \
+               E_global, src, chunk, grain, Lx, Ly, out, pending, local_t, last_committed_value, is2D, step0, ck_every, se, pc, prof, \
+               ob, obs_sweep, obs_hooked, obs_blk, obs_nblk, ar)
     {
-        for (int it=0; it<params_.steps; ++it){
-            #pragma omp single
+        const int tid = omp_get_thread_num();
+        const int nth = omp_get_num_threads();
+        if (pc) pc->openThread(tid);
+        if (prof) prof->begin(tid);
+        // Cada fase termina en una barrera explicita (los barridos y los for
+        // son nowait): el hilo marca el fin de su parte antes de esperar
+        auto end_phase = [&](StepPhase ph){
+            if (prof) prof->computeDone(tid);
+            #pragma omp barrier
+            if (prof) prof->phaseDone(tid, ph);
+            if (pc) pc->mark(tid, ph);
+        };
+        auto obs_hook = [&](int i0, int i1){
+            if (obs_sweep) ob->accumulate(tid, nxt, i0, i1);
+        };
+        // pasada de observables para las variantes sin row_hook (antes de la barrera del llamador)
+        auto obs_pass = [&]{
+            if (!obs_sweep || obs_hooked) return;
+            #pragma omp for schedule(static) nowait
+            for (int b=0; b<obs_nblk; ++b)
+                ob->accumulate(tid, nxt, b*obs_blk, std::min(N, (b+1)*obs_blk));
+        };
+
+        for (int it=step0; it<params_.steps; ++it){
+            #pragma omp single nowait
             {
-                time_for_step = local_t;
                 E_global = 0.0;
+                src = source_term();
+                obs_sweep = ob && ob->sweepDue(it+1);
+                if (obs_sweep) ob->resetPartials();
+                if (ar) ar->plan(src, nth);
             }
+            end_phase(StepPhase::Serial);
 
-            auto update_index = [&](int idx){
-                double ai = nodes[idx].getPrev();
-                const auto& nb = nodes[idx].neighbors();
-                double acc = 0.0;
-                for (int j : nb){
-                    acc += (nodes[j].getPrev() - ai);
+            const StepCoeffs coeffs{dt, D, g};
+            auto update_index = [&](int idx) -> Acc {
+                const Acc ai = cur[idx];
+                Acc acc = 0;
+                for (int k=off[idx], kend=off[idx+1]; k<kend; ++k){
+                    acc += ((Acc)cur[nbr[k]] - ai);
                 }
-                double s = source_val(idx, time_for_step);
-                nodes[idx].set(ai + dt*(D*acc - g*ai + s));
+                return nxt[idx] = (Real)stencil_update<Acc>(ai, acc, (Acc)src.at(idx), coeffs);
             };
 
-            if (params_.taskloop){
-                if (is2D){
-                    #pragma omp single
-                    {
-                        #pragma omp taskloop grainsize(grain)
-                        for (int y=0; y<Ly; ++y){
-                            for (int x=0; x<Lx; ++x){
-                                int idx = y*Lx + x;
-                                update_index(idx);
-                            }
-                        }
-                        #pragma omp taskwait
-                    }
+            if (fused && ar){
+                // la energia queda por fila/bloque en ar y se suma en la single
+                ar->sweep<Real, Acc, true>(boundary, cur, nxt, coeffs, src, tid, obs_hook);
+                end_phase(StepPhase::Update);
+            } else if (fused){
+                const double e = use_stencil
+                    ? stencil_dispatch<Real, Acc, true>(is2D, boundary, cur, nxt, is2D ? Lx : N, Ly, coeffs, params_, chunk, grain, src, obs_hook)
+                    : csr_sweep<true>(N, Lx, Ly, is2D, params_, chunk, grain, update_index, parts, nparts);
+                if (params_.energyAccum == EnergyAccum::Reduction){
+                    partial[(size_t)tid * kPad] = e;
+                } else if (params_.energyAccum == EnergyAccum::Atomic){
+                    #pragma omp atomic
+                    E_global += e;
                 } else {
-                    #pragma omp single
+                    #pragma omp critical
                     {
-                        #pragma omp taskloop grainsize(grain)
-                        for (int i=0; i<N; ++i){
-                            update_index(i);
-                        }
-                        #pragma omp taskwait
+                        E_global += e;
                     }
                 }
-            } else if (is2D){
-                if (params_.collapse2){
-                    if (params_.schedule == ScheduleType::Static){
-                        #pragma omp for schedule(static, chunk) collapse(2)
-                        for (int y=0; y<Ly; ++y){
-                            for (int x=0; x<Lx; ++x){
-                                int idx = y*Lx + x;
-                                update_index(idx);
-                            }
-                        }
-                    } else if (params_.schedule == ScheduleType::Dynamic){
-                        #pragma omp for schedule(dynamic, chunk) collapse(2)
-                        for (int y=0; y<Ly; ++y){
-                            for (int x=0; x<Lx; ++x){
-                                int idx = y*Lx + x;
-                                update_index(idx);
-                            }
-                        }
-                    } else {
-                        #pragma omp for schedule(guided, chunk) collapse(2)
-                        for (int y=0; y<Ly; ++y){
-                            for (int x=0; x<Lx; ++x){
-                                int idx = y*Lx + x;
-                                update_index(idx);
-                            }
-                        }
-                    }
-                } else {
-                    if (params_.schedule == ScheduleType::Static){
-                        #pragma omp for schedule(static, chunk)
-                        for (int y=0; y<Ly; ++y){
-                            for (int x=0; x<Lx; ++x){
-                                int idx = y*Lx + x;
-                                update_index(idx);
-                            }
-                        }
-                    } else if (params_.schedule == ScheduleType::Dynamic){
-                        #pragma omp for schedule(dynamic, chunk)
-                        for (int y=0; y<Ly; ++y){
-                            for (int x=0; x<Lx; ++x){
-                                int idx = y*Lx + x;
-                                update_index(idx);
-                            }
-                        }
-                    } else {
-                        #pragma omp for schedule(guided, chunk)
-                        for (int y=0; y<Ly; ++y){
-                            for (int x=0; x<Lx; ++x){
-                                int idx = y*Lx + x;
-                                update_index(idx);
-                            }
-                        }
-                    }
+                end_phase(StepPhase::Update);
+                if (obs_sweep && !obs_hooked){
+                    obs_pass();
+                    end_phase(StepPhase::Energy);
                 }
             } else {
-                if (params_.schedule == ScheduleType::Static){
-                    #pragma omp for schedule(static, chunk)
+                if (ar)
+                    ar->sweep<Real, Acc, false>(boundary, cur, nxt, coeffs, src, tid, obs_hook);
+                else if (use_stencil)
+                    stencil_dispatch<Real, Acc, false>(is2D, boundary, cur, nxt, is2D ? Lx : N, Ly, coeffs, params_, chunk, grain, src, obs_hook);
+                else
+                    csr_sweep<false>(N, Lx, Ly, is2D, params_, chunk, grain, update_index, parts, nparts);
+                end_phase(StepPhase::Update);
+
+                if (ar){
+                    const double local_sum = ar->sumsq<Real, Acc>(nxt, tid);
+                    #pragma omp critical
+                    {
+                        E_global += local_sum;
+                    }
+                } else if (params_.energyAccum == EnergyAccum::Reduction){
+                    #pragma omp for reduction(+:E_global) nowait
+                    for (int i=0; i<N; ++i){
+                        const Acc a = nxt[i];
+                        E_global += a*a;
+                    }
+                } else if (params_.energyAccum == EnergyAccum::Atomic){
+                    #pragma omp for nowait
+                    for (int i=0; i<N; ++i){
+                        const Acc a = nxt[i];
+                        const double e = a*a;
+                        #pragma omp atomic
+                        E_global += e;
+                    }
+                } else {
+                    double local_sum = 0.0;
+                    #pragma omp for nowait
                     for (int i=0; i<N; ++i){
-                        update_index(i);
+                        const Acc a = nxt[i];
+                        local_sum += a*a;
+                    }
+                    #pragma omp critical
+                    {
+                        E_global += local_sum;
                     }
-                } else if (params_.schedule == ScheduleType::Dynamic){
-                    #pragma omp for schedule(dynamic, chunk)
+                }
+                obs_pass();
+                end_phase(StepPhase::Energy);
+
+                if (ar){
+                    ar->copy(cur, nxt, tid);
+                } else if (is2D){
+                    #pragma omp for nowait
                     for (int i=0; i<N; ++i){
-                        update_index(i);
+                        cur[i] = nxt[i];
                     }
                 } else {
-                    #pragma omp for schedule(guided, chunk)
+                    #pragma omp for lastprivate(last_committed_value) nowait
                     for (int i=0; i<N; ++i){
-                        update_index(i);
+                        cur[i] = nxt[i];
+                        last_committed_value = cur[i];
                     }
                 }
+                end_phase(StepPhase::Commit);
             }
 
-            if (params_.energyAccum == EnergyAccum::Reduction){
-                #pragma omp for reduction(+:E_global)
-                for (int i=0; i<N; ++i){
-                    double a = nodes[i].get();
-                    E_global += a*a;
+            // la fuente avanza al paso siguiente por rotacion (sin std::sin por nodo)
+            if (source_.size() > 0){
+                source_.advanceParallelNowait(1, local_t + dt);
+                end_phase(StepPhase::Source);
+            }
+
+            #pragma omp single nowait
+            {
+                if (source_.size() > 0) source_.finishParallel(1);
+                if (fused){
+                    if (ar){
+                        E_global = ar->energy(nth);
+                    } else if (params_.energyAccum == EnergyAccum::Reduction){
+                        for (int t=0; t<nth; ++t) E_global += partial[(size_t)t * kPad];
+                    }
+                    // swap O(1): el buffer recien escrito pasa a ser el estado confirmado
+                    net_.swapBuffers();
+                    // la instantanea del paso anterior quedo en next: se entrega sin copiar
+                    hand_off_snapshot<Real>(out, pending, true);
+                    cur = net_.currentAs<Real>();
+                    nxt = net_.nextAs<Real>();
+                    if (!is2D && N > 0) last_committed_value = cur[N-1];
                 }
-            } else if (params_.energyAccum == EnergyAccum::Atomic){
-                #pragma omp for
-                for (int i=0; i<N; ++i){
-                    double e = nodes[i].get();
-                    e *= e;
-                    #pragma omp atomic
-                    E_global += e;
+                if (ar){
+                    ar->advance(fused);
+                    if (!fused && !is2D && N > 0) last_committed_value = cur[N-1];
                 }
-            } else {
-                double local_sum = 0.0;
-                #pragma omp for
-                for (int i=0; i<N; ++i){
-                    double a = nodes[i].get();
-                    local_sum += a*a;
+                out.energy(it+1, E_global);
+                if (ob) ob->record(it+1, E_global, cur);
+                const bool frame_due = params_.dump_frames && params_.frame_every>0 && (it % params_.frame_every == 0);
+                const bool ckpt_due = ck_every > 0 && ((it+1) % ck_every == 0);
+                const bool stream_due = se > 0 && (it % se == 0);
+                if (!is2D){
+                    last_1d_sample_ = last_committed_value;
                 }
-                #pragma omp critical
-                {
-                    E_global += local_sum;
+                if (frame_due || ckpt_due || stream_due){
+                    pending.frame_step = frame_due ? it : -1;
+                    pending.stream_step = stream_due ? it : -1;
+                    pending.time = local_t + dt;
+                    if (ckpt_due) pending.ckpt = capture_checkpoint(it+1, local_t + dt, last_1d_sample_);
+                    if (ckpt_due && ob) ob->flush();   // los registros hasta el checkpoint quedan en disco
+                    if (!fused) hand_off_snapshot<Real>(out, pending, false);
                 }
+                local_t += dt;
             }
+            end_phase(StepPhase::Serial);
+        }
+        if (pc) pc->closeThread(tid);
+    }
 
-            if (is2D){
-                #pragma omp for
-                for (int i=0; i<N; ++i){
-                    nodes[i].commit();
-                }
+    hand_off_snapshot<Real>(out, pending, false);   // instantanea del ultimo paso (sigue en current)
+    out.finish();
+    if (ob) ob->flush();
+    if (ar){
+        char line[96];
+        std::snprintf(line, sizeof(line), "[active-region] nodos actualizados: %.1f%% de N*pasos\n", 100.0*ar->fraction());
+        std::cout << line;
+    }
+    tcur_ = local_t;
+    steps_done_ = std::max(steps_done_, (long)params_.steps);
+    report_profiles(pc, prof, steps_done_ - first_step);
+    if (energy_file){
+        energy_file.flush();
+    }
+    flush_frames();
+}
+
+template <class Real, class Acc>
+void WavePropagator::run_pool(AsyncWriter& out, Observables* ob){
+    const bool is2D = net_.is2D();
+    const int N = net_.size();
+    const int W = is2D ? net_.Lx() : N;
+    const int Ly = net_.Ly();
+    const Boundary boundary = net_.boundary();
+    const int chunk = params_.chunk > 0 ? params_.chunk : 1;
+    const int ntiles = stencil_tile_count(is2D, W, Ly, chunk);
+    const double dt = params_.dt;
+    const StepCoeffs coeffs{dt, net_.diffusion(), net_.damping()};
+    const int ck_every = params_.checkpoint_every;
+    const int se = stream_every();
+
+    StealPool& pool = StealPool::shared(omp_get_max_threads(), params_.pin, params_.pool_spin);
+    std::vector<double> tile_e(ntiles, 0.0);
+    init_source();
+    // fuente por nodo: la rotacion de las fases tambien se reparte en el pool
+    constexpr int kSrcBlock = 2048;
+    const int nsrc = source_.size();
+    const int nsrc_blk = (nsrc + kSrcBlock - 1) / kSrcBlock;
+    if (ob) ob->open(steps_done_);
+
+    Real* cur = net_.currentAs<Real>();
+    Real* nxt = net_.nextAs<Real>();
+    double local_t = tcur_;
+    double t_adv = 0.0;
+    bool obs_sweep = false;
+    SourceTerm src;
+    PendingSnapshot pending;
+
+    auto sweep = [&](int k, int w){
+        auto hook = [&](int i0, int i1){
+            if (obs_sweep) ob->accumulate(w, nxt, i0, i1);
+        };
+        tile_e[k] = stencil_tile<Real, Acc, true>(is2D, boundary, cur, nxt, W, Ly, coeffs, src, chunk, k, hook);
+    };
+    auto advance = [&](int b, int){
+        source_.advanceRange(b*kSrcBlock, std::min(nsrc, (b+1)*kSrcBlock), 1, t_adv);
+    };
+
+    const long steals0 = pool.steals();
+    const int step0 = (int)steps_done_;
+    for (int it=step0; it<params_.steps; ++it){
+        src = source_term();
+        obs_sweep = ob && ob->sweepDue(it+1);
+        if (obs_sweep) ob->resetPartials();
+        pool.run(ntiles, sweep);
+        if (nsrc > 0){
+            t_adv = local_t + dt;
+            if (nsrc > 1){
+                pool.run(nsrc_blk, advance);
+                source_.finishParallel(1);
             } else {
-                #pragma omp for lastprivate(last_committed_value)
-                for (int i=0; i<N; ++i){
-                    nodes[i].commit();
-                    last_committed_value = nodes[i].get();
-                }
+                source_.advance(1, t_adv);
             }
+        }
+
+        // energia en orden de tile: no depende de los robos
+        double E = 0.0;
+        for (int k=0; k<ntiles; ++k) E += tile_e[k];
+        net_.swapBuffers();
+        hand_off_snapshot<Real>(out, pending, true);
+        cur = net_.currentAs<Real>();
+        nxt = net_.nextAs<Real>();
+        if (!is2D && N > 0) last_1d_sample_ = cur[N-1];
+        out.energy(it+1, E);
+        if (ob) ob->record(it+1, E, cur);
+        const bool frame_due = params_.dump_frames && params_.frame_every>0 && (it % params_.frame_every == 0);
+        const bool ckpt_due = ck_every > 0 && ((it+1) % ck_every == 0);
+        const bool stream_due = se > 0 && (it % se == 0);
+        if (frame_due || ckpt_due || stream_due){
+            pending.frame_step = frame_due ? it : -1;
+            pending.stream_step = stream_due ? it : -1;
+            pending.time = local_t + dt;
+            if (ckpt_due) pending.ckpt = capture_checkpoint(it+1, local_t + dt, last_1d_sample_);
+            if (ckpt_due && ob) ob->flush();
+        }
+        local_t += dt;
+    }
+
+    hand_off_snapshot<Real>(out, pending, false);
+    const long steps = params_.steps - step0;
+    pool_steals_per_step_ = steps > 0 ? (double)(pool.steals() - steals0) / steps : 0.0;
+    tcur_ = local_t;
+    steps_done_ = std::max(steps_done_, (long)params_.steps);
+}
+
+template <class Real, class Acc>
+void WavePropagator::run_temporal_blocked(AsyncWriter& out, PerfCounters* pc, PhaseProfiler* prof){
+    const int Lx = net_.Lx();
+    const int Ly = net_.Ly();
+    const int T = params_.tb_steps;
+    const int tile = params_.tile > 0 ? params_.tile : 64;
+    const int ntx = (Lx + tile - 1) / tile;
+    const int nty = (Ly + tile - 1) / tile;
+    const int ntiles = ntx * nty;
+    const Boundary boundary = net_.boundary();
+    const StepCoeffs coeffs{params_.dt, net_.diffusion(), net_.damping()};
+    const int fe = params_.frame_every;
+    const bool frames = params_.dump_frames && fe > 0;
+    // la transmision no corta bloques: sale el ultimo paso de un bloque que
+    // cruza un multiplo de --stream-every
+    const int se = stream_every();
+
+    // energia por sub-paso y por hilo (filas de T rellenas a linea de cache)
+    const int stride = ((T + kPad - 1) / kPad) * kPad;
+    std::vector<double> partial((size_t)omp_get_max_threads() * stride, 0.0);
+    std::vector<SourceTerm> terms(T);
+    init_source();
+    // fuente por nodo: los tiles rotan localmente las fases de source_
+    const bool per_node = params_.noise == NoiseMode::PerNode;
+    const int resync = std::max(1, params_.src_resync);
+    const TileSource tsrc{terms.data(), per_node ? &source_ : nullptr, params_.S0};
+    double local_t = tcur_;
+    PendingSnapshot pending;
+    const int ck_every = params_.checkpoint_every;
+    double t_next = 0.0;   // tiempo al final del bloque actual
+    int it = (int)steps_done_;   // primer paso del bloque actual
+    int teff = 0;      // pasos del bloque actual
 
+    #pragma omp parallel default(none) \
+        shared(Lx, Ly, T, tile, ntx, ntiles, boundary, coeffs, fe, frames, stride, partial, \
+               terms, tsrc, per_node, resync, local_t, pending, ck_every, se, t_next, it, teff, out, pc, prof)
+    {
+        const int tid = omp_get_thread_num();
+        const int nth = omp_get_num_threads();
+        if (pc) pc->openThread(tid);
+        if (prof) prof->begin(tid);
+        auto end_phase = [&](StepPhase ph){
+            if (prof) prof->computeDone(tid);
             #pragma omp barrier
+            if (prof) prof->phaseDone(tid, ph);
+            if (pc) pc->mark(tid, ph);
+        };
+        TileStepper<Real, Acc> stepper;   // buffers locales del hilo, reutilizados entre tiles
+        double* my_e = partial.data() + (size_t)tid * stride;
 
-            #pragma omp single
+        while (it < params_.steps){
+            #pragma omp single nowait
             {
-                if (energy_file){
-                    dump_energy(energy_file, it+1, E_global);
+                // el bloque termina en el siguiente frame pedido para poder volcarlo
+                teff = std::min(T, params_.steps - it);
+                if (frames){
+                    const int next_frame = ((it + fe - 1) / fe) * fe;
+                    teff = std::min(teff, next_frame - it + 1);
                 }
-                if (params_.dump_frames && params_.frame_every>0 && (it % params_.frame_every == 0)){
-                    if (is2D) dump_frame_2d(it);
-                    else dump_frame_1d(it);
+                // ni cruza una renormalizacion de la fuente por nodo ni un checkpoint
+                if (per_node) teff = std::min(teff, resync - it % resync);
+                if (ck_every > 0) teff = std::min(teff, ck_every - it % ck_every);
+                double t = local_t;
+                for (int s=0; s<teff; ++s){
+                    terms[s] = source_term();
+                    t += params_.dt;
+                    if (!per_node) source_.advance(1, t);
                 }
-                if (!is2D){
-                    last_1d_sample_ = last_committed_value;
+                t_next = t;
+            }
+            end_phase(StepPhase::Serial);
+            std::fill(my_e, my_e + teff, 0.0);
+
+            const Real* u = net_.currentAs<Real>();
+            Real* dst = net_.nextAs<Real>();
+
+            #pragma omp for schedule(dynamic, 1) nowait
+            for (int k=0; k<ntiles; ++k){
+                const int tx = k % ntx, ty = k / ntx;
+                const TileRange tr{tx*tile, std::min(Lx, (tx+1)*tile), ty*tile, std::min(Ly, (ty+1)*tile)};
+                if (boundary == Boundary::Periodic)
+                    stepper.template advance<Boundary::Periodic>(u, dst, Lx, Ly, tr, teff, coeffs, tsrc, my_e);
+                else
+                    stepper.template advance<Boundary::Open>(u, dst, Lx, Ly, tr, teff, coeffs, tsrc, my_e);
+            }
+            // los tiles incluyen la energia
+            end_phase(StepPhase::Update);
+
+            // fuente por nodo: las fases pasan al primer paso del bloque siguiente
+            if (per_node){
+                source_.advanceParallelNowait(teff, t_next);
+                end_phase(StepPhase::Source);
+            }
+
+            #pragma omp single nowait
+            {
+                if (per_node) source_.finishParallel(teff);
+                net_.swapBuffers();
+                hand_off_snapshot<Real>(out, pending, true);
+                for (int s=0; s<teff; ++s){
+                    double E = 0.0;
+                    for (int t=0; t<nth; ++t) E += partial[(size_t)t * stride + s];
+                    out.energy(it + s + 1, E);
+                    local_t += params_.dt;
                 }
-                local_t += dt;
-                final_t = local_t;
+                const int last = it + teff - 1;
+                const bool frame_due = frames && (last % fe == 0);
+                const bool ckpt_due = ck_every > 0 && ((last+1) % ck_every == 0);
+                const bool stream_due = se > 0 && (last / se != (it - 1) / se || it == 0);
+                if (frame_due || ckpt_due || stream_due){
+                    pending.frame_step = frame_due ? last : -1;
+                    pending.stream_step = stream_due ? last : -1;
+                    pending.time = local_t;
+                    if (ckpt_due) pending.ckpt = capture_checkpoint(last+1, local_t, last_1d_sample_);
+                }
+                it += teff;
             }
+            end_phase(StepPhase::Serial);
         }
+        if (pc) pc->closeThread(tid);
     }
 
-    tcur_ = final_t;
-    if (energy_file){
-        energy_file.flush();
-    }
+    hand_off_snapshot<Real>(out, pending, false);
+    tcur_ = local_t;
+    steps_done_ = std::max(steps_done_, (long)params_.steps);
 }
@@ -1,26 +1,63 @@
 #pragma once
 
+#include <algorithm>
 #include <fstream>
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
 
 #include "Types.h"
+#include "AsyncWriter.h"
+#include "Checkpoint.h"
+#include "FrameCodec.h"
+#include "FrameFile.h"
+#include "FrameStream.h"
 #include "Network.h"
+#include "PerfCounters.h"
+#include "Profiler.h"
+#include "SourceEngine.h"
+#include "Stencil.h"
+
+class Observables;
 
 class WavePropagator {
 public:
     WavePropagator(Network& net, const RunParams& params);
 
+    // avanza la simulacion en la precision de params_.precision
     void run(const std::string& energy_out);
+    // continua hasta completar `step` pasos (Simulation.h: avance por tramos;
+    // sin el resumen de frames de run())
+    void runTo(long step, const std::string& energy_out);
+    // vuelve al paso 0 (t = 0) con las mismas frecuencias de ruido y cierra los
+    // frames; las amplitudes las repone quien llama
+    void rewind();
 
     double time() const { return tcur_; }
+    long stepsDone() const { return steps_done_; }
+
+    // continua desde un checkpoint: amplitudes, tiempo, paso, frecuencias,
+    // estado del RNG y fases de la fuente (lanza si no coincide con la red)
+    void restore(const CheckpointState& ck);
+
+    // usa las mismas frecuencias de ruido que `o` (corrida de referencia)
+    void copyNoise(const WavePropagator& o);
+    // ademas del archivo, guarda la traza de energia en memoria (nullptr = no)
+    void captureEnergy(std::vector<double>* trace){ energy_trace_ = trace; }
+    // --backend pool: tiles robados por paso en la ultima corrida
+    double poolStealsPerStep() const { return pool_steals_per_step_; }
+    // --stream: frames publicados y descartados (pool de instantaneas lleno)
+    uint64_t streamPublished() const { return stream_.published(); }
+    long streamDropped() const { return stream_dropped_; }
 
 private:
     Network& net_;
     RunParams params_;
     double tcur_ = 0.0;
     double last_1d_sample_ = 0.0;
+    long steps_done_ = 0;             // pasos completados (global, sobrevive a --resume)
+    std::vector<double>* energy_trace_ = nullptr;
 
     std::vector<double> omega_i_;
     int single_idx_ = -1;
@@ -28,8 +65,58 @@ private:
     std::mt19937_64 rng_;
     std::normal_distribution<double> norm_;
 
-    double source_val(int idx, double time) const;
+    SourceEngine source_;             // osciladores de la fuente (recurrencia de rotacion)
+    bool source_ready_ = false;       // source_ ya inicializado (o restaurado)
+
+    void init_source();               // prepara source_ para el modo de ruido en tcur_
+    SourceTerm source_term() const;   // fuente del paso actual a partir de source_
     void dump_energy(std::ofstream& fe, int step, double E);
-    void dump_frame_1d(int step);
-    void dump_frame_2d(int step);
+    FrameWriter frames_;              // results/frames/frames.bin (formato binario)
+    CompressedFrameWriter zframes_;   // results/frames/frames.wfz (formato comprimido)
+    double pool_steals_per_step_ = 0.0;
+    std::vector<double> frame_orig_;  // frame en la numeracion original (grafo reordenado)
+    FrameStream stream_;              // --stream: anillo en memoria compartida
+    long stream_dropped_ = 0;
+
+    void advance(const std::string& energy_out);   // run() segun precision o espectral
+    void open_frames();
+    void dump_frame(int step, double time, const double* amp);   // binario, texto o comprimido segun params_.frame_format
+    void flush_frames();
+    void report_frames() const;       // tasa de compresion y MB/s de frames.wfz
+    void open_stream();
+    void publish_stream(int step, double time, const double* amp);
+    int stream_every() const { return stream_.isOpen() ? std::max(1, params_.stream_every) : 0; }
+    void dump_frame_1d(int step, const double* amp);
+    void dump_frame_2d(int step, const double* amp);
+
+    // Instantanea pedida (frame, checkpoint y/o transmision) cuyo estado sigue
+    // vivo en Network: con el paso fusionado se entrega un paso despues, cuando
+    // quedo en next, intercambiando buffers.
+    struct PendingSnapshot {
+        int frame_step = -1;                   // -1 => sin frame
+        int stream_step = -1;                  // -1 => sin transmision
+        double time = 0.0;
+        std::shared_ptr<CheckpointState> ckpt; // nullptr => sin checkpoint
+    };
+    template <class Real>
+    void hand_off_snapshot(AsyncWriter& out, PendingSnapshot& p, bool in_next);
+    std::shared_ptr<CheckpointState> capture_checkpoint(long step, double time, double last_1d) const;
+    void open_energy(std::ofstream& f, const std::string& path);
+
+    // bucle temporal para almacenamiento Real y aritmetica Acc (f64, f32 o mixto)
+    template <class Real, class Acc>
+    void run_impl(const std::string& energy_out);
+
+    // --backend pool: el paso fusionado repartido en tiles por StealPool
+    template <class Real, class Acc>
+    void run_pool(AsyncWriter& out, Observables* ob);
+
+    // --spectral: estado en los pasos pedidos por FFT y energia por Parseval
+    void run_spectral(const std::string& energy_out);
+
+    // bloqueo temporal 2D: avanza tiles varios pasos seguidos en cache
+    template <class Real, class Acc>
+    void run_temporal_blocked(AsyncWriter& out, PerfCounters* pc, PhaseProfiler* prof);
+    // resumen de --perf-counters / --profile al final de run() (nullptr = desactivado)
+    void report_profiles(const PerfCounters* pc, const PhaseProfiler* prof, long steps) const;
 };
@@ -9,134 +9,172 @@
 
 #include "Types.h"
 #include "Network.h"
+#include "Checkpoint.h"
+#include "Numa.h"
+#include "Autotune.h"
+#include "Ensemble.h"
+#include "Options.h"
+#include "Simulation.h"
 #include "WavePropagator.h"
 #include "Benchmark.h"
+#ifdef WAVE_HAVE_MPI
+#include <mpi.h>
+#include "DistributedPropagator.h"
+#endif
 
-static void usage(){
-    std::cout << "Uso: ./wave_propagation [opciones]\n"
-              << "  --network {1d,2d}\n"
-              << "  --N <int> | --Lx <int> --Ly <int>\n"
-              << "  --D <double> --gamma <double> --dt <double>\n"
-              << "  --steps <int>\n"
-              << "  --S0 <double> --omega <double>\n"
-              << "  --noise {off,global,pernode,single}\n"
-              << "  --omega-mu <double> --omega-sigma <double> --noise-node <int>\n"
-              << "  --schedule {static,dynamic,guided} --chunk <n|auto>\n"
-              << "  --threads <int>\n"
-              << "  --taskloop --grain <int>\n"
-              << "  --energy-accum {reduction,atomic,critical}\n"
-              << "  --collapse2\n"
-              << "  --dump-frames --frame-every <int>\n"
-              << "  --benchmark\n";
-}
-
-static ScheduleType parse_schedule(const std::string& s){
-    if (s=="static") return ScheduleType::Static;
-    if (s=="dynamic") return ScheduleType::Dynamic;
-    if (s=="guided")  return ScheduleType::Guided;
-    throw std::runtime_error("schedule invalido");
-}
-
-static NoiseMode parse_noise(const std::string& s){
-    if (s=="off") return NoiseMode::Off;
-    if (s=="global") return NoiseMode::Global;
-    if (s=="pernode") return NoiseMode::PerNode;
-    if (s=="single") return NoiseMode::Single;
-    throw std::runtime_error("noise invalido");
-}
+#ifdef WAVE_HAVE_MPI
+// Binario MPI: cada rank simula su franja de la red (DistributedPropagator.h)
+static void run_distributed(const RunParams& params){
+    if (params.do_bench || params.do_microbench || !params.resume.empty() || params.checkpoint_every > 0 ||
+        params.accuracy_report || params.numa_report || params.perf_counters || params.profile || !params.ensemble.empty() ||
+        !params.observe.empty() || !params.probes.empty() || params.active || params.network == "graph" || params.spectral ||
+        params.backend == Backend::Pool || params.bench_backends || !params.stream.empty())
+        throw std::runtime_error("--benchmark, --microbench, --checkpoint-every, --resume, --accuracy-report, --numa-report, --perf-counters, --profile, --ensemble, --observe, --probe, --active-region, --network graph, --spectral, --backend pool, --bench-backends y --stream no estan disponibles con MPI");
+    if (params.tb_steps > 1 || params.kernel == KernelType::Csr)
+        throw std::runtime_error("con MPI solo esta el stencil paso a paso (sin --temporal-block ni --kernel csr)");
+    if (params.dump_frames && params.frame_format != FrameFormat::Binary)
+        throw std::runtime_error("con MPI los frames solo se escriben en formato bin");
 
-static EnergyAccum parse_energy_accum(const std::string& s){
-    if (s=="reduction") return EnergyAccum::Reduction;
-    if (s=="atomic") return EnergyAccum::Atomic;
-    if (s=="critical") return EnergyAccum::Critical;
-    throw std::runtime_error("energy-accum invalido");
+    DistributedPropagator dp(params, MPI_COMM_WORLD);
+    if (dp.rank() == 0)
+        std::cout << "[mpi] " << dp.ranks() << " ranks x " << omp_get_max_threads() << " hilos\n";
+    MPI_Barrier(MPI_COMM_WORLD);
+    const double t0 = MPI_Wtime();
+    dp.run(params.energy_out);
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (dp.rank() == 0){
+        std::cout << "[mpi] tiempo de simulacion: " << MPI_Wtime() - t0 << " s\n";
+        std::cout << "OK. Resultados en results/\n";
+    }
 }
+#endif
 
-static RunParams parse_args(int argc, char** argv){
-    RunParams params;
-    for (int i=1;i<argc;++i){
-        std::string k = argv[i];
-        auto next = [&](const char* err){
-            if (i+1>=argc){
-                usage();
-                throw std::runtime_error(err);
-            }
-            return std::string(argv[++i]);
-        };
-        if (k=="--network") params.network = next("--network <1d|2d>");
-        else if (k=="--N") params.N = std::stoi(next("--N <int>"));
-        else if (k=="--Lx") params.Lx = std::stoi(next("--Lx <int>"));
-        else if (k=="--Ly") params.Ly = std::stoi(next("--Ly <int>"));
-        else if (k=="--D") params.D = std::stod(next("--D <double>"));
-        else if (k=="--gamma") params.gamma = std::stod(next("--gamma <double>"));
-        else if (k=="--dt") params.dt = std::stod(next("--dt <double>"));
-        else if (k=="--steps") params.steps = std::stoi(next("--steps <int>"));
-        else if (k=="--S0") params.S0 = std::stod(next("--S0 <double>"));
-        else if (k=="--omega") params.omega = std::stod(next("--omega <double>"));
-        else if (k=="--noise") params.noise = parse_noise(next("--noise <off|global|pernode|single>"));
-        else if (k=="--omega-mu") params.omega_mu = std::stod(next("--omega-mu <double>"));
-        else if (k=="--omega-sigma") params.omega_sigma = std::stod(next("--omega-sigma <double>"));
-        else if (k=="--noise-node") params.noise_node = std::stoi(next("--noise-node <int>"));
-        else if (k=="--schedule") params.schedule = parse_schedule(next("--schedule <static|dynamic|guided>"));
-        else if (k=="--chunk"){
-            std::string v = next("--chunk <n|auto>");
-            if (v=="auto") params.chunk_auto = true;
-            else params.chunk = std::stoi(v);
+int main(int argc, char** argv){
+#ifdef WAVE_HAVE_MPI
+    int provided = 0;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);   // MPI solo desde el hilo maestro
+#endif
+    try {
+        RunParams params;
+        try {
+            params = parse_args(argc, argv);
+        } catch (const std::exception&){
+            usage();
+            throw;
         }
-        else if (k=="--threads") params.threads = std::stoi(next("--threads <int>"));
-        else if (k=="--taskloop") params.taskloop = true;
-        else if (k=="--grain") params.grain = std::stoi(next("--grain <int>"));
-        else if (k=="--energy-accum") params.energyAccum = parse_energy_accum(next("--energy-accum <reduction|atomic|critical>"));
-        else if (k=="--collapse2") params.collapse2 = true;
-        else if (k=="--dump-frames") params.dump_frames = true;
-        else if (k=="--frame-every") params.frame_every = std::stoi(next("--frame-every <int>"));
-        else if (k=="--benchmark") params.do_bench = true;
-        else if (k=="--help" || k=="-h"){ usage(); std::exit(0); }
-        else {
+        if (params.help){
             usage();
-            throw std::runtime_error("Opcion desconocida: " + k);
+#ifdef WAVE_HAVE_MPI
+            MPI_Finalize();
+#endif
+            return 0;
         }
-    }
-    return params;
-}
 
-static int compute_auto_chunk(int N, ScheduleType st, int p){
-    if (N<=0) return 64;
-    if (st==ScheduleType::Dynamic) return 256;
-    if (st==ScheduleType::Guided)  return 64;
-    int c = std::max(64, N/std::max(1,p*8));
-    c = (c/8)*8;
-    return std::min(std::max(c,64),8192);
-}
-
-int main(int argc, char** argv){
-    try {
-        RunParams params = parse_args(argc, argv);
+        // Continuacion: la configuracion fisica sale del checkpoint; desde la
+        // linea de comandos solo se cambian hilos, --steps y los checkpoints
+        CheckpointState ckpt;
+        if (!params.resume.empty()){
+            ckpt = load_checkpoint(params.resume);
+            const RunParams cli = params;
+            params = ckpt.params;
+            if (cli.threads_set) params.threads = cli.threads;
+            if (cli.steps_set) params.steps = cli.steps;
+            params.checkpoint_every = cli.checkpoint_every;
+            params.checkpoint_path = cli.checkpoint_path;
+            params.resume = cli.resume;
+            params.accuracy_report = cli.accuracy_report;
+            params.pin = cli.pin;
+            params.numa_report = cli.numa_report;
+            params.perf_counters = cli.perf_counters;
+            params.profile = cli.profile;
+            params.profile_steps = cli.profile_steps;
+            params.tune_cache = cli.tune_cache;
+            params.retune = cli.retune;
+            params.observe = cli.observe;
+            params.probes = cli.probes;
+            params.active = cli.active;
+            params.active_tol = cli.active_tol;
+            params.graph_report = cli.graph_report;
+            params.spectral = cli.spectral;
+            params.spectral_every = cli.spectral_every;
+            params.backend = cli.backend;
+            params.pool_spin = cli.pool_spin;
+            params.stream = cli.stream;
+            params.stream_every = cli.stream_every;
+            params.stream_slots = cli.stream_slots;
+            params.stream_dtype = cli.stream_dtype;
+            params.frame_threads = cli.frame_threads;
+            params.do_bench = false;
+        }
+        apply_simd(params.simd);
 
         std::filesystem::create_directories("results");
         if (params.dump_frames){
             std::filesystem::create_directories("results/frames");
         }
 
-        // Construcción de red (solo 1D/2D)
-        Network net = (params.network=="1d")
-            ? Network(params.N, params.D, params.gamma)
-            : Network(params.Lx, params.Ly, params.D, params.gamma);
-        if (params.network=="1d") net.makeRegular1D(false);
-        else                       net.makeRegular2D(false);
-
-        // Estado inicial
-        net.setAll(0.0);
-        net.setInitialImpulseCenter(1.0);
-
+        // Hilos, afinidad y chunk antes de construir la red: la primera
+        // escritura de las amplitudes usa los mismos hilos y el mismo reparto
         if (params.threads>0) omp_set_num_threads(params.threads);
+        pin_threads(params.pin);
+
+        // Grafo cargado: renumeracion (RCM) y tramos del tamano de la cache
+        // antes de construir la red; el informe compara el orden del archivo
+        // con el que se simula
+        const NetworkBuilder builder(params, params.graph_report ? &std::cout : nullptr);
+        const bool is_graph = builder.isGraph();
 
-        if (params.chunk_auto){
+        // --chunk auto en una simulacion: autotuner con la red ya construida
+#ifdef WAVE_HAVE_MPI
+        const bool tune = false;
+#else
+        // (con --active-region no: mide barridos de la grilla completa; con un
+        // grafo tampoco: solo conoce el stencil y el CSR de las grillas; con
+        // --spectral no hay barridos)
+        const bool tune = params.chunk_auto && !params.do_bench && !params.do_microbench && !params.active && !is_graph && !params.spectral;
+#endif
+        if (params.chunk_auto && !tune){
             int p = (params.threads>0) ? params.threads : omp_get_max_threads();
-            params.chunk = compute_auto_chunk(net.size(), params.schedule, p);
+            params.chunk = compute_auto_chunk(builder.nodes(), params.schedule, p);
             std::cout << "[auto-chunk] " << params.chunk << "\n";
         }
+        // con schedule static el kernel reparte bloques de chunk filas/nodos en
+        // round-robin; con dynamic/guided no hay reparto fijo: un bloque por hilo
+        // (con --partition el reparto es por tramos: un bloque contiguo por hilo)
+        const int touch_chunk = params.schedule == ScheduleType::Static && !builder.partitioned() ? params.chunk : 0;
+
+#ifdef WAVE_HAVE_MPI
+        run_distributed(params);
+        MPI_Finalize();
+        return 0;
+#endif
+
+        // Ensamble: cada miembro tiene su propio estado, no se construye la red comun
+        if (!params.ensemble.empty()){
+            if (params.precision != Precision::F64 || params.tb_steps > 1 || !params.resume.empty() ||
+                params.checkpoint_every > 0 || params.dump_frames || params.do_bench || params.do_microbench ||
+                params.accuracy_report || params.perf_counters || params.profile ||
+                !params.observe.empty() || !params.probes.empty() || params.active || is_graph || params.spectral ||
+                params.backend == Backend::Pool || params.bench_backends || !params.stream.empty())
+                throw std::runtime_error("--ensemble solo admite grillas 1D/2D en f64 paso a paso con OpenMP, sin frames, checkpoints, benchmarks, perfiles, observables, region activa ni stream");
+            EnsemblePropagator ens(params, load_sweep(params.ensemble, params));
+            ens.run(params.ensemble_out, std::cout);
+            std::cout << "OK. Resultados en " << params.ensemble_out << "/\n";
+            return 0;
+        }
+
+        // Construcción de red y estado inicial (impulso en el centro)
+        auto make_network = [&]{ return builder.make(touch_chunk); };
+        const double t_build = omp_get_wtime();
+        Network net = make_network();
+        if (tune) autotune(net, params, std::cout);
+        if (params.numa_report){
+            std::cout << "[numa] construccion e inicializacion: " << omp_get_wtime() - t_build << " s\n";
+            numa_report(net, std::cout);
+        }
 
+        if (is_graph && (params.do_bench || params.do_microbench || params.bench_backends))
+            throw std::runtime_error("--benchmark, --microbench y --bench-backends solo miden grillas 1D/2D");
         if (params.do_bench){
             std::vector<int> plist = {1,2,4,8};
             Benchmark::run_scaling(net, params.steps, params.schedule, params.chunk,
@@ -148,11 +186,72 @@ int main(int argc, char** argv){
             return 0;
         }
 
+        if (params.do_microbench){
+            Benchmark::run_kernels(net, params, "results/microbench");
+            return 0;
+        }
+        if (params.bench_backends){
+            Benchmark::run_backends(net, params, "results/backends.dat");
+            return 0;
+        }
+
+        // --spectral con --accuracy-report: la referencia es la corrida paso a
+        // paso y se compara la energia de cada paso
+        if (params.spectral && params.accuracy_report) params.spectral_every = 1;
         WavePropagator wp(net, params);
+        if (!params.resume.empty()){
+            wp.restore(ckpt);
+            std::cout << "[resume] paso " << wp.stepsDone() << " de " << params.steps << "\n";
+        }
+        const long first_step = wp.stepsDone();
+        std::vector<double> trace;
+        if (params.accuracy_report) wp.captureEnergy(&trace);
+        const double t0 = omp_get_wtime();
         wp.run(params.energy_out);
+        const double t_run = omp_get_wtime() - t0;
+        if (params.numa_report){
+            // con frames/checkpoints/stream el estado final esta en buffers del pool de instantaneas
+            std::cout << "[numa] despues de la corrida:\n";
+            numa_report(net, std::cout);
+        }
+        if (params.backend == Backend::Pool)
+            std::cout << "[pool] " << omp_get_max_threads() << " trabajadores, robos por paso: "
+                      << wp.poolStealsPerStep() << "\n";
+        if (!params.stream.empty())
+            std::cout << "[stream] frames publicados: " << wp.streamPublished()
+                      << ", descartados (pool de instantaneas lleno): " << wp.streamDropped() << "\n";
+
+        if (params.accuracy_report){
+            // referencia double con la misma configuracion y las mismas frecuencias, sin salida a disco
+            RunParams ref_params = params;
+            ref_params.precision = Precision::F64;
+            ref_params.spectral = false;
+            ref_params.dump_frames = false;
+            ref_params.checkpoint_every = 0;
+            ref_params.perf_counters = false;
+            ref_params.profile = false;
+            ref_params.energy_out.clear();
+            ref_params.stream.clear();
+            ref_params.observe.clear();
+            ref_params.probes.clear();
+            Network ref_net = make_network();
+            WavePropagator ref(ref_net, ref_params);
+            ref.copyNoise(wp);
+            if (!params.resume.empty()) ref.restore(ckpt);
+            std::vector<double> ref_trace;
+            ref.captureEnergy(&ref_trace);
+            const double t1 = omp_get_wtime();
+            ref.run(ref_params.energy_out);
+            const double t_ref = omp_get_wtime() - t1;
+            Benchmark::accuracy_report(trace, ref_trace, first_step, params.precision, t_run, t_ref,
+                                       "results/accuracy_report.dat");
+        }
         std::cout << "OK. Resultados en results/\n";
     } catch (const std::exception& e){
         std::cerr << "Error: " << e.what() << "\n";
+#ifdef WAVE_HAVE_MPI
+        MPI_Abort(MPI_COMM_WORLD, 1);
+#endif
         return 1;
     }
     return 0;
@@ -9,6 +9,13 @@ Genera:
   results/speedup_<network>_<schedule>.png
   results/time_vs_chunk_dynamic_2d.png
   results/time_vs_chunk_dynamic_1d.png
+Si existe results/perf_counters.csv (--perf-counters, PERF_COUNTERS=1 make matrix):
+  resumen de IPC y fallos de LLC/dTLB por fase en consola
+  results/perf_ipc_<network>_<size>.png      (IPC del barrido vs hilos)
+  results/perf_phases_<network>_<size>.png   (ciclos por nodo y paso de cada fase)
+Si existe results/profile_summary.csv (--profile, PROFILE=1 make matrix):
+  espera y desbalance del barrido por configuracion en consola
+  results/imbalance_<network>_<size>.png     (desbalance por paso vs chunk, por schedule y p)
 """
 
 import os, csv
@@ -16,6 +23,9 @@ import matplotlib.pyplot as plt
 
 RESULTS_DIR = "results"
 CSV_PATH = os.path.join(RESULTS_DIR, "matrix_results.csv")
+PERF_PATH = os.path.join(RESULTS_DIR, "perf_counters.csv")
+PROFILE_PATH = os.path.join(RESULTS_DIR, "profile_summary.csv")
+PHASES = ["update", "energy", "commit", "source", "serial"]
 
 # -------- Helpers comunes --------
 def chunk_sort_key(x):
@@ -155,7 +165,135 @@ def run_without_pandas():
         plt.savefig(out, dpi=150, bbox_inches="tight"); plt.close()
         print(f"[plot] {out}")
 
+# ================== Contadores de hardware ==================
+def to_float(x):
+    try:
+        return float(x)
+    except (TypeError, ValueError):
+        return None  # contador no disponible (campo vacio)
+
+def analyze_perf():
+    """Filas 'all' (suma de hilos) de perf_counters.csv; con varias corridas
+    de la misma configuracion queda la ultima."""
+    if not os.path.exists(PERF_PATH):
+        return
+    last = {}
+    with open(PERF_PATH, newline="") as f:
+        for r in csv.DictReader(f):
+            if r["thread"] != "all":
+                continue
+            key = (r["network"], r["size"], r["schedule"], r["chunk"], int(r["threads"]), r["precision"])
+            last.setdefault(key, {})[r["phase"]] = r
+    if not last:
+        return
+
+    print("[perf] red      tamano     schedule chunk  p  fase     IPC  LLC/kinstr dTLB/kinstr ciclos/(nodo*paso)")
+    for key in sorted(last, key=lambda k: (k[0], k[1], k[2], chunk_sort_key(k[3]), k[4])):
+        net, size, sch, chunk, p, prec = key
+        for ph in PHASES + ["total"]:
+            r = last[key].get(ph)
+            if r is None or to_float(r["cycles"]) in (None, 0.0):
+                continue
+            print(f"[perf] {net:<4} {size:>12} {sch:>8} {chunk:>5} {p:>2}  {ph:<7}"
+                  f" {r['ipc']:>5} {r['llc_per_kinst']:>11} {r['dtlb_per_kinst']:>11} {r['cycles_per_node_step']:>12}")
+
+    # IPC del barrido vs hilos (mejor chunk = menos ciclos por nodo y paso)
+    groups = {}
+    for (net, size, sch, chunk, p, prec), phases in last.items():
+        if "update" not in phases or "total" not in phases:
+            continue
+        cpn = to_float(phases["total"]["cycles_per_node_step"])
+        ipc = to_float(phases["update"]["ipc"])
+        if cpn is None or ipc is None:
+            continue
+        g = groups.setdefault((net, size), {}).setdefault(sch, {})
+        if p not in g or cpn < g[p][0]:
+            g[p] = (cpn, ipc, phases)
+    for (net, size), by_sched in sorted(groups.items()):
+        plt.figure()
+        for sch, by_p in sorted(by_sched.items()):
+            ps = sorted(by_p)
+            plt.plot(ps, [by_p[p][1] for p in ps], marker="o", label=sch)
+        plt.xlabel("Hilos (p)"); plt.ylabel("IPC (fase update)")
+        plt.title(f"IPC del barrido — {net.upper()} {size}")
+        plt.grid(True, alpha=0.3); plt.legend()
+        out = os.path.join(RESULTS_DIR, f"perf_ipc_{net}_{size}.png")
+        plt.savefig(out, dpi=150, bbox_inches="tight"); plt.close()
+        print(f"[plot] {out}")
+
+        # ciclos por nodo y paso de cada fase (barras apiladas, un grupo por schedule/p)
+        cols = [(sch, p) for sch, by_p in sorted(by_sched.items()) for p in sorted(by_p)]
+        plt.figure(figsize=(max(6, 0.5 * len(cols)), 4))
+        bottoms = [0.0] * len(cols)
+        for ph in PHASES:
+            vals = []
+            for sch, p in cols:
+                r = by_sched[sch][p][2].get(ph)
+                v = to_float(r["cycles_per_node_step"]) if r else None
+                vals.append(v or 0.0)
+            plt.bar(range(len(cols)), vals, bottom=bottoms, label=ph)
+            bottoms = [b + v for b, v in zip(bottoms, vals)]
+        labels = [f"{sch[:3]} p={p}" for sch, p in cols]
+        plt.xticks(range(len(cols)), labels, rotation=45, ha="right")
+        plt.ylabel("Ciclos / (nodo * paso)")
+        plt.title(f"Ciclos por fase — {net.upper()} {size}")
+        plt.legend(fontsize=8)
+        out = os.path.join(RESULTS_DIR, f"perf_phases_{net}_{size}.png")
+        plt.savefig(out, dpi=150, bbox_inches="tight"); plt.close()
+        print(f"[plot] {out}")
+
+# ================== Perfil de fases (--profile) ==================
+def analyze_profile():
+    """Filas 'all' de profile_summary.csv; desbalance = max/media - 1 del
+    computo de los hilos (por paso: promedio de los pasos de la linea de tiempo)."""
+    if not os.path.exists(PROFILE_PATH):
+        return
+    last = {}
+    with open(PROFILE_PATH, newline="") as f:
+        for r in csv.DictReader(f):
+            if r["thread"] != "all":
+                continue
+            key = (r["network"], r["size"], r["schedule"], r["chunk"], int(r["threads"]), r["precision"])
+            last.setdefault(key, {})[r["phase"]] = r
+    if not last:
+        return
+
+    print("[profile] red      tamano     schedule chunk  p  espera%  desbalance  por paso  (fase update)")
+    groups = {}
+    for key in sorted(last, key=lambda k: (k[0], k[1], k[2], chunk_sort_key(k[3]), k[4])):
+        net, size, sch, chunk, p, prec = key
+        r = last[key].get("update")
+        if r is None:
+            continue
+        c, w = float(r["compute_s"]), float(r["wait_s"])
+        wait_pct = 100.0 * w / (c + w) if c + w > 0 else 0.0
+        imb = to_float(r["imbalance"]) or 0.0
+        step_imb = to_float(r["step_imbalance"])
+        print(f"[profile] {net:<4} {size:>12} {sch:>8} {chunk:>5} {p:>2}  {wait_pct:6.1f}%  {imb:10.3f}"
+              f"  {'' if step_imb is None else f'{step_imb:8.3f}'}")
+        if p > 1:
+            groups.setdefault((net, size), {}).setdefault((sch, p), []).append(
+                (chunk, imb if step_imb is None else step_imb))
+
+    for (net, size), series in sorted(groups.items()):
+        plt.figure()
+        for (sch, p), pts in sorted(series.items()):
+            pts = sorted(pts, key=lambda x: chunk_sort_key(x[0]))
+            plt.plot([c for c, _ in pts], [v for _, v in pts], marker="o", label=f"{sch} p={p}")
+        plt.xlabel("Chunk"); plt.ylabel("Desbalance (max/media - 1)")
+        plt.title(f"Desbalance del barrido — {net.upper()} {size}")
+        plt.grid(True, alpha=0.3); plt.legend(fontsize=8)
+        out = os.path.join(RESULTS_DIR, f"imbalance_{net}_{size}.png")
+        plt.savefig(out, dpi=150, bbox_inches="tight"); plt.close()
+        print(f"[plot] {out}")
+
 def main():
+    if not os.path.exists(CSV_PATH) and (os.path.exists(PERF_PATH) or os.path.exists(PROFILE_PATH)):
+        # solo perfiles (corridas sueltas con --perf-counters / --profile)
+        analyze_perf()
+        analyze_profile()
+        print("[analyze_matrix] Hecho.")
+        return
     ensure_csv_exists()
     try:
         import pandas  # noqa
@@ -163,6 +301,8 @@ def main():
     except Exception as e:
         print(f"[analyze_matrix] pandas no disponible o falló ({e}). Usando modo sin pandas.")
         run_without_pandas()
+    analyze_perf()
+    analyze_profile()
     print("[analyze_matrix] Hecho.")
 
 if __name__ == "__main__":
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""
+Compara wave_propagation_mpi (mpirun -np P) con la corrida de un proceso.
+Cada caso corre en un directorio temporal; frames.bin debe ser identico byte
+a byte. La energia en 2D con Ly multiplo de P se compara contra la corrida de
+P hilos con --schedule static --chunk Ly/P (misma suma, identica); en el resto
+se acepta una diferencia relativa de redondeo.
+
+Uso: python3 scripts/check_mpi.py [--np 4] [--mpirun "mpirun --oversubscribe"]
+"""
+
+import argparse, os, shlex, subprocess, sys, tempfile
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parents[1]
+BIN = str(ROOT / "wave_propagation")
+BIN_MPI = str(ROOT / "wave_propagation_mpi")
+
+BASE = ["--steps", "80", "--dt", "0.05", "--D", "0.1", "--gamma", "0.01",
+        "--omega-sigma", "0", "--dump-frames", "--frame-every", "10"]
+
+CASES = [
+    ["--network", "2d", "--Lx", "96", "--Ly", "64"],
+    ["--network", "2d", "--Lx", "96", "--Ly", "64", "--periodic", "--noise", "pernode", "--S0", "1"],
+    ["--network", "2d", "--Lx", "50", "--Ly", "37", "--noise", "single", "--S0", "2"],
+    ["--network", "2d", "--Lx", "64", "--Ly", "64", "--periodic", "--noise", "global", "--S0", "1", "--omega", "3"],
+    ["--network", "2d", "--Lx", "64", "--Ly", "64", "--precision", "f32", "--noise", "pernode", "--S0", "1"],
+    ["--network", "2d", "--Lx", "64", "--Ly", "64", "--precision", "mixed", "--periodic"],
+    ["--network", "1d", "--N", "5000", "--noise", "pernode", "--S0", "1"],
+    ["--network", "1d", "--N", "4001", "--periodic", "--noise", "single", "--S0", "2"],
+]
+
+
+def opt(case, key, default=None):
+    return case[case.index(key) + 1] if key in case else default
+
+
+def run(cmd, cwd, env=None):
+    r = subprocess.run(cmd, cwd=cwd, env=env, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if r.returncode != 0:
+        print(r.stdout)
+        raise SystemExit("fallo: " + " ".join(cmd))
+
+
+def energy(path):
+    vals = []
+    with open(path) as f:
+        for line in f:
+            if line.startswith("#") or not line.strip():
+                continue
+            vals.append(float(line.split()[1]))
+    return vals
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--np", type=int, default=4)
+    ap.add_argument("--mpirun", default="mpirun --oversubscribe" + (" --allow-run-as-root" if os.geteuid() == 0 else ""))
+    args = ap.parse_args()
+    P = args.np
+
+    failed = 0
+    for case in CASES:
+        ly = int(opt(case, "--Ly", "0"))
+        exact_energy = opt(case, "--network") == "2d" and ly % P == 0
+        ref = ["--threads", str(P), "--schedule", "static", "--chunk", str(ly // P)] if exact_energy else ["--threads", "1"]
+        with tempfile.TemporaryDirectory() as a, tempfile.TemporaryDirectory() as b:
+            run([BIN] + BASE + case + ref, a)
+            env = dict(os.environ, OMP_NUM_THREADS="1")
+            run(shlex.split(args.mpirun) + ["-np", str(P), BIN_MPI] + BASE + case, b, env)
+            fa = Path(a, "results/frames/frames.bin").read_bytes()
+            fb = Path(b, "results/frames/frames.bin").read_bytes()
+            ea = energy(Path(a, "results/energy_trace.dat"))
+            eb = energy(Path(b, "results/energy_trace.dat"))
+            rel = max((abs(x - y) / max(abs(x), 1e-300) for x, y in zip(ea, eb)), default=0.0)
+            ok = fa == fb and len(ea) == len(eb) and (rel == 0.0 if exact_energy else rel < 1e-10)
+            failed += not ok
+            print(("OK   " if ok else "FAIL ") + " ".join(case)
+                  + f"  frames {'iguales' if fa == fb else 'DISTINTOS'}, energia max rel {rel:.2e}"
+                  + (" (suma exacta)" if exact_energy else ""))
+    print(f"{len(CASES) - failed}/{len(CASES)} casos con -np {P}")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
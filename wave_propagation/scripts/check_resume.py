@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""
+Comprueba --resume: una corrida cortada en un checkpoint y continuada debe dar
+la misma traza de energia y los mismos frames que la corrida de un tiron.
+Incluye continuar con --steps igual al valor por defecto (200), que antes se
+confundia con "sin --steps", y continuar sin --steps (se queda en los pasos
+del checkpoint).
+
+Uso: python3 scripts/check_resume.py
+"""
+
+import subprocess, sys, tempfile
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parents[1]
+BIN = str(ROOT / "wave_propagation")
+
+NET = ["--network", "2d", "--Lx", "64", "--Ly", "48", "--noise", "global", "--S0", "1", "--omega", "3",
+       "--dump-frames", "--frame-every", "10"]
+
+# (pasos de la primera corrida, opciones al continuar, pasos esperados al final)
+CASES = [
+    (100, ["--steps", "200"], 200),
+    (100, ["--steps", "250"], 250),
+    (120, ["--steps", "200", "--threads", "1"], 200),
+    (100, [], 100),
+]
+
+
+def run(cmd, cwd):
+    r = subprocess.run(cmd, cwd=cwd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if r.returncode != 0:
+        print(r.stdout)
+        raise SystemExit("fallo: " + " ".join(cmd))
+    return r.stdout
+
+
+def main():
+    failed = 0
+    for first, extra, total in CASES:
+        with tempfile.TemporaryDirectory() as a, tempfile.TemporaryDirectory() as b:
+            run([BIN] + NET + ["--steps", str(total)], a)
+            run([BIN] + NET + ["--steps", str(first), "--checkpoint-every", str(first)], b)
+            out = run([BIN, "--resume", "results/checkpoint.bin"] + extra, b)
+            same = all(Path(a, f).read_bytes() == Path(b, f).read_bytes()
+                       for f in ("results/energy_trace.dat", "results/frames/frames.bin"))
+            ok = same and f"de {total}" in out
+            failed += not ok
+            print(("OK   " if ok else "FAIL ") + f"corte en {first}, --resume {' '.join(extra) or '(sin opciones)'}"
+                  + f" -> {total} pasos" + ("" if same else ", energia/frames DISTINTOS"))
+    print(f"{len(CASES) - failed}/{len(CASES)} casos")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""
+Decodificador de frames comprimidos (--frame-format compressed; FrameCodec.h)
+de results/frames/frames.wfz.
+
+Uso:
+  python3 scripts/frame_codec.py results/frames/frames.wfz            # resumen por frame
+  python3 scripts/frame_codec.py results/frames/frames.wfz --check results/frames/frames.bin
+
+Como modulo: CompressedFrames(path) se indexa como BinaryFrames de
+make_video.py: frames[k] devuelve la matriz (vector en 1D) del frame k,
+frames.step(k) su paso. Un frame delta se reconstruye desde el frame clave
+anterior; el acceso en orden reutiliza el frame previo. Requiere numpy.
+"""
+
+import argparse, struct, sys
+from pathlib import Path
+
+import numpy as np
+
+MAGIC = b"WAVEFRZ1"
+HEADER = 64
+FRAME_HEADER = 32
+
+
+def lz_decompress(src, size):
+    """Inverso de lz_compress (FrameCodec.cpp): size bytes descomprimidos."""
+    out = bytearray()
+    ip, n = 0, len(src)
+    while ip < n:
+        token = src[ip]
+        ip += 1
+        lit = token >> 4
+        if lit == 15:
+            while True:
+                b = src[ip]
+                ip += 1
+                lit += b
+                if b != 255:
+                    break
+        out += src[ip:ip + lit]
+        ip += lit
+        if ip >= n:
+            break   # ultima secuencia: solo literales
+        off = src[ip] | (src[ip + 1] << 8)
+        ip += 2
+        mlen = token & 15
+        if mlen == 15:
+            while True:
+                b = src[ip]
+                ip += 1
+                mlen += b
+                if b != 255:
+                    break
+        mlen += 4
+        start = len(out) - off
+        if off >= mlen:
+            out += out[start:start + mlen]
+        else:
+            # match que se solapa consigo mismo: el patron de `off` bytes se repite
+            pat = bytes(out[start:])
+            out += (pat * (mlen // off + 1))[:mlen]
+    if len(out) != size:
+        raise ValueError("bloque LZ corrupto (%d bytes, se esperaban %d)" % (len(out), size))
+    return bytes(out)
+
+
+class CompressedFrames:
+    def __init__(self, path):
+        self.path = Path(path)
+        with open(self.path, "rb") as f:
+            self.data = f.read()
+        if self.data[:8] != MAGIC:
+            raise ValueError(f"{self.path.name} no es un archivo de frames comprimidos")
+        (version, self.word_size, self.nx, self.ny, self.tol, self.keyframe,
+         self.block_elems, self.value_size) = struct.unpack_from("<IIIIdIII", self.data, 8)
+        if version != 1:
+            raise ValueError(f"version de frames no soportada: {version}")
+        self.n = self.nx * self.ny
+        # indice de frames: (offset, step, time, delta); uno incompleto al final se ignora
+        self.index = []
+        off = HEADER
+        while off + FRAME_HEADER <= len(self.data):
+            step, t, flags, nblocks, payload = struct.unpack_from("<qdIIQ", self.data, off)
+            if off + FRAME_HEADER + payload > len(self.data):
+                break
+            self.index.append((off, step, t, bool(flags & 1)))
+            off += FRAME_HEADER + payload
+        self._last = None   # (k, palabras) del ultimo frame decodificado
+
+    def __len__(self):
+        return len(self.index)
+
+    def step(self, k):
+        return self.index[k][1]
+
+    def time(self, k):
+        return self.index[k][2]
+
+    @property
+    def is_1d(self):
+        return self.ny == 1
+
+    def _residuals(self, k):
+        off = self.index[k][0]
+        nblocks = struct.unpack_from("<I", self.data, off + 20)[0]
+        sizes = struct.unpack_from("<%dI" % nblocks, self.data, off + FRAME_HEADER)
+        pos = off + FRAME_HEADER + 4 * nblocks
+        wtype = np.uint32 if self.word_size == 4 else np.uint64
+        res = np.empty(self.n, dtype=wtype)
+        for b, size in enumerate(sizes):
+            i0 = b * self.block_elems
+            cnt = min(self.n, i0 + self.block_elems) - i0
+            raw = lz_decompress(self.data[pos:pos + size], cnt * self.word_size)
+            pos += size
+            # planos de bytes -> palabras little-endian
+            planes = np.frombuffer(raw, dtype=np.uint8).reshape(self.word_size, cnt)
+            res[i0:i0 + cnt] = np.ascontiguousarray(planes.T).view("<u%d" % self.word_size).ravel()
+        return res
+
+    def _words(self, k):
+        if self._last is not None and self._last[0] == k:
+            return self._last[1]
+        delta = self.index[k][3]
+        res = self._residuals(k)
+        quant = self.tol > 0
+        if delta:
+            prev = self._words(k - 1)
+            if quant:
+                # zigzag -> diferencia con signo, acumulada sobre el frame anterior
+                d = (res >> np.uint64(1)).astype(np.int64) ^ -(res & np.uint64(1)).astype(np.int64)
+                words = prev + d
+            else:
+                words = prev ^ res
+        else:
+            words = np.empty_like(res, dtype=np.int64 if quant else res.dtype)
+            for i0 in range(0, self.n, self.block_elems):
+                r = res[i0:i0 + self.block_elems]
+                if quant:
+                    d = (r >> np.uint64(1)).astype(np.int64) ^ -(r & np.uint64(1)).astype(np.int64)
+                    words[i0:i0 + len(r)] = np.cumsum(d)
+                else:
+                    words[i0:i0 + len(r)] = np.bitwise_xor.accumulate(r)
+        self._last = (k, words)
+        return words
+
+    def __getitem__(self, k):
+        if k < 0:
+            k += len(self)
+        words = self._words(k)
+        if self.tol > 0:
+            a = words.astype(np.float64) * (2.0 * self.tol)
+            if self.value_size == 4:
+                a = a.astype(np.float32)
+        else:
+            a = words.view(np.float32 if self.word_size == 4 else np.float64).copy()
+        return a if self.ny == 1 else a.reshape(self.ny, self.nx)
+
+
+def read_bin(path):
+    """Amplitudes de frames.bin (FrameFile.h) como arreglo (frames, ny*nx), para --check."""
+    head = np.fromfile(path, dtype=np.uint8, count=64)
+    if head[:8].tobytes() != b"WAVEFRM1":
+        raise ValueError(f"{path} no es un archivo de frames")
+    elem_size, nx, ny = (int(v) for v in head[12:24].view("<u4"))
+    rec = int(head[24:32].view("<u8")[0])
+    raw = np.fromfile(path, dtype=np.uint8, offset=64)
+    count = raw.size // rec
+    data = raw[:count * rec].reshape(count, rec)[:, 32:]
+    return np.ascontiguousarray(data).view("<f4" if elem_size == 4 else "<f8").reshape(count, ny * nx)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("path")
+    ap.add_argument("--check", metavar="frames.bin",
+                    help="compara contra frames.bin de la misma corrida")
+    args = ap.parse_args()
+
+    fr = CompressedFrames(args.path)
+    mode = "sin perdida" if fr.tol == 0 else "tol %g" % fr.tol
+    print("# %s: %dx%d, %d frames, %s, clave cada %d" % (args.path, fr.nx, fr.ny, len(fr), mode, fr.keyframe))
+    ref = None
+    if args.check:
+        ref = read_bin(args.check)
+        if len(ref) != len(fr):
+            sys.exit("distinta cantidad de frames: %d contra %d" % (len(fr), len(ref)))
+    worst = 0.0
+    for k in range(len(fr)):
+        a = fr[k]
+        line = "%d\t%d\t%.6f\t%s\t%.6e" % (k, fr.step(k), fr.time(k), "delta" if fr.index[k][3] else "clave",
+                                          float(np.abs(a).max()))
+        if ref is not None:
+            err = float(np.abs(a.astype(np.float64).ravel() - ref[k].astype(np.float64)).max())
+            worst = max(worst, err)
+            line += "\t%.3e" % err
+        print(line)
+    if ref is not None:
+        print("# error maximo contra %s: %.3e" % (args.check, worst))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""
+Genera un archivo de barrido para --ensemble (Ensemble.h): el producto
+cartesiano de los valores dados, una fila por miembro. Las columnas que no se
+pasan toman en la simulacion el valor de la linea de comandos.
+
+Uso:
+  python3 scripts/make_sweep.py --D 0.05 0.1 0.2 --gamma 0.001 0.01 \
+      --omega-sigma 0 1 > results/sweep.txt
+  python3 scripts/make_sweep.py --D 0.05:0.2:16 --seed 1 > results/sweep.txt
+
+Un valor a:b:n es un rango lineal de n puntos entre a y b. Con --seed s cada
+miembro recibe la semilla s, s+1, ... (ruido reproducible).
+"""
+
+import argparse, itertools, sys
+
+COLUMNS = ["D", "gamma", "S0", "omega", "omega_mu", "omega_sigma"]
+
+
+def values(specs):
+    out = []
+    for s in specs:
+        if ":" in s:
+            a, b, n = s.split(":")
+            a, b, n = float(a), float(b), int(n)
+            out += [a + (b - a) * k / max(n - 1, 1) for k in range(n)]
+        else:
+            out.append(float(s))
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    for c in COLUMNS:
+        ap.add_argument("--" + c.replace("_", "-"), dest=c, nargs="+", metavar="v")
+    ap.add_argument("--seed", type=int, help="semilla del primer miembro")
+    args = ap.parse_args()
+
+    cols = [c for c in COLUMNS if getattr(args, c)]
+    if not cols:
+        ap.error("hace falta al menos una columna")
+    grids = [values(getattr(args, c)) for c in cols]
+    header = cols + (["seed"] if args.seed is not None else [])
+    w = sys.stdout
+    w.write("# " + " x ".join(f"{c}[{len(g)}]" for c, g in zip(cols, grids)) + "\n")
+    w.write(" ".join(header) + "\n")
+    for k, row in enumerate(itertools.product(*grids)):
+        fields = [f"{v:.12g}" for v in row]
+        if args.seed is not None:
+            fields.append(str(args.seed + k))
+        w.write(" ".join(fields) + "\n")
+
+
+if __name__ == "__main__":
+    main()
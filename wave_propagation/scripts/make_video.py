@@ -1,7 +1,7 @@
 import argparse
 import sys
 from pathlib import Path
-from typing import Iterable, List, Optional
+from typing import Callable, Iterable, List, Optional
 
 import imageio.v2 as imageio
 import matplotlib
@@ -14,6 +14,12 @@ import numpy as np
 from matplotlib import cm
 from matplotlib.colors import Normalize
 
+# frames.wfz (--frame-format compressed): el decodificador esta al lado
+try:
+    from frame_codec import CompressedFrames
+except ImportError:   # importado como scripts.make_video
+    from scripts.frame_codec import CompressedFrames
+
 # Intentar importar tqdm
 try:
     from tqdm import tqdm
@@ -32,8 +38,69 @@ plt.rcParams.update({
 })
 
 
+class BinaryFrames:
+    """Frames de ``frames.bin`` (ver FrameFile.h) mapeados con ``numpy.memmap``.
+
+    No lee nada hasta que se indexa: ``frames[k]`` devuelve la matriz del frame
+    ``k`` (vector en 1D) como vista sobre el archivo.
+    """
+
+    MAGIC = b"WAVEFRM1"
+    HEADER_BYTES = 64
+
+    def __init__(self, path: Path):
+        self.path = Path(path)
+        head = np.fromfile(self.path, dtype=np.uint8, count=self.HEADER_BYTES)
+        if head.size < self.HEADER_BYTES or head[:8].tobytes() != self.MAGIC:
+            raise ValueError(f"{self.path.name} no es un archivo de frames")
+        version, elem_size, nx, ny = head[8:24].view("<u4")
+        record_bytes = int(head[24:32].view("<u8")[0])
+        if version != 1:
+            raise ValueError(f"version de frames no soportada: {version}")
+        self.nx, self.ny = int(nx), int(ny)
+        value = "<f4" if elem_size == 4 else "<f8"
+        self.record = np.dtype([
+            ("step", "<i8"),
+            ("time", "<f8"),
+            ("nx", "<u4"),
+            ("ny", "<u4"),
+            ("reserved", "<u8"),
+            ("data", value, (self.ny, self.nx)),
+        ])
+        if self.record.itemsize != record_bytes:
+            raise ValueError("tamano de registro inconsistente")
+        # un frame incompleto al final (escritura cortada) se ignora
+        count = (self.path.stat().st_size - self.HEADER_BYTES) // record_bytes
+        self.frames = np.memmap(self.path, dtype=self.record, mode="r",
+                                offset=self.HEADER_BYTES, shape=(int(count),))
+
+    def __len__(self) -> int:
+        return len(self.frames)
+
+    def __getitem__(self, k: int) -> np.ndarray:
+        data = self.frames[k]["data"]
+        return data[0] if self.ny == 1 else data
+
+    def step(self, k: int) -> int:
+        return int(self.frames[k]["step"])
+
+    @property
+    def is_1d(self) -> bool:
+        return self.ny == 1
+
+
 class FrameLoader:
-    """Carga robusta de frames desde texto o CSV, devolviendo ``None`` si falla."""
+    """Carga robusta de frames desde texto o CSV, devolviendo ``None`` si falla.
+
+    El formato binario (``frames.bin``) o comprimido (``frames.wfz``) se abre
+    con :meth:`open_binary`.
+    """
+
+    @staticmethod
+    def open_binary(path: Path):
+        if Path(path).suffix == ".wfz":
+            return CompressedFrames(path)
+        return BinaryFrames(path)
 
     @staticmethod
     def load(path: Path) -> Optional[np.ndarray]:
@@ -308,7 +375,7 @@ class Renderer3D(Renderer):
         return img
 
 
-def analyze_data(files: Iterable[Path]):
+def analyze_data(frames: Iterable[Callable[[], Optional[np.ndarray]]]):
     """
     Escaneo global para obtener min/max y un bounding box aproximado.
     Para 3D usamos principalmente min/max globales; el recorte fino se
@@ -321,8 +388,8 @@ def analyze_data(files: Iterable[Path]):
     has_activity = False
     threshold = 0.01
 
-    for fp in tqdm(list(files), desc="Escaneando"):
-        d = FrameLoader.load(fp)
+    for load in tqdm(list(frames), desc="Escaneando"):
+        d = load()
         if d is None or d.size == 0:
             continue
 
@@ -361,9 +428,10 @@ def analyze_data(files: Iterable[Path]):
 
 def main():
     p = argparse.ArgumentParser(
-        description="Genera videos 1D o 2D a partir de archivos amp_t*.txt/csv."
+        description="Genera videos 1D o 2D a partir de frames.bin, frames.wfz o de archivos amp_t*.txt/csv."
     )
-    p.add_argument("folder", type=Path, help="Carpeta con los archivos amp_t*.txt/csv")
+    p.add_argument("folder", type=Path,
+                   help="Carpeta con frames.bin/frames.wfz o con los archivos amp_t*.txt/csv (o el .bin/.wfz directamente)")
     p.add_argument(
         "--outdir", type=Path, default=Path("videos"), help="Directorio de salida"
     )
@@ -424,13 +492,28 @@ def main():
     if not args.folder.exists():
         sys.exit("Carpeta no encontrada")
 
-    files = sorted(args.folder.glob("amp_t*.*"))
-    if not files:
-        sys.exit("No hay archivos de datos")
+    # formato binario (un archivo, acceso por memmap), comprimido o un archivo de texto por frame
+    binary = args.folder if args.folder.is_file() else args.folder / "frames.bin"
+    if not binary.exists() and args.folder.is_dir():
+        binary = args.folder / "frames.wfz"
+    if binary.exists():
+        bf = FrameLoader.open_binary(binary)
+        if len(bf) == 0:
+            sys.exit("No hay frames en " + str(binary))
+        names = [f"frame {k} (paso {bf.step(k)})" for k in range(len(bf))]
+        loaders = [lambda k=k: np.asarray(bf[k]) for k in range(len(bf))]
+        detected = "1d" if bf.is_1d else "2d"
+    else:
+        files = sorted(args.folder.glob("amp_t*.*"))
+        if not files:
+            sys.exit("No hay archivos de datos")
+        names = [fp.name for fp in files]
+        loaders = [lambda fp=fp: FrameLoader.load(fp) for fp in files]
+        detected = FrameLoader.detect_mode(files) if args.mode == "auto" else args.mode
 
-    mode = FrameLoader.detect_mode(files) if args.mode == "auto" else args.mode
+    mode = detected if args.mode == "auto" else args.mode
 
-    z_lims, xy_lims = analyze_data(files)
+    z_lims, xy_lims = analyze_data(loaders)
     if mode == "1d":
         renderer = Renderer1D(args, z_lims, xy_lims)
     else:
@@ -440,10 +523,10 @@ def main():
     out = args.outdir / f"video_{mode}.{args.format}"
 
     with imageio.get_writer(out, fps=args.fps, macro_block_size=None) as w:
-        for i, fp in enumerate(tqdm(files, desc="Renderizando"), start=1):
-            frame = renderer.render(FrameLoader.load(fp), i, len(files))
+        for i, (name, load) in enumerate(tqdm(list(zip(names, loaders)), desc="Renderizando"), start=1):
+            frame = renderer.render(load(), i, len(loaders))
             if frame is None:
-                print(f"[Aviso] Frame {fp.name} omitido por datos vacíos o inválidos")
+                print(f"[Aviso] Frame {name} omitido por datos vacíos o inválidos")
                 continue
             w.append_data(frame)
 
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""
+Lee los observables en linea (--observe, --probe; Observables.h) de
+results/observables/<nombre>.bin.
+
+Uso:
+  python3 scripts/read_observables.py results/observables/max.bin
+  python3 scripts/read_observables.py results/observables/probes.bin --tsv > probes.tsv
+
+Como modulo: read(path) devuelve (columnas, filas), una lista de tuplas de
+float. Con numpy instalado, read_array(path) devuelve un arreglo (filas, ncols).
+"""
+
+import argparse, struct, sys
+
+MAGIC = b"WAVEOBS1"
+HEADER = 64
+NAME = 16
+
+
+def read_header(data):
+    if data[:8] != MAGIC:
+        raise ValueError("no es un archivo de observables")
+    version, ncols = struct.unpack_from("<II", data, 8)
+    if version != 1:
+        raise ValueError("version de formato desconocida: %d" % version)
+    cols = []
+    for c in range(ncols):
+        raw = data[HEADER + NAME * c: HEADER + NAME * (c + 1)]
+        cols.append(raw.split(b"\0", 1)[0].decode("ascii"))
+    return cols, HEADER + NAME * ncols
+
+
+def read(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    cols, off = read_header(data)
+    rec = 8 * len(cols)
+    n = (len(data) - off) // rec   # un registro incompleto al final se ignora
+    fmt = "<%dd" % len(cols)
+    rows = [struct.unpack_from(fmt, data, off + rec * k) for k in range(n)]
+    return cols, rows
+
+
+def read_array(path):
+    import numpy as np
+    with open(path, "rb") as f:
+        data = f.read()
+    cols, off = read_header(data)
+    n = (len(data) - off) // (8 * len(cols))
+    a = np.frombuffer(data, dtype="<f8", count=n * len(cols), offset=off)
+    return cols, a.reshape(n, len(cols))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("path")
+    ap.add_argument("--tsv", action="store_true", help="todas las filas separadas por tabuladores")
+    args = ap.parse_args()
+
+    cols, rows = read(args.path)
+    if args.tsv:
+        print("\t".join(cols))
+        for r in rows:
+            print("\t".join(repr(v) for v in r))
+        return
+    print("%s: %d registros, columnas: %s" % (args.path, len(rows), " ".join(cols)))
+    for r in rows[:5] + ([None] if len(rows) > 10 else []) + rows[max(5, len(rows) - 5):]:
+        print("  ..." if r is None else "  " + "  ".join("%.6g" % v for v in r))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
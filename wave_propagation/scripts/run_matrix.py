@@ -52,6 +52,12 @@ chunks_by_threads = {
 
 threads_list = [1, 2, 4, 8]
 
+# PERF_COUNTERS=1: una corrida extra por configuracion con --perf-counters
+# (fuera de las medidas de tiempo) que agrega filas a results/perf_counters.csv
+PERF_COUNTERS = os.environ.get("PERF_COUNTERS", "0") == "1"
+# PROFILE=1: idem con --profile (computo/espera por fase en results/profile_summary.csv)
+PROFILE = os.environ.get("PROFILE", "0") == "1"
+
 # Warm-up y repeticiones
 WARMUP  = 1
 REPEATS = 5
@@ -162,6 +168,10 @@ def main():
                         times.append(run_once(args))
 
                     t_final = aggregate(times, AGGREGATOR)
+                    if PERF_COUNTERS:
+                        run_once(args + ["--perf-counters"])
+                    if PROFILE:
+                        run_once(args + ["--profile", "--profile-steps", "0"])
 
                     append_row(CSV_PATH, [
                         kind, size_str(kind, dims), schedule, str(chunk), p, st, f"{t_final:.6f}"
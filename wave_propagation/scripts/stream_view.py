@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""
+Lector de la transmision en vivo (--stream <nombre>; FrameStream.h): mapea
+/dev/shm/<nombre> y sigue los frames a medida que el simulador los publica,
+sin copiar ni escribir a disco. Si el lector se atrasa mas que el anillo
+(--stream-slots frames), los frames intermedios se pierden y se cuentan.
+
+Uso:
+  ./wave_propagation --network 2d --Lx 1000 --Ly 1000 --steps 1000000 --stream wave &
+  python3 scripts/stream_view.py wave              # una linea por frame recibido
+  python3 scripts/stream_view.py wave --plot       # imagen en vivo (numpy + matplotlib)
+
+Como modulo: StreamReader(nombre).next() devuelve (frame, step, time, datos)
+o None. Con numpy, datos es un ndarray que apunta al segmento (sin copia;
+valid(frame) dice si el simulador ya reescribio ese slot); sin numpy es un
+memoryview. next(copy=True) devuelve una copia ya validada.
+"""
+
+import argparse, mmap, os, struct, sys, time
+
+MAGIC = b"WAVESHM1"
+HEADER = 128
+SLOT_HEADER = 64
+# magic, version, elem_size, nx, ny, slots, state, slot_bytes, data_offset, published, pid
+HEADER_FMT = "=8sIIIIIIQQQq"
+OFF_STATE = 28
+OFF_PUBLISHED = 48
+
+
+class StreamReader:
+    def __init__(self, name, wait=10.0):
+        path = "/dev/shm/" + name.lstrip("/")
+        t0 = time.time()
+        while True:
+            try:
+                with open(path, "rb") as f:
+                    self.mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+                if len(self.mm) >= HEADER and self.mm[:8] == MAGIC:
+                    break
+                self.mm.close()
+            except (FileNotFoundError, ValueError):
+                pass
+            if time.time() - t0 > wait:
+                raise RuntimeError("no hay stream en %s" % path)
+            time.sleep(0.05)
+        (_, version, self.elem_size, self.nx, self.ny, self.slots, _,
+         self.slot_bytes, self.data_offset, _, self.pid) = struct.unpack_from(HEADER_FMT, self.mm, 0)
+        if version != 1:
+            raise ValueError("version de formato desconocida: %d" % version)
+        self.count = self.nx * self.ny
+        self.next_frame = 0   # primer frame que todavia no se entrego
+        self.lost = 0         # frames que el anillo piso antes de leerlos
+        try:
+            import numpy as np
+            self.np = np
+            self.dtype = np.float32 if self.elem_size == 4 else np.float64
+        except ImportError:
+            self.np = None
+
+    def published(self):
+        return struct.unpack_from("=Q", self.mm, OFF_PUBLISHED)[0]
+
+    def finished(self):
+        return struct.unpack_from("=I", self.mm, OFF_STATE)[0] == 1
+
+    def _slot(self, f):
+        return self.data_offset + (f % self.slots) * self.slot_bytes
+
+    def valid(self, f):
+        # seq = 2f+2: el frame f esta completo y el slot no se reescribio
+        return struct.unpack_from("=Q", self.mm, self._slot(f))[0] == 2 * f + 2
+
+    def _data(self, f):
+        off = self._slot(f) + SLOT_HEADER
+        if self.np is not None:
+            a = self.np.frombuffer(self.mm, dtype=self.dtype, count=self.count, offset=off)
+            return a.reshape(self.ny, self.nx) if self.ny > 1 else a
+        return memoryview(self.mm)[off:off + self.count * self.elem_size].cast("f" if self.elem_size == 4 else "d")
+
+    def next(self, copy=False, latest=False):
+        """Frame siguiente (o el ultimo publicado con latest=True); None si no hay uno nuevo."""
+        pub = self.published()
+        if pub == 0 or pub <= self.next_frame:
+            return None
+        f = pub - 1 if latest else max(self.next_frame, pub - self.slots)
+        while f < pub:
+            if self.valid(f):
+                step, t, frame = struct.unpack_from("=qdQ", self.mm, self._slot(f) + 8)
+                data = self._data(f)
+                if copy:
+                    data = data.copy() if self.np is not None else data.tolist()
+                if frame == f and self.valid(f):
+                    self.lost += f - self.next_frame
+                    self.next_frame = f + 1
+                    return f, step, t, data
+            f += 1   # el slot se reescribio mientras tanto: se prueba el siguiente
+        return None
+
+    def close(self):
+        self.mm.close()
+
+
+def stats(data, np):
+    if np is not None:
+        a = np.asarray(data, dtype=np.float64)
+        return float(np.abs(a).max()), float(np.dot(a.ravel(), a.ravel()))
+    m = e = 0.0
+    for v in data:
+        m = max(m, abs(v))
+        e += v * v
+    return m, e
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("name", help="nombre pasado a --stream")
+    ap.add_argument("--plot", action="store_true", help="imagen en vivo del ultimo frame (numpy + matplotlib)")
+    ap.add_argument("--count", type=int, default=0, help="termina tras recibir n frames (0 = hasta el final de la corrida)")
+    ap.add_argument("--poll", type=float, default=0.005, help="segundos entre consultas sin frame nuevo")
+    ap.add_argument("--wait", type=float, default=10.0, help="segundos de espera a que aparezca el stream")
+    args = ap.parse_args()
+
+    r = StreamReader(args.name, args.wait)
+    print("# stream %s: %dx%d float%d, %d slots, pid %d" % (args.name, r.nx, r.ny, 8 * r.elem_size, r.slots, r.pid))
+    img = None
+    if args.plot:
+        if r.np is None:
+            sys.exit("--plot necesita numpy")
+        import matplotlib.pyplot as plt
+        plt.ion()
+        fig, ax = plt.subplots()
+    got = 0
+    while not args.count or got < args.count:
+        # en modo grafico solo interesa el ultimo frame
+        item = r.next(copy=True, latest=args.plot)
+        if item is None:
+            if r.finished() and r.published() <= r.next_frame:
+                break
+            if args.plot:
+                plt.pause(args.poll)
+            else:
+                time.sleep(args.poll)
+            continue
+        f, step, t, data = item
+        got += 1
+        m, e = stats(data, r.np)
+        if args.plot:
+            a = data if r.ny > 1 else data.reshape(1, -1)
+            if img is None:
+                img = ax.imshow(a, cmap="RdBu_r", vmin=-m, vmax=m, aspect="auto")
+                fig.colorbar(img, ax=ax)
+            else:
+                img.set_data(a)
+                img.set_clim(-m, m)
+            ax.set_title("paso %d  t=%.3f" % (step, t))
+            plt.pause(0.001)
+        else:
+            print("%d\t%d\t%.6f\t%.6e\t%.6e\t%d" % (f, step, t, m, e, r.lost))
+            sys.stdout.flush()
+    print("# recibidos %d, perdidos %d" % (got, r.lost))
+    r.close()
+
+
+if __name__ == "__main__":
+    main()
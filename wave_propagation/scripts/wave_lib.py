@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+"""
+Simulacion en el mismo proceso con libwave.so (make lib; API C de WaveApi.h)
+por ctypes: la red se construye una vez y se avanza, reinicia y lee sin
+lanzar el ejecutable ni pasar por archivos.
+
+Uso:
+  make lib
+  python3 scripts/wave_lib.py --network 2d --Lx 300 --Ly 300 --steps 500   # demo: energia cada 100 pasos
+
+Como modulo:
+  sim = WaveSim(["--network", "2d", "--Lx", "300", "--Ly", "300", "--threads", "4"])
+  sim.on_step(lambda s, step: print(step, s.energy), every=100)
+  sim.step(1000)
+  a = sim.amplitudes()      # ndarray (ny, nx) sin copia; valida hasta el proximo step/reset
+  sim.reset()               # estado inicial, misma red
+
+Las opciones son las del ejecutable; una opcion invalida (o --help) da
+RuntimeError con el mensaje de wave_last_error(). Con
+numpy, amplitudes() y energies() apuntan a la memoria de la simulacion; sin
+numpy devuelven memoryview. WAVE_LIB=<ruta> elige otra biblioteca.
+"""
+
+import argparse, ctypes, os, sys
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parents[1]
+
+STEP_FN = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.c_long, ctypes.c_void_p)
+API_VERSION = 1
+
+
+def load_library(path=None):
+    path = path or os.environ.get("WAVE_LIB") or str(ROOT / "libwave.so")
+    lib = ctypes.CDLL(path)
+    c_size_p = ctypes.POINTER(ctypes.c_size_t)
+    sigs = {
+        "wave_api_version": (ctypes.c_int, []),
+        "wave_last_error": (ctypes.c_char_p, []),
+        "wave_create": (ctypes.c_void_p, [ctypes.c_int, ctypes.POINTER(ctypes.c_char_p)]),
+        "wave_destroy": (None, [ctypes.c_void_p]),
+        "wave_step": (ctypes.c_int, [ctypes.c_void_p, ctypes.c_long]),
+        "wave_reset": (ctypes.c_int, [ctypes.c_void_p]),
+        "wave_on_step": (ctypes.c_int, [ctypes.c_void_p, STEP_FN, ctypes.c_void_p, ctypes.c_int]),
+        "wave_remove_callback": (ctypes.c_int, [ctypes.c_void_p, ctypes.c_int]),
+        "wave_steps_done": (ctypes.c_long, [ctypes.c_void_p]),
+        "wave_time": (ctypes.c_double, [ctypes.c_void_p]),
+        "wave_energy": (ctypes.c_double, [ctypes.c_void_p]),
+        "wave_energies": (ctypes.POINTER(ctypes.c_double), [ctypes.c_void_p, c_size_p]),
+        "wave_shape": (None, [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]),
+        "wave_elem_size": (ctypes.c_int, [ctypes.c_void_p]),
+        "wave_amplitudes": (ctypes.c_void_p, [ctypes.c_void_p, c_size_p]),
+        "wave_original_ids": (ctypes.POINTER(ctypes.c_int), [ctypes.c_void_p, c_size_p]),
+    }
+    for name, (res, args) in sigs.items():
+        fn = getattr(lib, name)
+        fn.restype = res
+        fn.argtypes = args
+    if lib.wave_api_version() != API_VERSION:
+        raise RuntimeError("version de la API distinta: %d" % lib.wave_api_version())
+    return lib
+
+
+class WaveSim:
+    def __init__(self, args, lib=None):
+        self.lib = lib or load_library()
+        argv = (ctypes.c_char_p * len(args))(*[str(a).encode() for a in args])
+        self.h = self.lib.wave_create(len(args), argv)
+        if not self.h:
+            raise RuntimeError(self._error())
+        nx, ny = ctypes.c_int(), ctypes.c_int()
+        self.lib.wave_shape(self.h, ctypes.byref(nx), ctypes.byref(ny))
+        self.nx, self.ny = nx.value, ny.value
+        self._callbacks = {}   # id -> CFUNCTYPE (referencia viva mientras este registrado)
+        try:
+            import numpy as np
+            self.np = np
+        except ImportError:
+            self.np = None
+
+    def _error(self):
+        return self.lib.wave_last_error().decode(errors="replace")
+
+    def _check(self, rc):
+        if rc != 0:
+            raise RuntimeError(self._error())
+
+    def step(self, n=1):
+        self._check(self.lib.wave_step(self.h, n))
+
+    def reset(self):
+        self._check(self.lib.wave_reset(self.h))
+
+    def on_step(self, fn, every=1):
+        """fn(sim, step) despues de cada paso multiplo de every; devuelve el id."""
+        cb = STEP_FN(lambda _h, step, _u: fn(self, step))
+        cid = self.lib.wave_on_step(self.h, cb, None, every)
+        if cid < 0:
+            raise RuntimeError(self._error())
+        self._callbacks[cid] = cb
+        return cid
+
+    def remove_callback(self, cid):
+        self._check(self.lib.wave_remove_callback(self.h, cid))
+        self._callbacks.pop(cid, None)
+
+    @property
+    def steps_done(self):
+        return self.lib.wave_steps_done(self.h)
+
+    @property
+    def time(self):
+        return self.lib.wave_time(self.h)
+
+    @property
+    def energy(self):
+        return self.lib.wave_energy(self.h)
+
+    def _view(self, ptr, n, ctype, fmt):
+        if n == 0 or not ptr:
+            return self.np.empty(0) if self.np is not None else memoryview(b"").cast(fmt)
+        arr = ctypes.cast(ptr, ctypes.POINTER(ctype * n)).contents
+        if self.np is not None:
+            return self.np.ctypeslib.as_array(arr)
+        return memoryview(arr).cast("B").cast(fmt)
+
+    def energies(self):
+        """Energia de cada paso del ultimo step() (sin copia)."""
+        n = ctypes.c_size_t()
+        ptr = self.lib.wave_energies(self.h, ctypes.byref(n))
+        return self._view(ptr, n.value, ctypes.c_double, "d")
+
+    def amplitudes(self):
+        """Estado confirmado sin copia: (ny, nx) en 2D, vector en 1D/grafo."""
+        n = ctypes.c_size_t()
+        ptr = self.lib.wave_amplitudes(self.h, ctypes.byref(n))
+        f32 = self.lib.wave_elem_size(self.h) == 4
+        a = self._view(ptr, n.value, ctypes.c_float if f32 else ctypes.c_double, "f" if f32 else "d")
+        if self.np is None:
+            return a.toreadonly()
+        if self.ny > 1:
+            a = a.reshape(self.ny, self.nx)
+        a.flags.writeable = False
+        return a
+
+    def original_ids(self):
+        n = ctypes.c_size_t()
+        ptr = self.lib.wave_original_ids(self.h, ctypes.byref(n))
+        return self._view(ptr, n.value, ctypes.c_int, "i")
+
+    def close(self):
+        if getattr(self, "h", None):
+            self.lib.wave_destroy(self.h)
+            self.h = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--every", type=int, default=100, help="pasos entre lineas")
+    ap.add_argument("--lib", help="ruta a libwave.so")
+    args, rest = ap.parse_known_args()
+    steps = 200
+    if "--steps" in rest:
+        k = rest.index("--steps")
+        steps = int(rest[k + 1])
+        del rest[k:k + 2]
+
+    with WaveSim(rest, load_library(args.lib)) as sim:
+        print("# red %dx%d, %d pasos" % (sim.nx, sim.ny, steps))
+        sim.on_step(lambda s, step: print("%d\t%.6f\t%.12g" % (step, s.time, s.energy)), args.every)
+        sim.step(steps)
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()